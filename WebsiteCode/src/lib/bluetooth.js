@@ -6,8 +6,14 @@
 // Automatically saves received data to IndexedDB for persistence.
 // ===========================================
 
-import { parseLiveData, parseHourlyData, parseDailyData } from './parser.js';
-import { setState } from './state.js';
+import {
+  parseLiveData, parseLiveBatch, isLiveBatch, parseLiveTlvFrame, isLiveTlvFrame,
+  parseWaveformPacket, parseHourlyData, parseDailyData, parseDeltaSyncPacket,
+  parseCapabilities, buildFieldMask, parseOfflineDrainPacket, parseTunables,
+  buildTunableCommands, HISTORY_COMPRESS_LZ, parseStats, parseBroadcast,
+  BROADCAST_COMPANY_ID, parseTimeSyncRequest, buildTimeSyncReply,
+} from './parser.js';
+import { state, setState } from './state.js';
 import { saveReading, saveHourlySummaries, getTodayDate } from './storage.js';
 
 // BLE Service and Characteristic UUIDs (must match ESP32 DeviceCode.cpp)
@@ -17,6 +23,14 @@ const CHAR_LIVE_UUID = '0000ff01-0000-1000-8000-00805f9b34fb';  // Real-time not
 const CHAR_TODAY_UUID = '0000ff02-0000-1000-8000-00805f9b34fb';  // 24-hour history (240 bytes)
 const CHAR_WEEK_UUID = '0000ff03-0000-1000-8000-00805f9b34fb';   // 7-day summaries (70 bytes)
 const CHAR_COMMAND_UUID = '0000ff04-0000-1000-8000-00805f9b34fb'; // App control commands (write-only)
+const CHAR_WAVE_UUID = '0000ff05-0000-1000-8000-00805f9b34fb';    // Raw IR/GSR waveform stream (notify)
+const CHAR_SYNC_UUID = '0000ff06-0000-1000-8000-00805f9b34fb';    // Incremental history sync (notify)
+const CHAR_CAPS_UUID = '0000ff07-0000-1000-8000-00805f9b34fb';    // Protocol capabilities (read-only)
+const CHAR_TUNE_UUID = '0000ff08-0000-1000-8000-00805f9b34fb';    // Runtime tunables (read-only)
+const CHAR_STATS_UUID = '0000ff09-0000-1000-8000-00805f9b34fb';   // Device counters (read-only)
+
+// Give up on a delta sync if the end packet hasn't arrived by then
+const DELTA_SYNC_TIMEOUT_MS = 10000;
 
 // Connection state (managed internally, not exposed)
 let device = null;        // BluetoothDevice instance
@@ -26,10 +40,14 @@ let liveChar = null;      // Live data characteristic (notifications)
 let todayChar = null;     // Today's history characteristic (read)
 let weekChar = null;      // Week summaries characteristic (read)
 let commandChar = null;   // Command characteristic (write)
+let waveChar = null;      // Waveform characteristic (notifications, optional)
+let syncChar = null;      // Sync characteristic (delta sync + offline drain, optional)
 
 // Event callbacks (set by app code)
 let onDataCallback = null;        // Called when live data notification received
 let onDisconnectCallback = null;   // Called when device disconnects
+let onWaveformCallback = null;     // Called with each decoded waveform packet
+let lastWaveSequence = {};         // Last sequence number per stream (drop detection)
 
 /**
  * Check if Web Bluetooth is supported
@@ -97,6 +115,9 @@ export async function connect() {
     weekChar = await service.getCharacteristic(CHAR_WEEK_UUID);
     commandChar = await service.getCharacteristic(CHAR_COMMAND_UUID);
     console.log('Got all characteristics');
+
+    // Sync characteristic is optional (older firmware doesn't have it)
+    syncChar = await service.getCharacteristic(CHAR_SYNC_UUID).catch(() => null);
     
     // Update app state to reflect connection
     setState({ connected: true, device: device.name });
@@ -144,6 +165,13 @@ export async function subscribe(callback) {
   // Listen for incoming notification events
   liveChar.addEventListener('characteristicvaluechanged', handleLiveData);
   console.log('Subscribed to live data');
+
+  // Device drains samples buffered while disconnected over the Sync characteristic
+  if (syncChar) {
+    await syncChar.startNotifications();
+    syncChar.addEventListener('characteristicvaluechanged', handleOfflineData);
+    syncChar.addEventListener('characteristicvaluechanged', handleTimeSyncRequest);
+  }
 }
 
 /**
@@ -161,6 +189,45 @@ export async function unsubscribe() {
   onDataCallback = null;
 }
 
+/**
+ * Subscribe to raw IR/GSR waveform stream.
+ * The device only samples into the stream while notifications are enabled,
+ * so this should be stopped as soon as the waveform view is closed.
+ * 
+ * @param {Function} callback - Called with { stream, sequence, intervalMs, samples, dropped }
+ * @returns {Promise<void>}
+ * @throws {Error} If not connected or firmware has no waveform characteristic
+ */
+export async function subscribeWaveform(callback) {
+  if (!service) {
+    throw new Error('Not connected');
+  }
+
+  // Looked up lazily so older firmware without the characteristic still connects
+  waveChar = await service.getCharacteristic(CHAR_WAVE_UUID);
+  onWaveformCallback = callback;
+  lastWaveSequence = {};
+
+  await waveChar.startNotifications();
+  waveChar.addEventListener('characteristicvaluechanged', handleWaveform);
+  console.log('Subscribed to waveform stream');
+}
+
+/**
+ * Unsubscribe from waveform stream (device stops sampling into it)
+ */
+export async function unsubscribeWaveform() {
+  if (waveChar) {
+    try {
+      waveChar.removeEventListener('characteristicvaluechanged', handleWaveform);
+      await waveChar.stopNotifications();
+    } catch (e) {
+      // Ignore errors during cleanup
+    }
+  }
+  onWaveformCallback = null;
+}
+
 /**
  * Read today's hourly data from device.
  * Device packs 24 hourly summaries into 240 bytes (10 bytes per hour).
@@ -226,6 +293,98 @@ export async function readHistory() {
   }
 }
 
+/**
+ * Incrementally sync history using record sequence numbers.
+ * Sends the last-seen sequence (command 0x04) and merges only the records
+ * that changed since then into the current history. Asks for LZ-compressed
+ * records when the firmware supports them. Falls back to a full
+ * readHistory() on firmware without the Sync characteristic.
+ * 
+ * @returns {Promise<Object>} { today: Array, week: Array }
+ * @throws {Error} If not connected or the sync times out
+ */
+export async function readHistoryDelta() {
+  if (!service || !commandChar) {
+    throw new Error('Not connected');
+  }
+
+  if (!syncChar) {
+    return readHistory();
+  }
+
+  // A sequence baseline is only meaningful if we still hold the full history it refers to
+  const seqKey = `stressview-sync-seq-${device.name}`;
+  const haveHistory = state.todayData.length === 24 && state.weekData.length === 7;
+  const lastSeq = haveHistory ? Number(localStorage.getItem(seqKey) ?? 0) : 0;
+
+  const today = haveHistory ? [...state.todayData] : new Array(24).fill(null);
+  const week = haveHistory ? [...state.weekData] : new Array(7).fill(null);
+
+  const caps = await readCapabilities();
+  const compress = caps?.compression.includes(HISTORY_COMPRESS_LZ) ?? false;
+
+  await syncChar.startNotifications();
+
+  const latestSeq = await new Promise((resolve, reject) => {
+    const timeout = setTimeout(() => {
+      finish();
+      reject(new Error('Delta sync timed out'));
+    }, DELTA_SYNC_TIMEOUT_MS);
+
+    function finish() {
+      clearTimeout(timeout);
+      syncChar.removeEventListener('characteristicvaluechanged', handlePacket);
+    }
+
+    function handlePacket(event) {
+      try {
+        const packet = parseDeltaSyncPacket(event.target.value);
+        if (!packet) return;  // Offline drain or time sync packet
+
+        if (packet.end) {
+          finish();
+          resolve(packet.latestSeq);
+          return;
+        }
+
+        for (const { kind, record } of packet.records) {
+          if (kind === 'hour') today[record.hour] = record;
+          else week[record.dayIndex] = record;
+        }
+      } catch (error) {
+        finish();
+        reject(error);
+      }
+    }
+
+    syncChar.addEventListener('characteristicvaluechanged', handlePacket);
+
+    // Command: [0x04, seq (32-bit LE)], plus [fixed encoding, LZ] when compressing
+    const command = new Uint8Array(compress ? 7 : 5);
+    command[0] = 0x04;
+    new DataView(command.buffer).setUint32(1, lastSeq, true);
+    if (compress) command[6] = HISTORY_COMPRESS_LZ;
+    commandChar.writeValue(command).catch((error) => {
+      finish();
+      reject(error);
+    });
+  });
+
+  if (today.includes(null) || week.includes(null)) {
+    throw new Error('Delta sync incomplete');
+  }
+
+  localStorage.setItem(seqKey, String(latestSeq));
+  setState({ todayData: today, weekData: week });
+
+  const todayDate = getTodayDate();
+  saveHourlySummaries(today, todayDate).catch(err => {
+    console.warn('Failed to save hourly summaries:', err);
+  });
+
+  return { today, week };
+}
+
 /**
  * Send command to device
  * @param {number} command - Command byte (0x01=sync, 0x02=refresh)
@@ -241,10 +400,49 @@ export async function sendCommand(command) {
   console.log('Sent command:', command);
 }
 
+/**
+ * Describe the browser's time zone for command 0x0A: standard UTC offset,
+ * daylight saving amount, and the transition rule it follows (1 = EU,
+ * 2 = US). Zones with other rules are sent as the offset in effect now and
+ * corrected on the next sync.
+ * @returns {{standard: number, dst: number, rule: number}} Minutes and rule id
+ */
+function detectTimeZone() {
+  const year = new Date().getFullYear();
+  const january = -new Date(year, 0, 1).getTimezoneOffset();
+  const july = -new Date(year, 6, 1).getTimezoneOffset();
+  const standard = Math.min(january, july);
+  const dst = Math.max(january, july) - standard;
+  const offsetAt = (utcMs) => -new Date(utcMs).getTimezoneOffset();
+  const startsAt = (utcMs) => offsetAt(utcMs - 1000) === standard && offsetAt(utcMs) === standard + dst;
+
+  if (dst === 0) {
+    return { standard, dst: 0, rule: 0 };
+  }
+
+  // EU: last Sunday of March, 01:00 UTC
+  const endOfMarch = new Date(Date.UTC(year, 3, 0));
+  if (startsAt(Date.UTC(year, 2, 31 - endOfMarch.getUTCDay(), 1))) {
+    return { standard, dst, rule: 1 };
+  }
+
+  // US: second Sunday of March, 02:00 local standard time
+  const secondSunday = 8 + (7 - new Date(Date.UTC(year, 2, 1)).getUTCDay()) % 7;
+  if (startsAt(Date.UTC(year, 2, secondSunday, 2) - standard * 60000)) {
+    return { standard, dst, rule: 2 };
+  }
+
+  return { standard: -new Date().getTimezoneOffset(), dst: 0, rule: 0 };
+}
+
 /**
  * Send time synchronization to device.
- * Sends current date/time so device can track real-world time.
+ * Sends the time zone (command 0x0A) and current local date/time so device
+ * can track real-world time across daylight saving changes.
  * Format: [0x01, year_low, year_high, month, day, hour, minute, second]
+ * When the Sync characteristic is available, also starts the precise
+ * exchange (command 0x08): the device sends a few requests that are
+ * answered by handleTimeSyncRequest, and keeps the fastest round.
  * @returns {Promise<void>}
  */
 export async function syncTime() {
@@ -252,6 +450,15 @@ export async function syncTime() {
     throw new Error('Not connected');
   }
 
+  const zone = detectTimeZone();
+  await commandChar.writeValue(new Uint8Array([
+    0x0A,                    // Command: time zone
+    zone.standard & 0xFF,    // Standard offset in minutes (signed, little-endian)
+    (zone.standard >> 8) & 0xFF,
+    zone.dst,
+    zone.rule
+  ]));
+
   const now = new Date();
   const year = now.getFullYear();
   const month = now.getMonth() + 1;  // 1-12
@@ -274,6 +481,10 @@ export async function syncTime() {
 
   await commandChar.writeValue(data);
   console.log('Time synced:', year, month, day, hour, minute, second);
+
+  if (syncChar) {
+    await commandChar.writeValue(new Uint8Array([0x08]));
+  }
 }
 
 /**
@@ -290,6 +501,170 @@ export async function requestRefresh() {
   await sendCommand(0x02);
 }
 
+/**
+ * Select live notification mode.
+ * Batched mode packs several timestamped samples into each notification,
+ * giving a higher effective rate without extra notification overhead.
+ * Format: [0x03, mode, rateHz]
+ * @param {boolean} batched - true for batched samples, false for legacy 7-byte packets
+ * @param {number} rateHz - Effective sample rate in batched mode (1-50)
+ * @returns {Promise<void>}
+ */
+export async function setLiveMode(batched, rateHz = 10) {
+  if (!commandChar) {
+    throw new Error('Not connected');
+  }
+
+  const data = new Uint8Array([0x03, batched ? 0x01 : 0x00, rateHz]);
+  await commandChar.writeValue(data);
+  console.log('Live mode set:', batched ? `batched @ ${rateHz}Hz` : 'legacy');
+}
+
+/**
+ * Read protocol capabilities (supported TLV fields, modes, rates, commands).
+ * Returns null on firmware that predates the capabilities characteristic.
+ * @returns {Promise<Object|null>} Parsed capabilities
+ */
+export async function readCapabilities() {
+  if (!service) {
+    throw new Error('Not connected');
+  }
+
+  try {
+    const capsChar = await service.getCharacteristic(CHAR_CAPS_UUID);
+    return parseCapabilities(await capsChar.readValue());
+  } catch (e) {
+    return null;
+  }
+}
+
+/**
+ * Switch live notifications to TLV frames carrying only the given fields.
+ * Sends field selection (0x05) then live mode 0x02 (0x03).
+ * Format: [0x05, liveMask (32-bit LE), historyMask (32-bit LE)]
+ * @param {Array<string>} liveFields - Live field names to receive (e.g. ['stress', 'hr'])
+ * @param {Array<string>|null} historyFields - History field names, or null for all
+ * @param {number} rateHz - Frame rate (1-50)
+ * @returns {Promise<void>}
+ */
+export async function setTlvLiveMode(liveFields, historyFields = null, rateHz = 1) {
+  if (!commandChar) {
+    throw new Error('Not connected');
+  }
+
+  const selection = new Uint8Array(9);
+  const view = new DataView(selection.buffer);
+  selection[0] = 0x05;
+  view.setUint32(1, buildFieldMask(liveFields), true);
+  view.setUint32(5, historyFields ? buildFieldMask(historyFields, true) : 0xFFFFFFFF, true);
+  await commandChar.writeValue(selection);
+
+  await commandChar.writeValue(new Uint8Array([0x03, 0x02, rateHz]));
+  console.log('TLV live mode set:', liveFields.join(', '), `@ ${rateHz}Hz`);
+}
+
+/**
+ * Read the device's runtime tunables (sample intervals, windows, thresholds)
+ * @returns {Promise<Object|null>} Parsed tunables, or null on older firmware
+ */
+export async function readTunables() {
+  if (!service) {
+    throw new Error('Not connected');
+  }
+
+  try {
+    const tuneChar = await service.getCharacteristic(CHAR_TUNE_UUID);
+    return parseTunables(await tuneChar.readValue());
+  } catch (e) {
+    return null;
+  }
+}
+
+/**
+ * Change runtime tunables. The device validates each value, applies it
+ * immediately and keeps it across reboots; out-of-range values are ignored.
+ * @param {Object} values - Tunable names to new values (e.g. { notifyPeriodMs: 2000 })
+ * @returns {Promise<Object|null>} Tunables as applied by the device
+ */
+export async function writeTunables(values) {
+  if (!commandChar) {
+    throw new Error('Not connected');
+  }
+
+  for (const packet of buildTunableCommands(values)) {
+    await commandChar.writeValue(packet);
+  }
+  return readTunables();
+}
+
+/**
+ * Restore the device's compiled-in tunable defaults (command 0x07)
+ * @returns {Promise<Object|null>} Tunables after reset
+ */
+export async function resetTunables() {
+  if (!commandChar) {
+    throw new Error('Not connected');
+  }
+
+  await commandChar.writeValue(new Uint8Array([0x07]));
+  return readTunables();
+}
+
+/**
+ * Read device counters (live notifications sent/suppressed, dropped events)
+ * @returns {Promise<Object|null>} Parsed stats, or null on older firmware
+ */
+export async function readStats() {
+  if (!service) {
+    throw new Error('Not connected');
+  }
+
+  try {
+    const statsChar = await service.getCharacteristic(CHAR_STATS_UUID);
+    return parseStats(await statsChar.readValue());
+  } catch (e) {
+    return null;
+  }
+}
+
+/**
+ * Watch nearby StressView broadcasts without connecting (gateway mode).
+ * Devices only broadcast once broadcastPeriodMs has been set via
+ * writeTunables(). Needs a browser with Web Bluetooth scanning enabled.
+ * 
+ * @param {Function} callback - Called with (deviceId, name, reading) for each new payload
+ * @returns {Promise<Function>} Call to stop scanning
+ */
+export async function watchBroadcasts(callback) {
+  if (!navigator.bluetooth?.requestLEScan) {
+    throw new Error('Bluetooth scanning is not supported in this browser');
+  }
+
+  const lastSequence = new Map();
+
+  function handleAdvertisement(event) {
+    const data = event.manufacturerData.get(BROADCAST_COMPANY_ID);
+    if (!data) return;
+
+    const reading = parseBroadcast(data);
+    if (!reading || lastSequence.get(event.device.id) === reading.sequence) return;
+
+    lastSequence.set(event.device.id, reading.sequence);
+    callback(event.device.id, event.device.name, reading);
+  }
+
+  const scan = await navigator.bluetooth.requestLEScan({
+    filters: [{ manufacturerData: [{ companyIdentifier: BROADCAST_COMPANY_ID }] }],
+    keepRepeatedDevices: true,
+  });
+  navigator.bluetooth.addEventListener('advertisementreceived', handleAdvertisement);
+
+  return () => {
+    navigator.bluetooth.removeEventListener('advertisementreceived', handleAdvertisement);
+    scan.stop();
+  };
+}
+
 /**
  * Set disconnect callback
  * @param {Function} callback
@@ -310,40 +685,126 @@ export function onDisconnect(callback) {
  * @param {Event} event - Characteristic value changed event
  */
 function handleLiveData(event) {
-  const dataView = event.target.value; // DataView of the 7-byte buffer
+  const dataView = event.target.value; // DataView of the 7-byte buffer (or batched packet)
   
   try {
-    // Parse binary data into structured object
-    const data = parseLiveData(dataView);
-    
-    // Update app state with new sensor readings
-    // Triggers reactive UI updates for all subscribed components
-    setState({
-      stress: data.stress,
-      hr: data.hr,
-      hrv: data.hrv,
-      gsr: data.gsr,
-      hrActive: data.hrActive,
-      calibrated: data.calibrated,
-    });
-
-    // Save raw reading to IndexedDB for historical analysis
-    // Don't await - let it happen async so notifications aren't blocked
-    saveReading(data).catch(err => {
-      console.warn('Failed to save reading:', err);
-      // Non-fatal - app continues to work even if save fails
-    });
+    // Batched packets carry several samples, applied in order (oldest first)
+    if (isLiveBatch(dataView)) {
+      const samples = parseLiveBatch(dataView);
+      samples.forEach(handleLiveSample);
+      return;
+    }
 
-    // Invoke user-provided callback if set (for custom handling)
-    if (onDataCallback) {
-      onDataCallback(data);
+    // TLV frames only contain the selected fields; keep previous values for the rest
+    if (isLiveTlvFrame(dataView)) {
+      handleLiveSample({ ...state, ...parseLiveTlvFrame(dataView) });
+      return;
     }
+
+    handleLiveSample(parseLiveData(dataView));
   } catch (error) {
     console.error('Error parsing live data:', error);
     // Continue processing future notifications even if one fails
   }
 }
 
+/**
+ * Apply one parsed live sample: update state, persist, and notify callback.
+ * @param {Object} data - Parsed live sample
+ */
+function handleLiveSample(data) {
+  // Update app state with new sensor readings
+  // Triggers reactive UI updates for all subscribed components
+  setState({
+    stress: data.stress,
+    hr: data.hr,
+    hrv: data.hrv,
+    gsr: data.gsr,
+    hrActive: data.hrActive,
+    calibrated: data.calibrated,
+  });
+
+  // Save raw reading to IndexedDB for historical analysis
+  // Don't await - let it happen async so notifications aren't blocked
+  saveReading(data).catch(err => {
+    console.warn('Failed to save reading:', err);
+    // Non-fatal - app continues to work even if save fails
+  });
+
+  // Invoke user-provided callback if set (for custom handling)
+  if (onDataCallback) {
+    onDataCallback(data);
+  }
+}
+
+/**
+ * Handle incoming waveform notification.
+ * Decodes the delta-encoded packet and reports how many packets were
+ * lost since the previous one on the same stream (from sequence numbers).
+ * 
+ * @param {Event} event - Characteristic value changed event
+ */
+function handleWaveform(event) {
+  try {
+    const packet = parseWaveformPacket(event.target.value);
+    const last = lastWaveSequence[packet.stream];
+
+    packet.dropped = (last === undefined) ? 0 : ((packet.sequence - last - 1) & 0xFFFF);
+    lastWaveSequence[packet.stream] = packet.sequence;
+
+    if (onWaveformCallback) {
+      onWaveformCallback(packet);
+    }
+  } catch (error) {
+    console.error('Error parsing waveform:', error);
+  }
+}
+
+/**
+ * Handle offline drain packets on the Sync characteristic.
+ * Samples are stamped with device uptime; wall-clock time is recovered
+ * from the device uptime carried in each packet. Delta sync packets on
+ * the same characteristic are ignored here.
+ * 
+ * @param {Event} event - Characteristic value changed event
+ */
+function handleOfflineData(event) {
+  try {
+    const packet = parseOfflineDrainPacket(event.target.value);
+    if (!packet) return;
+
+    if (packet.end) {
+      console.log('Offline catch-up complete:', packet.total, 'samples');
+      return;
+    }
+
+    const now = Date.now();
+    for (const sample of packet.samples) {
+      const timestamp = now - (packet.deviceUptime - sample.uptime) * 1000;
+      saveReading(sample, timestamp).catch(err => {
+        console.warn('Failed to save offline reading:', err);
+      });
+    }
+  } catch (error) {
+    console.error('Error parsing offline data:', error);
+  }
+}
+
+/**
+ * Answer a precise time sync request with the UTC time it arrived at.
+ */
+function handleTimeSyncRequest(event) {
+  const receivedAt = performance.now();
+  const deviceTime = parseTimeSyncRequest(event.target.value);
+  if (deviceTime === null || !commandChar) return;
+
+  const t2 = Date.now() - (performance.now() - receivedAt);
+  const reply = buildTimeSyncReply(deviceTime, t2, performance.now() - receivedAt);
+  commandChar.writeValue(reply).catch(err => {
+    console.warn('Time sync reply failed:', err);
+  });
+}
+
 function handleDisconnect() {
   console.log('Device disconnected');
   cleanup();
@@ -363,6 +824,13 @@ function cleanup() {
   if (liveChar) {
     liveChar.removeEventListener('characteristicvaluechanged', handleLiveData);
   }
+  if (waveChar) {
+    waveChar.removeEventListener('characteristicvaluechanged', handleWaveform);
+  }
+  if (syncChar) {
+    syncChar.removeEventListener('characteristicvaluechanged', handleOfflineData);
+    syncChar.removeEventListener('characteristicvaluechanged', handleTimeSyncRequest);
+  }
   if (device) {
     device.removeEventListener('gattserverdisconnected', handleDisconnect);
   }
@@ -375,7 +843,10 @@ function cleanup() {
   todayChar = null;
   weekChar = null;
   commandChar = null;
+  waveChar = null;
+  syncChar = null;
   onDataCallback = null;
+  onWaveformCallback = null;
 
   // Update app state to reflect disconnection
   setState({ connected: false, device: null });
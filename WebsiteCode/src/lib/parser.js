@@ -2,6 +2,99 @@
 // Binary Data Parser for ESP32 BLE Protocol
 // ===========================================
 
+// First byte of batched live packets (never a valid stress value)
+const LIVE_BATCH_MARKER = 0xB1;
+
+// First byte of TLV live frames
+const TLV_LIVE_FRAME = 0xE1;
+
+// TLV field tags (must match DeviceCode.cpp). Unknown tags are kept by number.
+const TLV_LIVE_FIELDS = {
+  0x01: 'stress',
+  0x02: 'hr',
+  0x03: 'hrv',
+  0x04: 'gsr',
+  0x05: 'status',
+  0x06: 'stressDisplay',
+  0x07: 'activityLevel',
+  0x08: 'motionVariance',
+  0x09: 'hrvBaseline',
+  0x0A: 'rawGsr',
+  0x0B: 'rawIr',
+  0x0C: 'deviceTime',
+};
+
+const TLV_HISTORY_FIELDS = {
+  0x21: 'hour',
+  0x22: 'dayIndex',
+  0x23: 'avgStress',
+  0x24: 'peakStress',
+  0x25: 'peakHour',
+  0x26: 'highStressMins',
+  0x27: 'avgHR',
+  0x28: 'avgHRV',
+  0x29: 'avgGSR',
+  0x2A: 'sampleCount',
+  0x2B: 'activityLevel',
+  0x2C: 'valid',
+};
+
+// Runtime tunables (must match TUNE_* in DeviceCode.cpp); float ones travel as IEEE-754
+const TUNABLES = {
+  0x01: { name: 'irIntervalMs', float: false },
+  0x02: { name: 'motionIntervalMs', float: false },
+  0x03: { name: 'rrWindow', float: false },
+  0x04: { name: 'motionWindow', float: false },
+  0x05: { name: 'gsrWindow', float: false },
+  0x06: { name: 'gsrAlpha', float: true },
+  0x07: { name: 'hrvLearningRate', float: true },
+  0x08: { name: 'motionThreshold', float: true },
+  0x09: { name: 'activityLight', float: true },
+  0x0A: { name: 'activityActive', float: true },
+  0x0B: { name: 'activityExercise', float: true },
+  0x0C: { name: 'notifyPeriodMs', float: false },
+  0x0D: { name: 'liveKeepaliveS', float: false },
+  0x0E: { name: 'deadbandStress', float: false },
+  0x0F: { name: 'deadbandHR', float: false },
+  0x10: { name: 'deadbandHRV', float: false },
+  0x11: { name: 'deadbandGSR', float: false },
+  0x12: { name: 'broadcastPeriodMs', float: false },
+};
+
+const TLV_CAP_TAGS = {
+  0x01: 'liveFields',
+  0x02: 'historyFields',
+  0x03: 'commands',
+  0x04: 'liveModes',
+  0x05: 'liveRates',
+  0x06: 'waveStreams',
+  0x07: 'mtu',
+  0x08: 'compression',
+};
+
+// Stats characteristic tags (must match TLV_STAT_* in DeviceCode.cpp)
+const TLV_STAT_TAGS = {
+  0x01: 'liveSent',
+  0x02: 'liveSuppressed',
+  0x03: 'eventsDropped',
+  0x04: 'sendQueueDepth',
+  0x05: 'sendQueueHighWater',
+  0x06: 'sendDropped',
+  0x07: 'sendCoalesced',
+  0x08: 'sendRetries',
+  0x09: 'renderFps',
+  0x0A: 'framesDeferred',
+  0x0B: 'awakePermille',
+  0x0C: 'irSampleLateMaxMs',
+};
+
+// Advertising broadcast (manufacturer data under the testing company id)
+export const BROADCAST_COMPANY_ID = 0xFFFF;
+const BROADCAST_FORMAT = 0x01;
+
+// History compression modes (command 0x04 byte [6])
+export const HISTORY_COMPRESS_LZ = 0x01;
+
 /**
  * Parse live data from ESP32 (7 bytes)
  * Format:
@@ -37,6 +130,353 @@ export function parseLiveData(dataView) {
   };
 }
 
+/**
+ * Parse batched live data from ESP32 (sent when live mode 0x01 is enabled)
+ * Format:
+ *   [0] marker (0xB1)
+ *   [1] sample count
+ *   [2-5] timestamp of first sample (32-bit LE, device millis)
+ *   Per sample (9 bytes):
+ *     [0-1] offset from first sample in ms (16-bit LE)
+ *     [2-8] 7-byte live sample (same layout as parseLiveData)
+ * 
+ * @param {DataView} dataView - DataView of the batched packet
+ * @returns {Array} Array of parsed live samples with deviceTime (ms)
+ */
+export function parseLiveBatch(dataView) {
+  if (dataView.byteLength < 6 || dataView.getUint8(0) !== LIVE_BATCH_MARKER) {
+    throw new Error('Invalid LiveBatch packet');
+  }
+
+  const count = dataView.getUint8(1);
+  const baseTime = dataView.getUint32(2, true);
+
+  if (dataView.byteLength < 6 + count * 9) {
+    throw new Error(`Invalid LiveBatch length: ${dataView.byteLength}, expected ${6 + count * 9}`);
+  }
+
+  const samples = [];
+
+  for (let i = 0; i < count; i++) {
+    const offset = 6 + i * 9;
+    const sample = new DataView(dataView.buffer, dataView.byteOffset + offset + 2, 7);
+
+    samples.push({
+      ...parseLiveData(sample),
+      deviceTime: baseTime + dataView.getUint16(offset, true),
+    });
+  }
+
+  return samples;
+}
+
+/**
+ * Check whether a live notification is a batched packet
+ * @param {DataView} dataView - DataView of the notification value
+ * @returns {boolean}
+ */
+export function isLiveBatch(dataView) {
+  return dataView.byteLength > 0 && dataView.getUint8(0) === LIVE_BATCH_MARKER;
+}
+
+/**
+ * Parse raw waveform packet from ESP32 (delta encoded)
+ * Format:
+ *   [0] stream type (0x01 = IR, 0x02 = GSR)
+ *   [1-2] sequence number (16-bit LE, per stream, wraps at 65536)
+ *   [3] sample count
+ *   [4] sample interval in ms
+ *   [5-8] first sample (32-bit LE, signed)
+ *   [9..] zigzag varint deltas for remaining samples
+ * 
+ * @param {DataView} dataView - DataView of the waveform packet
+ * @returns {Object} { stream, sequence, intervalMs, samples }
+ */
+export function parseWaveformPacket(dataView) {
+  if (dataView.byteLength < 9) {
+    throw new Error(`Invalid Waveform length: ${dataView.byteLength}, expected at least 9`);
+  }
+
+  const type = dataView.getUint8(0);
+  const count = dataView.getUint8(3);
+  const samples = [dataView.getInt32(5, true)];
+  let offset = 9;
+
+  for (let i = 1; i < count; i++) {
+    let zigzag = 0;
+    let shift = 0;
+    let byte;
+
+    do {
+      if (offset >= dataView.byteLength) {
+        throw new Error('Truncated Waveform packet');
+      }
+      byte = dataView.getUint8(offset++);
+      zigzag += (byte & 0x7F) * 2 ** shift;
+      shift += 7;
+    } while (byte & 0x80);
+
+    const delta = (zigzag % 2 === 0) ? zigzag / 2 : -(zigzag + 1) / 2;
+    samples.push(samples[i - 1] + delta);
+  }
+
+  return {
+    stream: type === 0x01 ? 'ir' : (type === 0x02 ? 'gsr' : 'unknown'),
+    sequence: dataView.getUint16(1, true),
+    intervalMs: dataView.getUint8(4),
+    samples,
+  };
+}
+
+/**
+ * Decode a run of TLV fields ([tag][length][value LE]).
+ * Values up to 4 bytes are returned as numbers; longer values as byte arrays.
+ * 
+ * @param {DataView} dataView - Buffer containing the fields
+ * @param {number} start - Offset of the first field
+ * @param {number} end - Offset just past the last field
+ * @param {Object} names - Map of tag to field name
+ * @param {boolean} asBytes - Return every value as a byte array
+ * @returns {Object} Decoded fields (unknown tags keyed as 'tag<N>')
+ */
+function parseTlvFields(dataView, start, end, names, asBytes = false) {
+  const fields = {};
+  let offset = start;
+
+  while (offset + 2 <= end) {
+    const tag = dataView.getUint8(offset);
+    const length = dataView.getUint8(offset + 1);
+    offset += 2;
+
+    if (offset + length > end) {
+      throw new Error(`Truncated TLV field 0x${tag.toString(16)}`);
+    }
+
+    let value;
+    if (length <= 4 && !asBytes) {
+      value = 0;
+      for (let i = length - 1; i >= 0; i--) {
+        value = value * 256 + dataView.getUint8(offset + i);
+      }
+    } else {
+      value = new Uint8Array(dataView.buffer, dataView.byteOffset + offset, length);
+    }
+
+    fields[names[tag] ?? `tag${tag}`] = value;
+    offset += length;
+  }
+
+  return fields;
+}
+
+/**
+ * Check whether a live notification is a TLV frame
+ * @param {DataView} dataView - DataView of the notification value
+ * @returns {boolean}
+ */
+export function isLiveTlvFrame(dataView) {
+  return dataView.byteLength >= 2 && dataView.getUint8(0) === TLV_LIVE_FRAME;
+}
+
+/**
+ * Parse TLV live frame from ESP32 (sent when live mode 0x02 is enabled)
+ * Format:
+ *   [0] frame type (0xE1)
+ *   [1] protocol version
+ *   [2..] TLV fields ([tag][length][value LE])
+ * Only the fields selected with command 0x05 are present.
+ * 
+ * @param {DataView} dataView - DataView of the TLV frame
+ * @returns {Object} Parsed live data (status bits expanded when present)
+ */
+export function parseLiveTlvFrame(dataView) {
+  if (!isLiveTlvFrame(dataView)) {
+    throw new Error('Invalid TLV live frame');
+  }
+
+  const data = parseTlvFields(dataView, 2, dataView.byteLength, TLV_LIVE_FIELDS);
+  data.version = dataView.getUint8(1);
+
+  if (data.status !== undefined) {
+    data.hrActive = (data.status & 0x01) !== 0;
+    data.calibrated = (data.status & 0x02) !== 0;
+    data.motionDetected = (data.status & 0x04) !== 0;
+    data.mpuReady = (data.status & 0x80) !== 0;
+  }
+  if (data.motionVariance !== undefined) {
+    data.motionVariance /= 1000;
+  }
+
+  return data;
+}
+
+/**
+ * Parse the capabilities characteristic
+ * Format:
+ *   [0] protocol version
+ *   [1..] TLV entries: field/command/mode lists, rate range, wave streams, MTU
+ * 
+ * @param {DataView} dataView - DataView of the capabilities value
+ * @returns {Object} { version, liveFields, historyFields, commands, liveModes, liveRates, waveStreams, mtu, compression }
+ */
+export function parseCapabilities(dataView) {
+  if (dataView.byteLength < 1) {
+    throw new Error('Invalid Capabilities length: 0');
+  }
+
+  const raw = parseTlvFields(dataView, 1, dataView.byteLength, TLV_CAP_TAGS, true);
+  const list = (name) => Array.from(raw[name] ?? []);
+  const caps = { version: dataView.getUint8(0) };
+
+  caps.liveFields = list('liveFields').map(tag => TLV_LIVE_FIELDS[tag] ?? `tag${tag}`);
+  caps.historyFields = list('historyFields').map(tag => TLV_HISTORY_FIELDS[tag] ?? `tag${tag}`);
+  caps.commands = list('commands');
+  caps.liveModes = list('liveModes');
+
+  const rates = list('liveRates');
+  caps.liveRates = { minHz: rates[0] ?? 1, maxHz: rates[1] ?? 1 };
+
+  const waves = list('waveStreams');
+  caps.waveStreams = [];
+  for (let i = 0; i + 1 < waves.length; i += 2) {
+    caps.waveStreams.push({ type: waves[i], intervalMs: waves[i + 1] });
+  }
+
+  const mtu = list('mtu');
+  caps.mtu = mtu.length >= 2 ? mtu[0] | (mtu[1] << 8) : 23;
+  caps.compression = list('compression');
+
+  return caps;
+}
+
+/**
+ * Parse the stats characteristic (device counters since boot)
+ * Format:
+ *   [0] protocol version
+ *   [1..] TLV entries: live notifications sent/suppressed, BLE events dropped,
+ *         send queue depth/high water and dropped/coalesced/retried notifications
+ * 
+ * @param {DataView} dataView - DataView of the stats value
+ * @returns {Object} { version, liveSent, liveSuppressed, eventsDropped, sendDropped, ... }
+ */
+export function parseStats(dataView) {
+  if (dataView.byteLength < 1) {
+    throw new Error('Invalid Stats length: 0');
+  }
+
+  const stats = parseTlvFields(dataView, 1, dataView.byteLength, TLV_STAT_TAGS);
+  stats.version = dataView.getUint8(0);
+  return stats;
+}
+
+/**
+ * Parse a connectionless broadcast from the advertising manufacturer data
+ * Format (after the 16-bit company id, which Web Bluetooth strips):
+ *   [0] format (0x01)
+ *   [1] sequence (increments on every update, wraps)
+ *   [2-8] 7-byte live sample (same layout as parseLiveData)
+ * 
+ * @param {DataView} dataView - Manufacturer data for BROADCAST_COMPANY_ID
+ * @returns {Object|null} { sequence, ...live data }, or null for other formats
+ */
+export function parseBroadcast(dataView) {
+  if (dataView.byteLength < 9 || dataView.getUint8(0) !== BROADCAST_FORMAT) {
+    return null;
+  }
+
+  return {
+    sequence: dataView.getUint8(1),
+    ...parseLiveData(new DataView(dataView.buffer, dataView.byteOffset + 2, 7)),
+  };
+}
+
+/**
+ * Parse the tunables characteristic
+ * Format:
+ *   [0] tunables layout version
+ *   [1..] TLV entries: tag = tunable id, 4-byte little-endian value
+ * 
+ * @param {DataView} dataView - DataView of the tunables value
+ * @returns {Object} { version, irIntervalMs, gsrAlpha, ... } (unknown ids kept as tagN)
+ */
+export function parseTunables(dataView) {
+  if (dataView.byteLength < 1) {
+    throw new Error('Invalid Tunables length: 0');
+  }
+
+  const result = { version: dataView.getUint8(0) };
+  let offset = 1;
+
+  while (offset + 2 <= dataView.byteLength) {
+    const tag = dataView.getUint8(offset);
+    const len = dataView.getUint8(offset + 1);
+    offset += 2;
+    if (offset + len > dataView.byteLength) break;
+
+    const spec = TUNABLES[tag];
+    if (len === 4) {
+      const value = spec?.float ? dataView.getFloat32(offset, true) : dataView.getUint32(offset, true);
+      result[spec ? spec.name : `tag${tag}`] = value;
+    }
+    offset += len;
+  }
+
+  return result;
+}
+
+/**
+ * Encode tunable changes for command 0x06 (up to 3 per write)
+ * Format: [0x06, (id, value 32-bit LE)...]
+ * @param {Object} values - Tunable names to new values (e.g. { gsrAlpha: 0.02 })
+ * @returns {Array<Uint8Array>} Command packets to write in order
+ */
+export function buildTunableCommands(values) {
+  const entries = [];
+  for (const [tag, spec] of Object.entries(TUNABLES)) {
+    if (values[spec.name] !== undefined) {
+      entries.push([Number(tag), spec.float, values[spec.name]]);
+    }
+  }
+
+  const packets = [];
+  for (let i = 0; i < entries.length; i += 3) {
+    const chunk = entries.slice(i, i + 3);
+    const packet = new Uint8Array(1 + chunk.length * 5);
+    const view = new DataView(packet.buffer);
+    packet[0] = 0x06;
+    chunk.forEach(([tag, isFloat, value], j) => {
+      view.setUint8(1 + j * 5, tag);
+      if (isFloat) {
+        view.setFloat32(2 + j * 5, value, true);
+      } else {
+        view.setUint32(2 + j * 5, value, true);
+      }
+    });
+    packets.push(packet);
+  }
+
+  return packets;
+}
+
+/**
+ * Build a TLV field selection mask from field names
+ * @param {Array<string>} names - Field names (as returned by the parser)
+ * @param {boolean} history - true for history fields, false for live fields
+ * @returns {number} 32-bit mask for command 0x05
+ */
+export function buildFieldMask(names, history = false) {
+  const table = history ? TLV_HISTORY_FIELDS : TLV_LIVE_FIELDS;
+  let mask = 0;
+
+  for (const [tag, name] of Object.entries(table)) {
+    if (names.includes(name)) {
+      mask |= 1 << (history ? Number(tag) - 0x20 : Number(tag));
+    }
+  }
+
+  return mask >>> 0;
+}
+
 /**
  * Parse hourly data from ESP32 (240 bytes = 24 × 10 bytes)
  * Format per record:
@@ -60,25 +500,34 @@ export function parseHourlyData(dataView) {
   const records = [];
   
   for (let i = 0; i < 24; i++) {
-    const offset = i * 10;
-    const flags = dataView.getUint8(offset + 9);
-    
-    records.push({
-      hour: dataView.getUint8(offset),
-      avgStress: dataView.getUint8(offset + 1),
-      peakStress: dataView.getUint8(offset + 2),
-      highStressMins: dataView.getUint8(offset + 3),
-      avgHR: dataView.getUint8(offset + 4),
-      avgHRV: dataView.getUint16(offset + 5, true),
-      avgGSR: dataView.getUint16(offset + 7, true),
-      valid: (flags & 0x01) !== 0,
-      activityLevel: (flags >> 1) & 0x03,
-    });
+    records.push(parseHourlyRecord(dataView, i * 10));
   }
   
   return records;
 }
 
+/**
+ * Parse a single 10-byte hourly record (layout documented in parseHourlyData)
+ * @param {DataView} dataView - Buffer containing the record
+ * @param {number} offset - Byte offset of the record
+ * @returns {Object} Hourly record
+ */
+function parseHourlyRecord(dataView, offset) {
+  const flags = dataView.getUint8(offset + 9);
+
+  return {
+    hour: dataView.getUint8(offset),
+    avgStress: dataView.getUint8(offset + 1),
+    peakStress: dataView.getUint8(offset + 2),
+    highStressMins: dataView.getUint8(offset + 3),
+    avgHR: dataView.getUint8(offset + 4),
+    avgHRV: dataView.getUint16(offset + 5, true),
+    avgGSR: dataView.getUint16(offset + 7, true),
+    valid: (flags & 0x01) !== 0,
+    activityLevel: (flags >> 1) & 0x03,
+  };
+}
+
 /**
  * Parse daily summary data from ESP32 (70 bytes = 7 × 10 bytes)
  * Format per record:
@@ -103,23 +552,245 @@ export function parseDailyData(dataView) {
   const records = [];
   
   for (let i = 0; i < 7; i++) {
-    const offset = i * 10;
-    
-    records.push({
-      dayIndex: dataView.getUint8(offset),
-      avgStress: dataView.getUint8(offset + 1),
-      peakStress: dataView.getUint8(offset + 2),
-      peakHour: dataView.getUint8(offset + 3),
-      highStressMins: dataView.getUint8(offset + 4),
-      avgHR: dataView.getUint8(offset + 5),
-      avgHRV: dataView.getUint16(offset + 6, true),
-      valid: dataView.getUint8(offset + 9) !== 0,
-    });
+    records.push(parseDailyRecord(dataView, i * 10));
   }
   
   return records;
 }
 
+/**
+ * Parse a single 10-byte daily record (layout documented in parseDailyData)
+ * @param {DataView} dataView - Buffer containing the record
+ * @param {number} offset - Byte offset of the record
+ * @returns {Object} Daily summary record
+ */
+function parseDailyRecord(dataView, offset) {
+  return {
+    dayIndex: dataView.getUint8(offset),
+    avgStress: dataView.getUint8(offset + 1),
+    peakStress: dataView.getUint8(offset + 2),
+    peakHour: dataView.getUint8(offset + 3),
+    highStressMins: dataView.getUint8(offset + 4),
+    avgHR: dataView.getUint8(offset + 5),
+    avgHRV: dataView.getUint16(offset + 6, true),
+    valid: dataView.getUint8(offset + 9) !== 0,
+  };
+}
+
+/**
+ * Parse a delta sync packet from ESP32 (Sync characteristic)
+ * Records packet:
+ *   [0] type (0xD1)
+ *   [1] record count
+ *   Per record (15 bytes):
+ *     [0] kind (0x00 = hourly record, 0x01 = daily record)
+ *     [1-4] sequence number (32-bit LE)
+ *     [5-14] 10-byte hourly/daily record
+ * TLV records packet:
+ *   [0] type (0xD3)
+ *   [1] record count
+ *   Per record: [0] kind, [1-4] sequence, [5] TLV length, [6..] TLV fields
+ * LZ records packet:
+ *   [0] type (0xD4)
+ *   [1] record count
+ *   [2] type of the compressed packet (0xD1 or 0xD3)
+ *   [3..] LZ stream expanding to that packet's records (see lzDecompress)
+ * End packet:
+ *   [0] type (0xD2)
+ *   [1] current day slot (0-6)
+ *   [2-5] latest sequence number (32-bit LE)
+ * 
+ * Other packet types share the Sync characteristic (offline drain, time
+ * sync) and are not delta sync packets.
+ * 
+ * @param {DataView} dataView - DataView of the sync packet
+ * @returns {Object|null} { end: false, records } or { end: true, currentDay, latestSeq }, or null for other packet types
+ */
+export function parseDeltaSyncPacket(dataView) {
+  const type = dataView.byteLength > 0 ? dataView.getUint8(0) : 0;
+
+  if (type < 0xD1 || type > 0xD4) {
+    return null;
+  }
+
+  if (type === 0xD2 && dataView.byteLength >= 6) {
+    return {
+      end: true,
+      currentDay: dataView.getUint8(1),
+      latestSeq: dataView.getUint32(2, true),
+    };
+  }
+
+  if (type === 0xD4 && dataView.byteLength >= 3) {
+    const body = lzDecompress(new Uint8Array(dataView.buffer, dataView.byteOffset + 3, dataView.byteLength - 3));
+    const packet = new Uint8Array(2 + body.length);
+    packet[0] = dataView.getUint8(2);
+    packet[1] = dataView.getUint8(1);
+    packet.set(body, 2);
+    return parseDeltaSyncPacket(new DataView(packet.buffer));
+  }
+
+  if (type === 0xD3) {
+    const records = [];
+    let offset = 2;
+
+    for (let i = 0; i < dataView.getUint8(1); i++) {
+      const isHour = dataView.getUint8(offset) === 0x00;
+      const length = dataView.getUint8(offset + 5);
+      const record = parseTlvFields(dataView, offset + 6, offset + 6 + length, TLV_HISTORY_FIELDS);
+      if (record.valid !== undefined) record.valid = record.valid !== 0;
+
+      records.push({
+        kind: isHour ? 'hour' : 'day',
+        sequence: dataView.getUint32(offset + 1, true),
+        record,
+      });
+      offset += 6 + length;
+    }
+
+    return { end: false, records };
+  }
+
+  if (type !== 0xD1 || dataView.byteLength < 2 + dataView.getUint8(1) * 15) {
+    throw new Error(`Invalid DeltaSync packet (type ${type}, length ${dataView.byteLength})`);
+  }
+
+  const records = [];
+
+  for (let i = 0; i < dataView.getUint8(1); i++) {
+    const offset = 2 + i * 15;
+    const isHour = dataView.getUint8(offset) === 0x00;
+
+    records.push({
+      kind: isHour ? 'hour' : 'day',
+      sequence: dataView.getUint32(offset + 1, true),
+      record: isHour ? parseHourlyRecord(dataView, offset + 5) : parseDailyRecord(dataView, offset + 5),
+    });
+  }
+
+  return { end: false, records };
+}
+
+/**
+ * Expand the LZ stream of a compressed delta sync packet
+ * Stream format, repeated:
+ *   [0xxxxxxx] literal run: x + 1 raw bytes follow
+ *   [1xxxxxxx][offset - 1] match: copy x + 3 bytes starting offset bytes back
+ *                          (may overlap the bytes being produced)
+ * 
+ * @param {Uint8Array} bytes - Compressed stream
+ * @returns {Uint8Array} Decompressed bytes
+ */
+export function lzDecompress(bytes) {
+  const out = [];
+  let i = 0;
+
+  while (i < bytes.length) {
+    const control = bytes[i++];
+
+    if (control & 0x80) {
+      const count = (control & 0x7F) + 3;
+      const offset = bytes[i++] + 1;
+      if (i > bytes.length || offset > out.length) {
+        throw new Error('Invalid LZ stream: bad match');
+      }
+      for (let k = 0; k < count; k++) out.push(out[out.length - offset]);
+    } else {
+      const count = control + 1;
+      if (i + count > bytes.length) {
+        throw new Error('Invalid LZ stream: truncated literals');
+      }
+      for (let k = 0; k < count; k++) out.push(bytes[i++]);
+    }
+  }
+
+  return Uint8Array.from(out);
+}
+
+/**
+ * Parse an offline drain packet from ESP32 (Sync characteristic)
+ * Data packet:
+ *   [0] type (0xF1)
+ *   [1] sample count
+ *   [2-5] current device uptime in seconds (32-bit LE)
+ *   Per sample (11 bytes):
+ *     [0-3] device uptime in seconds when recorded (32-bit LE)
+ *     [4-10] 7-byte live sample (same layout as parseLiveData)
+ * End packet:
+ *   [0] type (0xF2)
+ *   [1-2] samples delivered (16-bit LE)
+ * 
+ * @param {DataView} dataView - DataView of the sync packet
+ * @returns {Object|null} { end, deviceUptime, samples } / { end, total }, or null for other packet types
+ */
+export function parseOfflineDrainPacket(dataView) {
+  const type = dataView.byteLength > 0 ? dataView.getUint8(0) : 0;
+
+  if (type === 0xF2 && dataView.byteLength >= 3) {
+    return { end: true, total: dataView.getUint16(1, true) };
+  }
+  if (type !== 0xF1) {
+    return null;
+  }
+
+  const count = dataView.getUint8(1);
+  if (dataView.byteLength < 6 + count * 11) {
+    throw new Error(`Invalid OfflineDrain length: ${dataView.byteLength}, expected ${6 + count * 11}`);
+  }
+
+  const samples = [];
+  for (let i = 0; i < count; i++) {
+    const offset = 6 + i * 11;
+    const sample = new DataView(dataView.buffer, dataView.byteOffset + offset + 4, 7);
+
+    samples.push({
+      ...parseLiveData(sample),
+      uptime: dataView.getUint32(offset, true),
+    });
+  }
+
+  return { end: false, deviceUptime: dataView.getUint32(2, true), samples };
+}
+
+/**
+ * Parse a time sync request from ESP32 (Sync characteristic, after command 0x08)
+ * Format:
+ *   [0] type (0xE1)
+ *   [1-4] device time T1 in ms (32-bit LE), echoed back in the reply
+ * 
+ * @param {DataView} dataView - DataView of the sync packet
+ * @returns {number|null} T1, or null for other packet types
+ */
+export function parseTimeSyncRequest(dataView) {
+  if (dataView.byteLength < 5 || dataView.getUint8(0) !== 0xE1) {
+    return null;
+  }
+  return dataView.getUint32(1, true);
+}
+
+/**
+ * Build the reply to a time sync request (command 0x09)
+ * Format:
+ *   [0] command (0x09)
+ *   [1-4] T1 from the request (32-bit LE)
+ *   [5-12] T2: UTC time when the request arrived (ms since 1970, 64-bit LE)
+ *   [13-14] T3 - T2: ms between receiving the request and sending the reply (16-bit LE)
+ * 
+ * @param {number} deviceTime - T1 from parseTimeSyncRequest
+ * @param {number} receivedAt - UTC time in ms (Date.now()) when the request arrived
+ * @param {number} turnaroundMs - Time taken before the reply is written
+ * @returns {Uint8Array} Command bytes
+ */
+export function buildTimeSyncReply(deviceTime, receivedAt, turnaroundMs) {
+  const data = new Uint8Array(15);
+  const view = new DataView(data.buffer);
+  view.setUint8(0, 0x09);
+  view.setUint32(1, deviceTime, true);
+  view.setBigUint64(5, BigInt(Math.round(receivedAt)), true);
+  view.setUint16(13, Math.min(Math.max(Math.round(turnaroundMs), 0), 0xFFFF), true);
+  return data;
+}
+
 /**
  * Get activity level name from numeric value
  * @param {number} level - Activity level (0-3)
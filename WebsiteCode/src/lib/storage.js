@@ -144,11 +144,11 @@ async function getDB() {
  * Raw readings are pruned after 24 hours to prevent database bloat.
  * 
  * @param {Object} reading - Sensor data object { stress, hr, hrv, gsr, hrActive, calibrated, ... }
+ * @param {number} timestamp - When the reading was taken (defaults to now; set for offline catch-up)
  * @returns {Promise<number>} The auto-generated record ID
  */
-export async function saveReading(reading) {
+export async function saveReading(reading, timestamp = Date.now()) {
   const database = await getDB();
-  const timestamp = Date.now();
   // Extract date string (YYYY-MM-DD) for efficient date-based queries
   const date = new Date(timestamp).toISOString().split('T')[0];
   
@@ -198,9 +198,9 @@ async function handleConnect() {
       });
       
       // Auto-sync history on connect
-      // Downloads today's hourly data and week summaries from device
+      // Downloads only hourly/daily records that changed since the last sync
       try {
-        await ble.readHistory();
+        await ble.readHistoryDelta();
         console.log('History synced');
       } catch (e) {
         // Non-fatal - app continues to work even if history sync fails
@@ -1,13 +1,34 @@
-#include <Adafruit_GFX.h>
-#include <Adafruit_SSD1306.h>
 #include <Wire.h>
 #include <Preferences.h>
+#include <MPU6050_light.h>
+#include "MAX30105.h"
+#include <atomic>
+#include <esp_timer.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <sys/time.h>
+
+// BLE backend is selected at build time (-DBLE_BACKEND=...)
+#define BLE_BACKEND_BLUEDROID   1   // ESP32 Arduino BLE library (default)
+#define BLE_BACKEND_LOOPBACK    2   // In-process host client (host/loopback_transport.h)
+#define BLE_BACKEND_NIMBLE      3   // NimBLE-Arduino 1.4.x, smaller host stack
+#ifndef BLE_BACKEND
+#define BLE_BACKEND BLE_BACKEND_BLUEDROID
+#endif
+
+#if BLE_BACKEND == BLE_BACKEND_BLUEDROID
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
-#include <MPU6050_light.h>
-#include "MAX30105.h"
+#define BLE_BACKEND_NAME "Bluedroid"
+#elif BLE_BACKEND == BLE_BACKEND_NIMBLE
+#include <NimBLEDevice.h>
+#define BLE_BACKEND_NAME "NimBLE"
+#else
+#define BLE_BACKEND_NAME "Loopback"
+#endif
 
 // ===========================================
 // HARDWARE CONFIGURATION
@@ -24,56 +45,609 @@
 // ===========================================
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+#define OLED_ADDRESS 0x3C
+
+// SSD1306 commands and colors
+#define SSD1306_SWITCHCAPVCC 0x02
+#define SSD1306_SETCONTRAST  0x81
+#define SSD1306_DISPLAYOFF   0xAE
+#define SSD1306_DISPLAYON    0xAF
+#define SSD1306_COLUMNADDR   0x21
+#define SSD1306_PAGEADDR     0x22
+#define SSD1306_BLACK        0
+#define SSD1306_WHITE        1
+#define BLACK                SSD1306_BLACK
+#define WHITE                SSD1306_WHITE
+
+// There is no frame buffer. Screens draw into a retained scene (a list of
+// text runs, rectangles, circles and data series); flushDisplay() composes
+// the panel one 128-byte page at a time from the scene and sends each page
+// as soon as it is composed. This replaces the 1 KB Adafruit_SSD1306
+// buffer with SCENE_MAX_ITEMS * 8 + SCENE_DATA_SIZE bytes of scene.
+#define SCENE_MAX_ITEMS      24
+#define SCENE_DATA_SIZE      128    // Text characters and series values together
+#define SCENE_NO_VALUE       0xFF   // Series value with no data (gap)
+#define FONT_WIDTH           5      // Glyph columns; text advances 6 per character
+#define FONT_FIRST_CHAR      0x20
+#define FONT_LAST_CHAR       0x7E
+
+enum SceneKind : uint8_t {
+  SCENE_TEXT, SCENE_RECT, SCENE_FILL_RECT, SCENE_CIRCLE, SCENE_FILL_CIRCLE,
+  SCENE_SPARKLINE, SCENE_BARS
+};
+
+struct SceneItem {
+  uint8_t kind;       // SceneKind
+  uint8_t style;      // Bit 0: color, bits 1-7: text scale or series column pitch
+  int16_t x;
+  int16_t y;          // Top; center for circles; baseline for series
+  uint8_t a;          // Rect: width. Circle: radius. Text/series: offset into sceneData
+  uint8_t b;          // Rect: height. Text/series: length
+};
+
+SceneItem sceneItems[SCENE_MAX_ITEMS];
+uint8_t sceneItemCount = 0;
+char sceneData[SCENE_DATA_SIZE];
+uint8_t sceneDataUsed = 0;
+uint32_t shownSceneSum = 0;         // Checksum of the scene the panel shows
+uint32_t sceneOverflows = 0;        // Primitives or characters dropped (scene full)
+
+/**
+ * Drawing front end with the subset of the Adafruit_SSD1306 interface the
+ * screens use. Drawing calls append to the scene; nothing touches the
+ * panel until flushDisplay().
+ */
+class SceneDisplay : public Print {
+ public:
+  bool begin(uint8_t vcc, uint8_t address);
+  void clearDisplay();
+  void setCursor(int16_t x, int16_t y) { cursorX = x; cursorY = y; }
+  void setTextSize(uint8_t size) { textSize = size; }
+  void setTextColor(uint16_t color) { textColor = color ? WHITE : BLACK; }
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+  void drawCircle(int16_t x, int16_t y, int16_t r, uint16_t color);
+  void fillCircle(int16_t x, int16_t y, int16_t r, uint16_t color);
+  void drawSparkline(int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color);
+  void drawBars(int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color);
+  void dim(bool dimmed);
+  void ssd1306_command(uint8_t command);
+  size_t write(uint8_t c) override;
+  using Print::write;
+  
+ private:
+  int16_t cursorX = 0;
+  int16_t cursorY = 0;
+  uint8_t textSize = 1;
+  uint8_t textColor = WHITE;
+};
+
+SceneDisplay display;
+
+// Partial updates: the panel is tracked as tiles of one page (8 rows) by
+// DISPLAY_TILE_WIDTH columns with a checksum of what each tile last showed;
+// the changed tiles of a page are written as one column range using
+// SSD1306 page/column addressing.
+#define DISPLAY_PAGES        (SCREEN_HEIGHT / 8)
+#define DISPLAY_TILE_WIDTH   16
+#define DISPLAY_TILES        (SCREEN_WIDTH / DISPLAY_TILE_WIDTH)
+#define DISPLAY_I2C_CHUNK    64     // Data bytes per I2C transaction (Wire buffer is 128)
+
+uint32_t displayTileSums[DISPLAY_PAGES][DISPLAY_TILES];
+bool displayTilesValid = false;     // False until the whole panel has been written once
+
+// Flush cost counters since boot
+uint32_t displayFlushes = 0;
+uint32_t displayBytesSent = 0;      // Pixel bytes written to the panel
+uint32_t displayFlushUs = 0;        // Time spent in flushDisplay()
+
+// Render scheduler: each screen has a frame rate cap. Animated screens
+// redraw on their frame clock; static ones only when screenModelKey()
+// changes. A frame is deferred while a sensor read is due sooner than the
+// last frames took to draw, so rendering doesn't push the 50Hz reads late.
+struct ScreenRate {
+  uint8_t maxFps;
+  bool animated;      // Redraw every frame slot, not only on model change
+};
+
+const ScreenRate SCREEN_RATES[] = {   // Indexed by State
+  {5, false},    // DASHBOARD: stress number and bar
+  {25, true},    // BREATHE: breathing circle animation
+  {4, true},     // INFO: raw sensor readouts
+  {2, false},    // TREND: today's hourly stress, redrawn when a bucket changes
+};
+const ScreenRate CALIBRATION_RATE = {10, true};
+
+#define RENDER_MAX_DEFER_MS  40     // Never defer a due frame longer than this
+
+unsigned long lastFrameMillis = 0;
+uint32_t lastModelKey = 0;
+bool renderRequested = true;        // Forces the next frame (e.g. after wake)
+uint32_t renderCostUs = 0;          // Smoothed draw + flush time per frame
+uint32_t framesDeferred = 0;        // Frame slots deferred for a sensor deadline
+uint16_t framesThisWindow = 0;
+unsigned long fpsWindowStart = 0;
+uint8_t renderFps = 0;              // Frames drawn in the last full second
+
+// Display power: after DISPLAY_DIM_MS without interaction the panel is
+// dimmed, after DISPLAY_OFF_MS it is switched off and nothing is rendered
+// or sent until a button press, wrist raise or high-stress event wakes it.
+// Calibration and the breathing guide keep the display on.
+#define DISPLAY_DIM_MS       15000
+#define DISPLAY_OFF_MS       30000
+#define DISPLAY_WAKE_STRESS  80     // Rising past this stress wakes the display
+#define DISPLAY_REARM_STRESS 70     // ...and must fall below this to wake it again
+
+enum DisplayPower { DISPLAY_ON, DISPLAY_DIMMED, DISPLAY_BLANK };
+DisplayPower displayPower = DISPLAY_ON;
+unsigned long lastDisplayActivity = 0;
+bool buttonWokeDisplay = false;     // Swallow the press that turned the display on
+bool stressWakeArmed = true;
 
 // ===========================================
 // MAX30102 SENSOR
 // ===========================================
 MAX30105 particleSensor;
 bool hrSensorActive = false;
+unsigned long lastIRRead = 0;         // Last IR sample time (also read by the render scheduler)
 
 // ===========================================
 // BLE SERVICE DEFINITION
 // ===========================================
 // Custom UUIDs for StressView service and characteristics
 #define SERVICE_UUID        "0000ff00-0000-1000-8000-00805f9b34fb"
+#define SERVICE_UUID16      0xFF00  // Same service in 16-bit form (fits broadcast advertising)
 #define CHAR_LIVE_UUID      "0000ff01-0000-1000-8000-00805f9b34fb"  // Real-time notifications
 #define CHAR_TODAY_UUID     "0000ff02-0000-1000-8000-00805f9b34fb"  // 24-hour history
 #define CHAR_WEEK_UUID      "0000ff03-0000-1000-8000-00805f9b34fb"  // 7-day summary
 #define CHAR_COMMAND_UUID   "0000ff04-0000-1000-8000-00805f9b34fb"  // App control commands
+#define CHAR_WAVE_UUID      "0000ff05-0000-1000-8000-00805f9b34fb"  // Raw IR/GSR waveform stream
+#define CHAR_SYNC_UUID      "0000ff06-0000-1000-8000-00805f9b34fb"  // Incremental history sync stream
+#define CHAR_CAPS_UUID      "0000ff07-0000-1000-8000-00805f9b34fb"  // Protocol capabilities (TLV)
+#define CHAR_TUNE_UUID      "0000ff08-0000-1000-8000-00805f9b34fb"  // Runtime tunables (TLV)
+#define CHAR_STATS_UUID     "0000ff09-0000-1000-8000-00805f9b34fb"  // Runtime counters (TLV)
 
-BLEServer* pServer = nullptr;
-BLECharacteristic* pLiveChar = nullptr;
-BLECharacteristic* pTodayChar = nullptr;
-BLECharacteristic* pWeekChar = nullptr;
-BLECharacteristic* pCommandChar = nullptr;
+// Characteristics as addressed through the BLE transport (see BLE TRANSPORT)
+#define BLE_CHANNEL_LIVE        0
+#define BLE_CHANNEL_TODAY       1
+#define BLE_CHANNEL_WEEK        2
+#define BLE_CHANNEL_COMMAND     3
+#define BLE_CHANNEL_WAVE        4
+#define BLE_CHANNEL_SYNC        5
+#define BLE_CHANNEL_CAPS        6
+#define BLE_CHANNEL_TUNE        7
+#define BLE_CHANNEL_STATS       8
+#define BLE_CHANNEL_COUNT       9
+
+bool deviceConnected = false;  // At least one client connected (see BLE CLIENTS)
 
-bool deviceConnected = false;
-bool oldDeviceConnected = false;
-unsigned long lastBLENotify = 0;
+// Live notification modes (selected by app via command 0x03)
+// Legacy mode keeps the original 7-byte 1Hz packet so older app versions keep working
+#define LIVE_MODE_LEGACY    0x00  // One 7-byte packet per second
+#define LIVE_MODE_BATCHED   0x01  // Multiple timestamped samples packed per notification
+#define LIVE_MODE_TLV       0x02  // Self-describing TLV frame with app-selected fields
+
+#define LIVE_BATCH_MARKER       0xB1   // First byte of batched packets (never a valid stress value)
+#define LIVE_BATCH_HEADER_SIZE  6      // marker + count + base timestamp (4)
+#define LIVE_SAMPLE_SIZE        9      // time offset (2) + 7-byte legacy sample
+#define LIVE_BATCH_MAX_LATENCY  1000   // Flush partial batches at least once per second (ms)
+#define BLE_DEFAULT_MTU         23     // ATT default before MTU exchange
+#define BLE_PREFERRED_MTU       247    // Largest MTU requested from the central
+
+// Raw waveform streaming (only active while a client has notifications enabled)
+#define WAVE_STREAM_IR          0x01
+#define WAVE_STREAM_GSR         0x02
+#define WAVE_HEADER_SIZE        9      // type + sequence (2) + count + interval + first sample (4)
+#define WAVE_MAX_DELTA_SIZE     5      // Worst-case zigzag varint for a 32-bit delta
+#define WAVE_IR_INTERVAL_MS     20     // IR streamed at the 50Hz acquisition rate (default)
+#define WAVE_GSR_INTERVAL_MS    100    // GSR decimated to 10Hz (slow-moving signal)
+#define WAVE_MAX_LATENCY        250    // Flush partial packets at least 4 times per second (ms)
+
+struct WaveStream {
+  uint8_t type;
+  uint8_t intervalMs;
+  uint16_t sequence;         // Per-stream packet counter so the host can detect drops
+  uint8_t count;             // Samples in current packet
+  uint8_t length;            // Bytes used in buffer
+  int32_t lastValue;         // Previous sample for delta encoding
+  unsigned long startMillis; // When current packet was started
+  uint8_t buffer[BLE_PREFERRED_MTU - 3];
+};
+WaveStream irWave = {WAVE_STREAM_IR, WAVE_IR_INTERVAL_MS, 0, 0, 0, 0, 0, {}};  // Interval follows TUNE_IR_INTERVAL
+WaveStream gsrWave = {WAVE_STREAM_GSR, WAVE_GSR_INTERVAL_MS, 0, 0, 0, 0, 0, {}};
+bool waveSubscribed = false;  // Any client has the waveform CCCD enabled (via BLE event queue)
+uint16_t waveMTU = BLE_DEFAULT_MTU;  // Smallest MTU among waveform subscribers
+unsigned long lastGSRWaveSample = 0;
+
+// Incremental history sync (command 0x04), streamed over Sync characteristic
+#define DELTA_PACKET_RECORDS    0xD1   // Packet carries changed records
+#define DELTA_PACKET_END        0xD2   // Final packet: current day + latest sequence
+#define DELTA_HEADER_SIZE       2      // type + record count
+#define DELTA_RECORD_SIZE       15     // kind + sequence (4) + 10-byte Today/Week record
+#define DELTA_KIND_HOUR         0x00
+#define DELTA_KIND_DAY          0x01
+
+#define DELTA_PACKET_TLV_RECORDS 0xD3  // Packet carries changed records in TLV encoding
+#define DELTA_TLV_MAX_RECORD    40     // Largest TLV-encoded history record (bytes)
+#define HISTORY_ENCODING_FIXED  0x00   // 10-byte Today/Week record layout
+#define HISTORY_ENCODING_TLV    0x01   // Self-describing TLV fields
+
+// Optional LZ compression of delta sync records (command 0x04 byte [6]).
+// Each packet is compressed on its own, so a lost notification never breaks
+// the packets after it, and RAM use is one fixed raw staging buffer.
+#define DELTA_PACKET_LZ_RECORDS 0xD4   // Packet carries LZ-compressed 0xD1/0xD3 records
+#define DELTA_LZ_HEADER_SIZE    3      // type + record count + uncompressed packet type
+#define DELTA_LZ_MIN_RECORDS    4      // Uncompressed records a packet must hold to use LZ
+#define HISTORY_COMPRESS_NONE   0x00
+#define HISTORY_COMPRESS_LZ     0x01
+#define LZ_MIN_MATCH            3      // Shorter matches cost more than literals
+#define LZ_MAX_MATCH            130    // 7-bit length field + LZ_MIN_MATCH
+#define LZ_MAX_LITERALS         128    // 7-bit literal run field + 1
+#define LZ_WINDOW               256    // 8-bit match offset
+#define LZ_RAW_BUFFER_SIZE      512    // Raw records staged per compressed packet
+
+struct LzEncoder {
+  uint8_t* out;           // Compressed output
+  uint16_t outLength;
+  uint16_t outCapacity;
+  const uint8_t* raw;     // Raw input (also the match window)
+  uint16_t rawLength;     // Raw bytes encoded so far
+  uint16_t literalPos;    // Output index of the open literal run's control byte
+  uint8_t literalCount;   // Literals in the open run (0 = none open)
+};
+
+uint8_t lzRawBuffer[LZ_RAW_BUFFER_SIZE];
+uint8_t bleSyncBuffer[BLE_PREFERRED_MTU - 3];
+
+// Offline buffering: samples recorded while no client is connected, drained
+// over the Sync characteristic on reconnect. RAM block spills to a flash ring.
+#define OFFLINE_SAMPLE_INTERVAL 10000  // One sample every 10 seconds while disconnected
+#define OFFLINE_SAMPLE_SIZE     11     // uptime seconds (4) + 7-byte live sample
+#define OFFLINE_BLOCK_SAMPLES   64     // Samples per RAM block / flash blob (~10 minutes)
+#define OFFLINE_FLASH_BLOCKS    8      // Flash ring size (~85 minutes); oldest dropped when full
+#define OFFLINE_PACKET_DATA     0xF1   // Drain packet carrying samples
+#define OFFLINE_PACKET_END      0xF2   // Drain finished
+#define OFFLINE_HEADER_SIZE     6      // type + count + device uptime seconds (4)
+
+uint8_t offlineRam[OFFLINE_BLOCK_SAMPLES * OFFLINE_SAMPLE_SIZE];
+uint8_t offlineRamCount = 0;           // Samples in RAM block (or loaded block while draining)
+uint8_t offlineFlashHead = 0;          // Oldest flash block slot
+uint8_t offlineFlashCount = 0;         // Flash blocks in use
+unsigned long lastOfflineSample = 0;
+
+bool offlineDrainActive = false;
+uint8_t offlineDrainClient = 0;        // Client the drain is sent to (first Sync subscriber)
+uint8_t offlineDrainCursor = 0;        // Next sample of loaded block to send
+uint16_t offlineDrainSent = 0;         // Samples delivered in this drain
+uint8_t offlineDrainSkip = 0;          // Samples of the oldest block an interrupted drain already sent
+
+// ===========================================
+// TLV PROTOCOL
+// ===========================================
+// Versioned, self-describing encoding for live and history payloads.
+// Each field is [tag][length][value, little-endian]; clients skip unknown tags,
+// so new metrics can be added without breaking older apps.
+#define TLV_PROTOCOL_VERSION    0x01
+#define TLV_LIVE_FRAME          0xE1   // First byte of TLV live frames
+
+// Live field tags (0x01-0x1F, mask bit = tag)
+#define TLV_LIVE_STRESS         0x01   // u8  stress index (recording path)
+#define TLV_LIVE_HR             0x02   // u8  heart rate BPM
+#define TLV_LIVE_HRV            0x03   // u16 RMSSD in ms
+#define TLV_LIVE_GSR            0x04   // u16 smoothed GSR ADC value
+#define TLV_LIVE_STATUS         0x05   // u8  legacy status bit flags
+#define TLV_LIVE_STRESS_DISPLAY 0x06   // u8  stress index (display path)
+#define TLV_LIVE_ACTIVITY       0x07   // u8  activity level (0-3)
+#define TLV_LIVE_MOTION_VAR     0x08   // u16 motion variance x1000
+#define TLV_LIVE_HRV_BASELINE   0x09   // u16 long-term HRV baseline in ms
+#define TLV_LIVE_RAW_GSR        0x0A   // u16 latest raw GSR ADC value
+#define TLV_LIVE_RAW_IR         0x0B   // u32 latest raw IR value
+#define TLV_LIVE_TIMESTAMP      0x0C   // u32 device millis()
+
+// History field tags (0x21-0x3F, mask bit = tag - 0x20)
+#define TLV_HIST_HOUR           0x21   // u8  hour (0-23), hourly records
+#define TLV_HIST_DAY            0x22   // u8  day slot (0-6), daily records
+#define TLV_HIST_AVG_STRESS     0x23   // u8
+#define TLV_HIST_PEAK_STRESS    0x24   // u8
+#define TLV_HIST_PEAK_HOUR      0x25   // u8  daily records
+#define TLV_HIST_HIGH_MINS      0x26   // u8  minutes above 70% stress
+#define TLV_HIST_AVG_HR         0x27   // u8
+#define TLV_HIST_AVG_HRV        0x28   // u16
+#define TLV_HIST_AVG_GSR        0x29   // u16 hourly records
+#define TLV_HIST_SAMPLE_COUNT   0x2A   // u16 hourly records
+#define TLV_HIST_ACTIVITY       0x2B   // u8  hourly records
+#define TLV_HIST_VALID          0x2C   // u8  1 = record has data
+
+// Capabilities characteristic tags
+#define TLV_CAP_LIVE_FIELDS     0x01   // List of supported live field tags
+#define TLV_CAP_HIST_FIELDS     0x02   // List of supported history field tags
+#define TLV_CAP_COMMANDS        0x03   // List of supported command bytes
+#define TLV_CAP_LIVE_MODES      0x04   // List of supported live modes
+#define TLV_CAP_LIVE_RATES      0x05   // min Hz, max Hz
+#define TLV_CAP_WAVE_STREAMS    0x06   // (stream type, interval ms) pairs
+#define TLV_CAP_MTU             0x07   // u16 preferred MTU
+#define TLV_CAP_COMPRESSION     0x08   // List of supported history compression modes
+
+// Stats characteristic tags (counters since boot)
+#define TLV_STAT_LIVE_SENT       0x01  // u32 legacy live notifications sent
+#define TLV_STAT_LIVE_SUPPRESSED 0x02  // u32 legacy live samples suppressed as unchanged
+#define TLV_STAT_EVENTS_DROPPED  0x03  // u16 BLE events dropped (queue full)
+#define TLV_STAT_SEND_DEPTH      0x04  // u8  notifications waiting in send queues now
+#define TLV_STAT_SEND_HIGH       0x05  // u8  deepest any send queue has been
+#define TLV_STAT_SEND_DROPPED    0x06  // u32 notifications dropped (queue full or stuck)
+#define TLV_STAT_SEND_COALESCED  0x07  // u32 live packets replaced by a newer one while queued
+#define TLV_STAT_SEND_RETRIES    0x08  // u32 notifications the stack rejected and were retried
+#define TLV_STAT_RENDER_FPS      0x09  // u8  display frames drawn in the last second
+#define TLV_STAT_FRAMES_DEFERRED 0x0A  // u32 display frames deferred for a sensor read
+#define TLV_STAT_AWAKE_PERMILLE  0x0B  // u16 share of the last second loop() was not idle (0-1000)
+#define TLV_STAT_IR_LATE_MAX     0x0C  // u16 worst IR sample lateness in ms
+
+const uint8_t TLV_LIVE_FIELDS[] = {
+  TLV_LIVE_STRESS, TLV_LIVE_HR, TLV_LIVE_HRV, TLV_LIVE_GSR, TLV_LIVE_STATUS,
+  TLV_LIVE_STRESS_DISPLAY, TLV_LIVE_ACTIVITY, TLV_LIVE_MOTION_VAR,
+  TLV_LIVE_HRV_BASELINE, TLV_LIVE_RAW_GSR, TLV_LIVE_RAW_IR, TLV_LIVE_TIMESTAMP
+};
+const uint8_t TLV_HIST_FIELDS[] = {
+  TLV_HIST_HOUR, TLV_HIST_DAY, TLV_HIST_AVG_STRESS, TLV_HIST_PEAK_STRESS,
+  TLV_HIST_PEAK_HOUR, TLV_HIST_HIGH_MINS, TLV_HIST_AVG_HR, TLV_HIST_AVG_HRV,
+  TLV_HIST_AVG_GSR, TLV_HIST_SAMPLE_COUNT, TLV_HIST_ACTIVITY, TLV_HIST_VALID
+};
+const uint8_t SUPPORTED_COMMANDS[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A};
+
+uint8_t bleCapsBuffer[96];
+uint8_t bleStatsBuffer[64];
+uint8_t bleLiveTlvBuffer[BLE_PREFERRED_MTU - 3];
+
+// Connection parameter policy: fast interval for bulk transfers, long interval
+// with slave latency for 1Hz live updates (interval units 1.25ms, timeout units 10ms)
+#define CONN_PROFILE_NONE       0
+#define CONN_PROFILE_FAST       1      // Bulk sync, history reads, waveform streaming
+#define CONN_PROFILE_IDLE       2      // Live updates only
+#define CONN_FAST_MIN_INTERVAL  6      // 7.5ms
+#define CONN_FAST_MAX_INTERVAL  12     // 15ms
+#define CONN_FAST_LATENCY       0
+#define CONN_FAST_TIMEOUT       400    // 4s
+#define CONN_IDLE_MIN_INTERVAL  80     // 100ms
+#define CONN_IDLE_MAX_INTERVAL  160    // 200ms
+#define CONN_IDLE_LATENCY       4      // Radio may sleep through 4 events with nothing to send
+#define CONN_IDLE_TIMEOUT       600    // 6s (must exceed (1 + latency) * interval * 2)
+#define CONN_STARTUP_FAST_MS    5000   // Stay fast for service discovery and initial reads
+#define CONN_FAST_LINGER_MS     2000   // Hold fast after bulk activity to avoid thrashing
+#define CONN_UPDATE_MIN_GAP_MS  1000   // Rate limit for parameter update requests
+
+// Change-driven legacy live notifications: a sample is only sent when a field
+// moved past its deadband since the last sent sample, the status byte changed,
+// or the keepalive interval elapsed (deadbands and keepalive are tunables).
+// The last sent sample is tracked per client.
+uint32_t liveNotifySent = 0;
+uint32_t liveNotifySuppressed = 0;
+
+// Connectionless broadcast: a live summary in the advertising manufacturer
+// data, so one passive scanner can watch many wearers without connecting.
+// Enabled by a non-zero TUNE_BROADCAST_PERIOD (payload refresh interval).
+#define BROADCAST_COMPANY_ID    0xFFFF  // Bluetooth SIG id reserved for testing
+#define BROADCAST_FORMAT        0x01
+#define BROADCAST_SIZE          11      // company id (2) + format + sequence + 7-byte live sample
+uint8_t broadcastBuffer[BROADCAST_SIZE];
+uint8_t broadcastSequence = 0;        // Lets scanners tell fresh payloads from repeats
+bool broadcastActive = false;         // Manufacturer data currently advertised
+unsigned long lastBroadcastUpdate = 0;
+
+// Time spent handing notifications to the stack, logged per connection
+// so backends can be compared on the same workload
+uint32_t notifyCalls = 0;
+uint32_t notifyTotalUs = 0;
+uint32_t notifyMaxUs = 0;
 
 // BLE data buffers (global scope to avoid stack overflow)
 uint8_t bleTodayBuffer[240];  // 24 hours × 10 bytes
 uint8_t bleWeekBuffer[70];    // 7 days × 10 bytes
-bool bleHistoryDirty = true;  // Triggers rebuild on next read
+uint32_t bleHistoryVersion = 1;       // Bumped by loop() when history changes
+uint32_t bleHistoryPackedVersion = 0; // bleHistoryVersion last packed into Today/Week
+uint32_t bleHistoryPackedSeq = 0;     // historySeq last packed into Today/Week
+
+// ===========================================
+// BLE CLIENTS
+// ===========================================
+// Several centrals (e.g. phone and desktop) can be connected at once. Each
+// has its own subscriptions, MTU, live mode and sync progress; history,
+// tunables and the waveform streams are shared. The backend assigns a slot
+// when a central connects and the transport addresses clients by slot index.
+#define BLE_MAX_CLIENTS         3      // NimBLE's default connection limit
+#define ADVERTISING_RESTART_MS  500    // Let a connection change settle before advertising again
+
+// Notification flow control: packets wait in a per-client queue and are
+// handed to the stack only while it has room (fewer than BLE_MAX_IN_FLIGHT
+// notifications not yet reported sent, and no congestion reported), so
+// streams run at the link's real rate instead of overflowing stack buffers.
+// Live packets coalesce (the newest sample replaces a queued one); bulk
+// producers only pack a packet when the queue has room.
+#define BLE_SEND_QUEUE_SIZE     6      // Packets queued per client
+#define BLE_MAX_IN_FLIGHT       4      // Notifications handed to the stack awaiting completion
+#define BLE_SEND_TIMEOUT_MS     2000   // Drop a packet the stack keeps rejecting
+#define BLE_COMPLETION_TIMEOUT_MS 500  // Assume completions were lost if none arrive while full
+
+struct BleSendSlot {
+  uint8_t channel;
+  bool coalesce;                       // May be replaced by a newer packet on the same channel
+  uint16_t length;
+  unsigned long queuedMillis;
+  uint8_t data[BLE_PREFERRED_MTU - 3];
+};
+
+struct BleClient {
+  bool connected;
+  uint8_t peerAddress[6];
+  uint16_t mtu;
+  uint16_t subscriptions;              // Bit per BLE_CHANNEL_* with notifications enabled
+  
+  // Live stream (commands 0x03 and 0x05)
+  uint8_t liveMode;
+  uint16_t liveSampleIntervalMs;
+  unsigned long lastLiveSample;
+  unsigned long lastBLENotify;
+  uint32_t liveFieldMask;              // Fields the app asked for; all until it narrows them
+  uint32_t historyFieldMask;
+  uint8_t liveBatchBuffer[BLE_PREFERRED_MTU - 3];  // Payload is capped at MTU - 3 bytes of ATT header
+  uint8_t liveBatchCount;
+  unsigned long liveBatchStartMillis;
+  uint8_t lastSentLive[7];             // Last legacy sample sent (change-driven notifications)
+  bool lastSentLiveValid;              // false forces the next sample out
+  unsigned long lastLiveSentMillis;
+  
+  // Delta sync (command 0x04)
+  uint32_t deltaSyncFromSeq;           // App's last-seen sequence number
+  uint8_t deltaSyncEncoding;
+  uint8_t deltaSyncCompression;
+  int deltaSyncCursor;                 // Next record slot to examine (-1 = no sync in progress)
+  
+  // Connection parameter policy
+  uint8_t connProfile;                 // Last requested profile
+  unsigned long connectedAtMillis;
+  unsigned long lastBulkActivity;
+  unsigned long lastConnParamRequest;
+  
+  // Written from the BLE stack context
+  volatile uint16_t connInterval;      // Parameters in use, as reported by the controller
+  volatile uint16_t connLatency;
+  volatile uint16_t connTimeout;
+  volatile unsigned long lastHistoryRead;  // Set when Today/Week are read
+  // Precise time sync (command 0x08)
+  uint8_t timeSyncRoundsLeft;
+  unsigned long timeSyncStartMillis;
+  bool timeSyncAwaiting;               // Request sent, waiting for command 0x09
+  unsigned long timeSyncSentMillis;    // T1 of the outstanding request
+  uint16_t timeSyncBestRoundTrip;      // 0xFFFF until a round completes
+  int64_t timeSyncBestOffset;          // UTC minus uptime (us) of the best round
+  uint64_t timeSyncBestUptime;         // T4 of the best round (us)
+  
+  volatile uint32_t notifyCompleted;   // Notifications the stack reports sent
+  volatile bool congested;             // Stack asked to stop sending (Bluedroid)
+  
+  // Send queue (see BLE_SEND_QUEUE_SIZE)
+  BleSendSlot sendQueue[BLE_SEND_QUEUE_SIZE];
+  uint8_t sendHead;
+  uint8_t sendCount;
+  uint32_t notifySent;                 // Notifications handed to the stack
+  uint32_t completedDeficit;           // Completions presumed lost (set on a timeout)
+  unsigned long lastSendMillis;
+};
+
+BleClient bleClients[BLE_MAX_CLIENTS];
+uint8_t bleClientCount = 0;
+uint8_t bleServiceStart = 0;           // Rotates so no client is always served first
+uint8_t bleBulkNext = 0;               // Next client allowed a delta sync packet
+bool advertisingActive = false;
+bool advertisingRestartPending = false;
+unsigned long connectionChangedAt = 0;
+
+// Send queue counters since boot (Stats characteristic)
+uint8_t bleSendHighWater = 0;
+uint32_t bleSendDropped = 0;
+uint32_t bleSendCoalesced = 0;
+uint32_t bleSendRetries = 0;
+
+// ===========================================
+// BLE EVENT QUEUE
+// ===========================================
+// BLE callbacks run in the Bluetooth stack's task. They only copy their
+// payload into this lock-free single-producer/single-consumer ring, and
+// loop() applies it, so firmware state is only ever modified from one context.
+#define BLE_EVENT_QUEUE_SIZE    16     // Must be a power of two
+#define BLE_EVENT_MAX_LENGTH    20     // Largest payload (default ATT write size)
+
+#define BLE_EVENT_COMMAND         0x01  // App write to Command characteristic
+#define BLE_EVENT_CONNECTED       0x02  // Payload: peer address (6)
+#define BLE_EVENT_DISCONNECTED    0x03
+#define BLE_EVENT_MTU             0x04  // Payload: MTU (16-bit little-endian)
+#define BLE_EVENT_SUBSCRIBE       0x05  // Payload: channel, 1 = notifications enabled
+
+struct BleEvent {
+  uint8_t client;   // Slot of the connection the event belongs to
+  uint8_t type;
+  unsigned long receivedMillis;  // When the BLE callback queued it
+  uint8_t length;
+  uint8_t data[BLE_EVENT_MAX_LENGTH];
+};
+
+BleEvent bleEventQueue[BLE_EVENT_QUEUE_SIZE];
+std::atomic<uint8_t> bleEventHead(0);    // Next slot to read (written by loop only)
+std::atomic<uint8_t> bleEventTail(0);    // Next slot to write (written by BLE task only)
+volatile uint16_t bleEventsDropped = 0;  // Queue full or oversized payload
 
 // ===========================================
 // TIME SYNCHRONIZATION
 // ===========================================
-// Maintains current time via BLE sync + millis() offset
-// Avoids need for RTC hardware while providing accurate hourly rollups
+// Keeps UTC as microseconds since 1970-01-01 on a 64-bit uptime clock
+// (esp_timer), so no RTC is needed and the date keeps advancing over any
+// uptime. Local time adds the zone offset from command 0x0A, including
+// daylight saving time by rule. Calendar fields are cached in localTime and
+// recomputed by updateClock() only when a second boundary passes (date only
+// when the day changes, DST only when the UTC hour changes), so reading the
+// time is a field access.
+//
+// Command 0x01 sets whole local seconds. Command 0x08 runs an NTP-style
+// exchange over the Command and Sync characteristics:
+//   device -> app  (Sync notify)  TIME_PACKET_REQUEST with device time T1
+//   app -> device  (command 0x09) T1 echo, app UTC receive time T2, turnaround T3-T2
+// The device stamps the reply's arrival (T4) in the BLE callback, so
+//   offset = ((T2 - T1) + (T3 - T4)) / 2,  round trip = (T4 - T1) - (T3 - T2)
+// and keeps the round with the shortest round trip. Slave latency delays the
+// app's reply but not the request, so rounds wait for the fast connection
+// profile (requested while a sync runs) to keep the two legs alike. Offsets
+// measured at least TIME_DRIFT_MIN_SPAN_MS apart give the crystal error,
+// which is learned into driftPpb (persisted) and applied to all elapsed time.
+#define TIME_PACKET_REQUEST     0xE1   // Sync notify: [type, T1 device ms (u32)]
+#define TIME_SYNC_ROUNDS        4      // Exchanges per command 0x08
+#define TIME_SYNC_TIMEOUT_MS    1000   // Give up on a round without a reply
+#define TIME_SYNC_SETTLE_MS     3000   // Longest wait for the fast profile before starting
+#define TIME_DRIFT_MIN_SPAN_MS  1800000  // Learn drift only over 30+ minutes
+#define TIME_DRIFT_MAX_PPB      200000   // Clamp learned drift to +-200 ppm
+
+// Daylight saving rules (command 0x0A)
+#define DST_RULE_NONE           0      // Fixed offset; app resends when it changes
+#define DST_RULE_EU             1      // Last Sunday of March to last Sunday of October, 01:00 UTC
+#define DST_RULE_US             2      // Second Sunday of March to first Sunday of November, 02:00 local
+
 struct SyncedTime {
+  uint64_t epochUsAtSync;      // UTC at the reference point
+  uint64_t uptimeUsAtSync;     // uptimeMicros() at the reference point
+  int32_t driftPpb;            // Crystal error: wall time gained per 1e9 uptime
+  uint16_t roundTripMs;        // Best round trip of the last precise sync
+  bool isValid;                // False until first BLE time sync
+  
+  // Last precise measurement not yet used for drift learning
+  bool driftBaseValid;
+  uint64_t driftBaseUptime;
+  uint64_t driftBaseEpoch;
+};
+
+SyncedTime syncedTime = {0, 0, 0, 0, false, false, 0, 0};
+
+struct TimeZone {
+  int16_t standardOffsetMin;   // UTC offset outside daylight saving time
+  uint8_t dstOffsetMin;        // Added while daylight saving time is in effect
+  uint8_t dstRule;             // DST_RULE_*
+};
+
+TimeZone timeZone = {0, 0, DST_RULE_NONE};
+
+// Cached local calendar fields (see updateClock)
+struct LocalClock {
+  uint64_t nextUpdateUs;       // Uptime at which the cached second ends
+  uint32_t utcHour;            // UTC hours since 1970 the offset was chosen for
+  int16_t utcOffsetMin;        // Zone offset in effect
+  uint32_t dayNumber;          // Local days since 1970
+  uint16_t year;
+  uint8_t month;
+  uint8_t day;
+  uint8_t weekday;             // 0 = Sunday
   uint8_t hour;
   uint8_t minute;
   uint8_t second;
-  uint8_t day;
-  uint8_t month;
-  uint16_t year;
-  unsigned long millisAtSync;  // Reference point for millis() calculations
-  bool isValid;                // False until first BLE time sync
 };
 
-SyncedTime syncedTime = {0, 0, 0, 1, 1, 2025, 0, false};
+LocalClock localTime = {0, 0xFFFFFFFF, 0, 0xFFFFFFFF, 1970, 1, 1, 4, 0, 0, 0};
 
 // ===========================================
 // MOTION DETECTION (MPU6050)
@@ -90,6 +664,13 @@ enum ActivityLevel {
 ActivityLevel currentActivity = STILL;
 bool motionDetected = false;
 
+// Wrist raise: the display face (+Z) turns up and stays up briefly after
+// pointing elsewhere. Consumed by updateDisplayPower().
+#define WRIST_FACE_UP_G      0.80   // Minimum +Z acceleration (g) when facing up
+#define WRIST_TILT_G         0.50   // Maximum X/Y acceleration (g) when facing up
+#define WRIST_RAISE_HOLD_MS  250
+bool wristRaiseDetected = false;
+
 // Rolling buffer for motion variance calculation
 #define MOTION_BUFFER_SIZE 50  // 1 second at 50Hz sampling - balances responsiveness with noise filtering
 float motionBuffer[MOTION_BUFFER_SIZE];
@@ -120,7 +701,12 @@ struct HourlySummary {
 #define DAYS_TO_STORE 7
 HourlySummary todayData[HOURS_PER_DAY];
 uint8_t currentDay = 0;  // Index 0-6 for rotating weekly storage
-uint8_t lastSyncedDay = 0;  // Track last synced day for rollover detection
+uint32_t lastSyncedDay = 0;  // Days since 1970 of the synced clock, for rollover detection
+
+// Monotonic sequence numbers for incremental sync - bumped whenever a stored record changes
+uint32_t historySeq = 0;              // Latest sequence number issued (persisted)
+uint32_t todaySeq[HOURS_PER_DAY];     // Last-change sequence per hour of the current day
+uint32_t daySeq[DAYS_TO_STORE];       // Last-change sequence per stored day
 
 // Real-time accumulator for current hour
 struct HourlyAccumulator {
@@ -144,9 +730,27 @@ unsigned long lastHourCheck = 0;
 // ===========================================
 // UI STATE MANAGEMENT
 // ===========================================
-enum State { DASHBOARD, BREATHE, INFO };
+enum State { DASHBOARD, BREATHE, INFO, TREND };
 State currentState = DASHBOARD;
 
+// Trend screen geometry: one column per hour for the average stress
+// sparkline (top) and the minutes-above-70% bars (bottom). Heights are
+// cached and only recomputed when a todayData bucket changes (historySeq),
+// the hour rolls over, or the live hour's value moves by a pixel.
+#define TREND_LEFT           4
+#define TREND_PITCH          5      // Pixels per hour (4px bar + 1px gap)
+#define TREND_SPARK_BASE     36     // Sparkline baseline row
+#define TREND_SPARK_HEIGHT   24     // Pixels for 100% stress
+#define TREND_MARKER_Y       38     // Current-hour marker row
+#define TREND_BAR_BASE       63     // Bar baseline row
+#define TREND_BAR_HEIGHT     22     // Pixels for 60 minutes above 70%
+
+uint8_t trendSpark[HOURS_PER_DAY];  // Cached heights, SCENE_NO_VALUE = no data
+uint8_t trendBars[HOURS_PER_DAY];
+uint32_t trendSeq = 0;              // historySeq the cache was built from
+int trendHour = -2;                 // currentHour the cache was built for
+uint16_t trendVersion = 0;          // Bumped whenever the cached geometry changes
+
 unsigned long lastDebounceTime = 0;
 bool systemReady = false;
 int buttonState = HIGH;
@@ -154,7 +758,36 @@ int lastButtonState = HIGH;
 
 unsigned long buttonPressStartTime = 0;
 bool buttonHeldForPowerOff = false;
-bool devicePoweredOff = false;
+
+// ===========================================
+// POWER OFF (DEEP SLEEP)
+// ===========================================
+// Power-off is deep sleep with a GPIO wake on the button (GPIO3 is one of
+// the C3's deep-sleep wake pins). Waking is a reset, so setup() checks the
+// wake cause and only boots once the button has been held for
+// POWER_HOLD_MS; a shorter press goes straight back to sleep. Flash keeps
+// the history; the clock, the current hour and its accumulator are kept
+// in RTC memory, which survives deep sleep but not a power loss. The RTC
+// clock keeps counting while asleep, so the time is carried over (less
+// accurate than the main crystal; the app's next sync corrects it).
+#define POWER_HOLD_MS        10000       // Hold to power off (from INFO) and to power on
+#define POWER_OFF_MAGIC      0x5356304BUL  // Marks powerOffState as written by enterPowerOff()
+#define MPU_REG_PWR_MGMT_1   0x6B
+#define MPU_PWR_SLEEP        0x40        // PWR_MGMT_1 sleep bit (about 10uA)
+
+struct PowerOffState {
+  uint32_t magic;
+  bool clockValid;
+  uint64_t epochUs;            // UTC when the device went to sleep
+  uint64_t rtcUs;              // rtcMicros() at the same moment
+  uint16_t roundTripMs;
+  int currentHour;
+  uint32_t lastSyncedDay;
+  HourlyAccumulator hourAccum;
+};
+
+RTC_DATA_ATTR PowerOffState powerOffState;
+uint8_t mpuAddress = 0x68;     // Address initMPU() found the MPU6050 at
 
 
 // ===========================================
@@ -172,7 +805,6 @@ const int HRV_WARMUP_COUNT = 20;  // Requires stable beat history
 
 // Adaptive baseline for relative stress calculation
 float longTermHRV = 50.0;         // Starts at typical resting value
-float hrvLearningRate = 0.01;     // Slow adaptation to user's personal baseline
 
 // Activity-stratified HRV baselines (multipliers for each activity level)
 // HRV naturally decreases during physical activity
@@ -223,9 +855,110 @@ int gsrHead = 0, gsrCount = 0;
 float currentGSR = 0;
 float baselineGSR = 0;
 float gsrMaxSwing = 100.0;        // Adapts to user's dynamic range
-const float GSR_ALPHA = 0.01;     // Slow baseline tracking for long-term drift
 int rawGSR = 0;
 
+// ===========================================
+// RUNTIME TUNABLES
+// ===========================================
+// Sampling and algorithm parameters the app can change without reflashing
+// (command 0x06). Values are range-checked, applied immediately and stored
+// in flash. Window sizes may only shrink below the compiled buffer sizes.
+#define TUNE_IR_INTERVAL        0x01   // u16 ms between IR reads (10-100)
+#define TUNE_MOTION_INTERVAL    0x02   // u16 ms between IMU reads (10-200)
+#define TUNE_RR_WINDOW          0x03   // u8  beats in RMSSD window (4-BUFFER_SIZE)
+#define TUNE_MOTION_WINDOW      0x04   // u8  samples in motion variance window (5-MOTION_BUFFER_SIZE)
+#define TUNE_GSR_WINDOW         0x05   // u8  samples in GSR rolling average (1-GSR_BUFFER_SIZE)
+#define TUNE_GSR_ALPHA          0x06   // f32 GSR baseline EMA weight
+#define TUNE_HRV_LEARNING_RATE  0x07   // f32 HRV baseline EMA weight
+#define TUNE_MOTION_THRESHOLD   0x08   // f32 variance flagged as motion
+#define TUNE_ACTIVITY_LIGHT     0x09   // f32 variance for LIGHT activity
+#define TUNE_ACTIVITY_ACTIVE    0x0A   // f32 variance for ACTIVE activity
+#define TUNE_ACTIVITY_EXERCISE  0x0B   // f32 variance for EXERCISE activity
+#define TUNE_NOTIFY_PERIOD      0x0C   // u16 ms between legacy live notifications (100-10000)
+#define TUNE_LIVE_KEEPALIVE     0x0D   // u8  s between live notifications when nothing changes (1-60)
+#define TUNE_DEADBAND_STRESS    0x0E   // u8  stress change ignored (0-20 points)
+#define TUNE_DEADBAND_HR        0x0F   // u8  heart rate change ignored (0-20 BPM)
+#define TUNE_DEADBAND_HRV       0x10   // u8  HRV change ignored (0-50 ms)
+#define TUNE_DEADBAND_GSR       0x11   // u16 GSR change ignored (0-1000 raw)
+#define TUNE_BROADCAST_PERIOD   0x12   // u16 ms between broadcast payload updates (0 = off, 250-10000)
+#define TUNABLES_VERSION        3      // Bump when the stored layout changes
+
+struct Tunables {
+  uint8_t version;
+  uint16_t irIntervalMs;
+  uint16_t motionIntervalMs;
+  uint8_t rrWindow;
+  uint8_t motionWindow;
+  uint8_t gsrWindow;
+  float gsrAlpha;
+  float hrvLearningRate;
+  float motionThreshold;
+  float activityLight;
+  float activityActive;
+  float activityExercise;
+  uint16_t notifyPeriodMs;
+  uint8_t liveKeepaliveS;
+  uint8_t deadbandStress;
+  uint8_t deadbandHR;
+  uint8_t deadbandHRV;
+  uint16_t deadbandGSR;
+  uint16_t broadcastPeriodMs;
+};
+
+const Tunables DEFAULT_TUNABLES = {
+  TUNABLES_VERSION,
+  20,     // 50Hz IR sampling for reliable peak detection
+  20,     // 50Hz motion sampling
+  30,     // RMSSD over the last 30 beats
+  50,     // 1 second of motion at 50Hz
+  50,     // GSR rolling average
+  0.01,   // Slow GSR baseline tracking for long-term drift
+  0.01,   // Slow adaptation to user's personal HRV baseline
+  0.02,   // Motion flag tuned for wrist-worn placement
+  0.005,  // STILL below this
+  0.03,   // LIGHT below this
+  0.15,   // ACTIVE below this, EXERCISE above
+  1000,   // Legacy live samples considered once per second
+  10,     // Keepalive every 10s while readings are steady
+  1,      // Stress moves in whole points
+  1,      // Ignore single-beat HR jitter
+  2,      // RMSSD jitter
+  10,     // ADC noise on the GSR divider
+  0       // Broadcast off; connected app only
+};
+Tunables tunables = DEFAULT_TUNABLES;
+
+// Valid range per tunable; integer tunables travel as integers, the rest as IEEE-754 floats
+struct TunableSpec {
+  uint8_t id;
+  bool isFloat;
+  float minValue;
+  float maxValue;
+};
+const TunableSpec TUNABLE_SPECS[] = {
+  {TUNE_IR_INTERVAL,       false, 10,     100},
+  {TUNE_MOTION_INTERVAL,   false, 10,     200},
+  {TUNE_RR_WINDOW,         false, 4,      BUFFER_SIZE},
+  {TUNE_MOTION_WINDOW,     false, 5,      MOTION_BUFFER_SIZE},
+  {TUNE_GSR_WINDOW,        false, 1,      GSR_BUFFER_SIZE},
+  {TUNE_GSR_ALPHA,         true,  0.0001, 0.5},
+  {TUNE_HRV_LEARNING_RATE, true,  0.0001, 0.5},
+  {TUNE_MOTION_THRESHOLD,  true,  0.001,  1.0},
+  {TUNE_ACTIVITY_LIGHT,    true,  0.0001, 1.0},
+  {TUNE_ACTIVITY_ACTIVE,   true,  0.0001, 1.0},
+  {TUNE_ACTIVITY_EXERCISE, true,  0.0001, 1.0},
+  {TUNE_NOTIFY_PERIOD,     false, 100,    10000},
+  {TUNE_LIVE_KEEPALIVE,    false, 1,      60},
+  {TUNE_DEADBAND_STRESS,   false, 0,      20},
+  {TUNE_DEADBAND_HR,       false, 0,      20},
+  {TUNE_DEADBAND_HRV,      false, 0,      50},
+  {TUNE_DEADBAND_GSR,      false, 0,      1000},
+  {TUNE_BROADCAST_PERIOD,  false, 0,      10000}
+};
+#define TUNABLE_COUNT (sizeof(TUNABLE_SPECS) / sizeof(TUNABLE_SPECS[0]))
+
+uint8_t bleTuneBuffer[1 + TUNABLE_COUNT * 6];
+
 // Motion-aware stress detection variables
 float physiologicalToMotionRatio = 0.0;  // PMR: (HR+GSR change) / motion variance
 float previousHR = 0.0;                  // For tracking HR changes
@@ -250,6 +983,29 @@ int calibrationReadings = 0;
 float stressIndex = 0;           // Data recording value (alpha=0.90)
 float stressIndexDisplay = 0;    // Display value (alpha=0.40, switches to 0.90 during anxiety)
 
+#define GSR_SAMPLE_INTERVAL_MS 20     // GSR read and stress update clock (50Hz)
+unsigned long lastAccumUpdate = 0;
+
+// ===========================================
+// IDLE MANAGEMENT
+// ===========================================
+// loop() blocks until the earliest periodic deadline instead of spinning.
+// With power management enabled in the core (CONFIG_PM_ENABLE, tickless
+// idle), the idle task puts the chip into automatic light sleep while the
+// loop task is blocked; the BLE controller keeps connections through its
+// own sleep clock. BLE callbacks and the button interrupt notify the loop
+// task, so events never wait for the deadline.
+#define IDLE_MIN_SLEEP_MS    2      // Shorter gaps are spent awake
+#define IDLE_MAX_SLEEP_MS    100    // Longest single block (bounds slack timers)
+#define IDLE_WINDOW_MS       1000   // Awake share is measured over this window
+
+TaskHandle_t loopTaskHandle = nullptr;
+bool lightSleepEnabled = false;
+unsigned long idleWindowStart = 0;
+uint32_t idleWindowSleptUs = 0;
+uint16_t awakePermille = 1000;      // Share of the last window spent not blocked
+uint16_t irSampleLateMaxMs = 0;     // Worst IR read lateness against its deadline
+
 // ===========================================
 // FUNCTION PROTOTYPES
 // ===========================================
@@ -267,6 +1023,28 @@ float calculateStressIndex();
 void drawDashboard();
 void drawBreatheMode();
 void drawInfoScreen();
+void drawTrendScreen();
+bool refreshTrendGeometry();
+int liveHourStress();
+void flushDisplay();
+bool addSceneItem(uint8_t kind, uint8_t style, int16_t x, int16_t y, int16_t a, int16_t b);
+uint32_t sceneChecksum();
+void composeDisplayPage(uint8_t page, uint8_t* row);
+void composeFill(uint8_t* row, int16_t top, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color);
+void composeCircle(uint8_t* row, int16_t top, const SceneItem& item, bool filled);
+void composeText(uint8_t* row, int16_t top, const SceneItem& item);
+void composeSeries(uint8_t* row, int16_t top, const SceneItem& item);
+void composeLine(uint8_t* row, int16_t top, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color);
+bool addSceneSeries(uint8_t kind, int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color);
+void sendDisplayCommands(const uint8_t* commands, uint8_t count);
+void renderDisplay(unsigned long now);
+void drawFrame(unsigned long now);
+uint32_t screenModelKey();
+bool sensorReadDueWithin(unsigned long now, uint32_t us);
+void updateDisplayPower(unsigned long now);
+void setDisplayPower(DisplayPower level);
+uint32_t displayTileChecksum(const uint8_t* data);
+void sendDisplayRange(uint8_t page, uint8_t firstColumn, uint8_t lastColumn, const uint8_t* data);
 
 // Storage management
 void initStorage();
@@ -275,15 +1053,100 @@ void loadTodayData();
 void updateHourlyAccumulator();
 void checkHourChange();
 void clearAllData();
+void loadSequenceData();
+void markHourChanged(int hour);
+void markDayReset();
+
+// Runtime tunables
+void loadTunables();
+void saveTunables();
+bool setTunable(uint8_t id, uint32_t value);
+uint32_t getTunable(uint8_t id);
+void restoreDefaultTunables();
+bool tunableInRange(const TunableSpec &spec, uint32_t value);
+float tunableNumber(const TunableSpec &spec, uint32_t value);
+void publishTunables();
+int hrvWarmupCount();
 
 // Time synchronization
-void getCurrentTime(uint8_t &hour, uint8_t &minute, uint8_t &second);
+uint64_t uptimeMicros();
+uint64_t currentEpochMicros(uint64_t uptimeUs);
+void updateClock();
+int16_t zoneOffsetAt(uint64_t utcSeconds);
+int32_t daysFromCivil(uint16_t year, uint8_t month, uint8_t day);
+void civilFromDays(int32_t days, uint16_t &year, uint8_t &month, uint8_t &day);
+int32_t sundayOfMonth(uint16_t year, uint8_t month, int8_t n);
+void setSyncedTime(uint64_t uptimeUs, uint64_t epochUs);
+void applyPreciseTime(uint64_t uptimeUs, int64_t offsetUs, uint16_t roundTripMs);
+void loadTimeZone();
+void logSyncedTime(const char* label);
 
 // BLE communication
 void initBLE();
-void updateBLEData();
+void updateBLEData(uint8_t client);
+bool liveSampleChanged(const BleClient &client, const uint8_t* sample);
+size_t packStats(uint8_t* buffer);
+void updateBroadcast();
+void resetBleClient(BleClient &client);
+bool clientSubscribed(uint8_t client, uint8_t channel);
+bool queueNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length, bool coalesce);
+bool sendQueueHasRoom(uint8_t client);
+void pumpSendQueue(uint8_t client);
+uint8_t sendQueueDepth();
+void updateWaveSubscribers();
+void serviceBleClients(unsigned long now);
+void updateAdvertising();
+bool pushBleEvent(uint8_t client, uint8_t type, const uint8_t* data, size_t length);
+void processBleEvents();
+void handleCommand(uint8_t client, const uint8_t* data, uint8_t length, unsigned long receivedMillis);
+void serviceTimeSync(uint8_t client, unsigned long now);
+void handleTimeSyncReply(uint8_t client, const uint8_t* data, unsigned long receivedMillis);
+void packLiveSample(uint8_t* buffer);
+void addLiveBatchSample(uint8_t client);
+void flushLiveBatch(uint8_t client);
+void addWaveSample(WaveStream &stream, int32_t value);
+void flushWaveStream(WaveStream &stream);
 void packTodayData(uint8_t* buffer);
 void packWeekData(uint8_t* buffer);
+void updateHistoryValues();
+void packHourSummary(int hour, uint8_t* buffer);
+void packDaySummary(int day, uint8_t* buffer);
+void sendDeltaSyncPacket(uint8_t client);
+bool lzEncode(LzEncoder& encoder, uint16_t rawEnd);
+void lzRollback(LzEncoder& encoder, const LzEncoder& saved);
+uint8_t putTlv(uint8_t* buffer, uint8_t tag, uint32_t value, uint8_t size);
+uint8_t putHistTlv(uint8_t* buffer, uint32_t mask, uint8_t tag, uint32_t value, uint8_t size);
+uint8_t packLiveTlvField(uint8_t tag, uint8_t* buffer);
+void sendLiveTlvFrame(uint8_t client);
+uint8_t packHourTlv(int hour, uint32_t mask, uint8_t* buffer);
+uint8_t packDayTlv(int day, uint32_t mask, uint8_t* buffer);
+void buildCapabilities();
+void initOfflineBuffer();
+void updateOfflineBuffer();
+void recordOfflineSample();
+void spillOfflineBlock();
+bool loadOldestOfflineBlock();
+void sendOfflineDrainPacket();
+void stopOfflineDrain();
+uint8_t queuedDrainSamples(uint8_t client);
+void updateConnectionPolicy(uint8_t client);
+
+// BLE transport (implemented by the selected backend; clients are slot indexes)
+void bleTransportInit();
+bool bleNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length);
+void bleSetValue(uint8_t channel, const uint8_t* data, size_t length);
+void bleStartAdvertising();
+void bleStopAdvertising();
+void bleSetBroadcastData(const uint8_t* data, size_t length);
+void bleDisconnect(uint8_t client);
+void bleUpdateConnParams(uint8_t client, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+
+// BLE transport upcalls (called by the backend from the BLE stack context)
+size_t handleBleRead(uint8_t client, uint8_t channel, const uint8_t** data);
+void handleConnParamsUpdated(uint8_t client, uint16_t interval, uint16_t latency, uint16_t timeout);
+void handleNotifyComplete(uint8_t client);
+void handleCongestion(uint8_t client, bool congested);
+void recordNotifyTime(unsigned long startMicros);
 
 // Motion detection
 void initMPU();
@@ -292,115 +1155,18 @@ void updateActivityLevel();
 
 // Power management
 void enterPowerOff();
-void wakeFromPowerOff();
-
-// ===========================================
-// BLE CALLBACKS
-// ===========================================
-class ServerCallbacks : public BLEServerCallbacks {
-  void onConnect(BLEServer* pServer) {
-    deviceConnected = true;
-  }
-  
-  void onDisconnect(BLEServer* pServer) {
-    deviceConnected = false;
-  }
-};
-
-/**
- * BLE callback for Command characteristic - handles app control commands.
- * Command 0x01: Time sync (8 bytes: command + year(2) + month + day + hour + minute + second)
- * Command 0x02: Force history buffer rebuild
- */
-class CommandCallbacks : public BLECharacteristicCallbacks {
-  void onWrite(BLECharacteristic* pCharacteristic) {
-    String value = pCharacteristic->getValue();
-    if (value.length() > 0) {
-      uint8_t command = (uint8_t)value[0];
-      if (command == 0x01) {
-        // Time sync: 8 bytes total
-        // [0] = command (0x01)
-        // [1-2] = year (little-endian, uint16_t)
-        // [3] = month (1-12)
-        // [4] = day (1-31)
-        // [5] = hour (0-23)
-        // [6] = minute (0-59)
-        // [7] = second (0-59)
-        if (value.length() >= 8) {
-          uint16_t year = ((uint16_t)value[2] << 8) | (uint16_t)value[1];
-          uint8_t month = (uint8_t)value[3];
-          uint8_t day = (uint8_t)value[4];
-          uint8_t hour = (uint8_t)value[5];
-          uint8_t minute = (uint8_t)value[6];
-          uint8_t second = (uint8_t)value[7];
-          
-          // Validate time values
-          if (year >= 2024 && year <= 2100 &&
-              month >= 1 && month <= 12 &&
-              day >= 1 && day <= 31 &&
-              hour < 24 && minute < 60 && second < 60) {
-            
-            // Update synced time structure
-            syncedTime.year = year;
-            syncedTime.month = month;
-            syncedTime.day = day;
-            syncedTime.hour = hour;
-            syncedTime.minute = minute;
-            syncedTime.second = second;
-            syncedTime.millisAtSync = millis();
-            syncedTime.isValid = true;
-            lastSyncedDay = day;  // Initialize day tracking
-            
-            // Recalculate current hour based on synced time
-            uint8_t currentH, currentM, currentS;
-            getCurrentTime(currentH, currentM, currentS);
-            currentHour = currentH;
-            
-            Serial.print("Time synced: ");
-            Serial.print(year);
-            Serial.print("-");
-            Serial.print(month);
-            Serial.print("-");
-            Serial.print(day);
-            Serial.print(" ");
-            Serial.print(hour);
-            Serial.print(":");
-            Serial.print(minute);
-            Serial.print(":");
-            Serial.println(second);
-          }
-        }
-      } else if (command == 0x02) {
-        bleHistoryDirty = true;
-      }
-    }
-  }
-};
-
-/**
- * BLE callback for Today characteristic - packs data on-demand.
- * Reduces memory pressure by only packing when app requests data.
- */
-class TodayReadCallback : public BLECharacteristicCallbacks {
-  void onRead(BLECharacteristic* pCharacteristic) {
-    packTodayData(bleTodayBuffer);
-    pCharacteristic->setValue(bleTodayBuffer, 240);
-  }
-};
+void enterDeepSleep();
+bool confirmPowerOn();
+void restorePowerOffState();
+uint64_t rtcMicros();
 
-/**
- * BLE callback for Week characteristic - packs data on-demand.
- * Only rebuilds buffer if data has changed since last read.
- */
-class WeekReadCallback : public BLECharacteristicCallbacks {
-  void onRead(BLECharacteristic* pCharacteristic) {
-    if (bleHistoryDirty) {
-      packWeekData(bleWeekBuffer);
-      bleHistoryDirty = false;
-    }
-    pCharacteristic->setValue(bleWeekBuffer, 70);
-  }
-};
+// Idle management
+void configureIdle();
+void wakeLoop();
+void IRAM_ATTR onButtonLevel();
+uint32_t nextDeadlineMs(unsigned long now);
+uint32_t msUntilDue(unsigned long now, unsigned long last, unsigned long interval);
+void idleUntilNextDeadline();
 
 // ===========================================
 // SETUP
@@ -419,13 +1185,19 @@ void setup() {
   
   pinMode(BUTTON_PIN, INPUT_PULLUP);
   pinMode(VIBRO_MOTOR_PIN, OUTPUT);
+  
+  // Woken from power-off by the button: only a full long press turns it on
+  bool wokeFromPowerOff = (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_GPIO);
+  if (wokeFromPowerOff && !confirmPowerOn()) {
+    enterDeepSleep();
+  }
 
   Wire.begin(6, 7);
   Wire.setClock(1000000);
   delay(200);
 
   int displayAttempts = 0;
-  while (!display.begin(SSD1306_SWITCHCAPVCC, 0x3C) && displayAttempts < 3) {
+  while (!display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS) && displayAttempts < 3) {
     delay(500);
     displayAttempts++;
   }
@@ -443,19 +1215,19 @@ void setup() {
   display.setTextColor(SSD1306_WHITE);
   display.setCursor(20, 25);
   display.print("Initializing...");
-  display.display();
+  flushDisplay();
   delay(500);
 
   display.clearDisplay();
   display.setCursor(20, 25);
   display.print("Init MAX30102...");
-  display.display();
+  flushDisplay();
   
   if (!particleSensor.begin(Wire, I2C_SPEED_STANDARD)) {
     display.clearDisplay();
     display.setCursor(0, 0);
     display.println("Sensor Error!");
-    display.display();
+    flushDisplay();
     hrSensorActive = false;
   } else {
     particleSensor.setup();
@@ -485,6 +1257,9 @@ void setup() {
   }
 
   initStorage();
+  if (wokeFromPowerOff) {
+    restorePowerOffState();
+  }
   initMPU();
   initBLE();
 
@@ -494,6 +1269,8 @@ void setup() {
   currentState = DASHBOARD;
   buttonState = HIGH;
   lastButtonState = HIGH;
+  
+  configureIdle();
 }
 
 // ===========================================
@@ -509,7 +1286,12 @@ void initStorage() {
   preferences.begin("stressview", false);
   
   currentDay = preferences.getUChar("currentDay", 0);
+  syncedTime.driftPpb = preferences.getInt("driftPpb", 0);
+  loadTimeZone();
   loadTodayData();
+  loadSequenceData();
+  initOfflineBuffer();
+  loadTunables();
   
   memset(&hourAccum, 0, sizeof(hourAccum));
   hourAccum.lastMinute = 255;
@@ -533,6 +1315,73 @@ void loadTodayData() {
   }
 }
 
+/**
+ * Load record sequence numbers used for incremental sync.
+ * Per-hour sequences are stored separately from the hourly data ("seq" + day)
+ * so existing flash records keep their layout. On first boot after upgrade,
+ * every record is stamped with sequence 1 so a sync from 0 returns everything.
+ */
+void loadSequenceData() {
+  bool firstBoot = !preferences.isKey("histSeq");
+  historySeq = preferences.getUInt("histSeq", 1);
+  
+  for (int d = 0; d < DAYS_TO_STORE; d++) {
+    uint32_t seqs[HOURS_PER_DAY];
+    String key = "seq" + String(d);
+    
+    if (!firstBoot && preferences.getBytesLength(key.c_str()) == sizeof(seqs)) {
+      preferences.getBytes(key.c_str(), seqs, sizeof(seqs));
+    } else {
+      for (int h = 0; h < HOURS_PER_DAY; h++) seqs[h] = historySeq;
+    }
+    
+    daySeq[d] = 0;
+    for (int h = 0; h < HOURS_PER_DAY; h++) {
+      if (seqs[h] > daySeq[d]) daySeq[d] = seqs[h];
+    }
+    
+    if (d == currentDay) {
+      memcpy(todaySeq, seqs, sizeof(todaySeq));
+    }
+  }
+  
+  if (firstBoot) {
+    preferences.putUInt("histSeq", historySeq);
+  }
+}
+
+/**
+ * Stamp an hour of the current day with a new sequence number.
+ * The owning day's summary changes with it, so it shares the same sequence.
+ * 
+ * @param hour Hour index (0-23) that was modified
+ */
+void markHourChanged(int hour) {
+  historySeq++;
+  todaySeq[hour] = historySeq;
+  daySeq[currentDay] = historySeq;
+  
+  String key = "seq" + String(currentDay);
+  preferences.putBytes(key.c_str(), todaySeq, sizeof(todaySeq));
+  preferences.putUInt("histSeq", historySeq);
+}
+
+/**
+ * Stamp every hour of the current day with one new sequence number.
+ * Used when the day's records are cleared so the app drops stale values.
+ */
+void markDayReset() {
+  historySeq++;
+  for (int h = 0; h < HOURS_PER_DAY; h++) {
+    todaySeq[h] = historySeq;
+  }
+  daySeq[currentDay] = historySeq;
+  
+  String key = "seq" + String(currentDay);
+  preferences.putBytes(key.c_str(), todaySeq, sizeof(todaySeq));
+  preferences.putUInt("histSeq", historySeq);
+}
+
 /**
  * Save accumulated hourly data to flash storage.
  * Calculates averages from the running accumulator and stores them in the
@@ -556,6 +1405,7 @@ void saveHourlyData(int hour) {
   
   String key = "day" + String(currentDay);
   preferences.putBytes(key.c_str(), todayData, sizeof(todayData));
+  markHourChanged(hour);
 }
 
 /**
@@ -566,6 +1416,8 @@ void clearAllData() {
   for (int d = 0; d < DAYS_TO_STORE; d++) {
     String key = "day" + String(d);
     preferences.remove(key.c_str());
+    key = "seq" + String(d);
+    preferences.remove(key.c_str());
   }
   
   memset(todayData, 0, sizeof(todayData));
@@ -573,6 +1425,12 @@ void clearAllData() {
     todayData[i].hour = i;
   }
   
+  // Every cleared record is newer than anything the app has seen
+  markDayReset();
+  for (int d = 0; d < DAYS_TO_STORE; d++) {
+    daySeq[d] = historySeq;
+  }
+  
   memset(&hourAccum, 0, sizeof(hourAccum));
   hourAccum.lastMinute = 255;
 }
@@ -582,85 +1440,305 @@ void clearAllData() {
 // ===========================================
 
 /**
- * Accumulate sensor readings for the current hour.
- * Called every second to build up hourly statistics. Tracks running sums
- * for averages, peak values, and minutes spent in high-stress state.
- * Only operates after calibration is complete.
+ * Initialize offline sample buffer.
+ * Samples are stamped with device uptime, which restarts on reboot, so
+ * blocks left over from a previous boot are discarded rather than sent
+ * with timestamps the app cannot place.
  */
-void updateHourlyAccumulator() {
-  if (!calibrationComplete) return;
-  
-  hourAccum.stressSum += (uint32_t)stressIndex;
-  hourAccum.gsrSum += (uint32_t)currentGSR;
+void initOfflineBuffer() {
+  uint8_t blocks = preferences.getUChar("offCnt", 0);
+  uint8_t head = preferences.getUChar("offHead", 0);
   
-  if (hrSensorActive && currentHR > 0) {
-    hourAccum.hrSum += (uint32_t)currentHR;
-    hourAccum.hrvSum += (uint32_t)currentHRV;
-    hourAccum.hrSampleCount++;
+  for (uint8_t i = 0; i < blocks; i++) {
+    String key = "off" + String((head + i) % OFFLINE_FLASH_BLOCKS);
+    preferences.remove(key.c_str());
   }
   
-  hourAccum.activitySum += (uint32_t)currentActivity;
-  hourAccum.sampleCount++;
-  
-  if ((uint8_t)stressIndex > hourAccum.peakStress) {
-    hourAccum.peakStress = (uint8_t)stressIndex;
+  offlineFlashHead = 0;
+  offlineFlashCount = 0;
+  offlineRamCount = 0;
+  if (blocks > 0) {
+    preferences.putUChar("offHead", 0);
+    preferences.putUChar("offCnt", 0);
   }
+}
+
+/**
+ * Record samples while disconnected and drain them once a client returns.
+ * Called every loop pass after calibration. The drain goes to the first
+ * client subscribed to Sync and waits for that client's delta sync to
+ * finish, since both share the characteristic.
+ */
+void updateOfflineBuffer() {
+  unsigned long now = millis();
   
-  // Track minutes spent in high-stress state (>70% threshold)
-  uint8_t currentMinute;
-  if (syncedTime.isValid) {
-    uint8_t h, m, s;
-    getCurrentTime(h, m, s);
-    currentMinute = m;
-  } else {
-    // Fallback to millis() if time not synced
-    unsigned long currentMillis = millis();
-    currentMinute = (currentMillis / 60000) % 60;
+  if (!deviceConnected) {
+    if (now - lastOfflineSample >= OFFLINE_SAMPLE_INTERVAL) {
+      recordOfflineSample();
+      lastOfflineSample = now;
+    }
+    return;
   }
   
-  if (currentMinute != hourAccum.lastMinute) {
-    if (hourAccum.highStressThisMinute) {
-      hourAccum.highStressMins++;
+  if (!offlineDrainActive) {
+    if (offlineRamCount == 0 && offlineFlashCount == 0) return;
+    
+    uint8_t client = 0;
+    while (client < BLE_MAX_CLIENTS && !clientSubscribed(client, BLE_CHANNEL_SYNC)) client++;
+    if (client == BLE_MAX_CLIENTS) return;
+    if (bleClients[client].deltaSyncCursor >= 0) return;
+    offlineDrainClient = client;
+    
+    // Move RAM samples behind older flash blocks so the drain stays in time order
+    if (offlineRamCount > 0) {
+      spillOfflineBlock();
     }
-    hourAccum.highStressThisMinute = false;
-    hourAccum.lastMinute = currentMinute;
+    offlineDrainActive = true;
+    offlineDrainSent = 0;
+    offlineRamCount = 0;
   }
   
-  if (stressIndex > 70) {
-    hourAccum.highStressThisMinute = true;
-  }
+  if (bleClients[offlineDrainClient].deltaSyncCursor >= 0) return;
+  
+  sendOfflineDrainPacket();
 }
 
 /**
- * Check if hour has changed and handle data rollover.
- * Uses synced time if available (from BLE), otherwise falls back to millis()-based clock.
- * When hour changes, saves accumulated data and resets accumulator. Handles day rollover at midnight.
+ * Append one sample (uptime seconds + 7-byte live sample) to the RAM block.
+ * A full block is written to the flash ring and the RAM block restarts.
  */
-void checkHourChange() {
-  int newHour;
+void recordOfflineSample() {
+  uint8_t* sample = offlineRam + offlineRamCount * OFFLINE_SAMPLE_SIZE;
+  uint32_t uptime = millis() / 1000;
   
-  if (syncedTime.isValid) {
-    // Use synced time (accurate, synced from app)
-    uint8_t h, m, s;
-    getCurrentTime(h, m, s);
-    newHour = h;
-  } else {
-    // Fallback to millis() if time not synced yet
-    unsigned long currentMillis = millis();
-    newHour = (currentMillis / 3600000) % 24;
-    
-    #ifdef DEBUG_FAST_HOURS
-    newHour = (currentMillis / 300000) % 24;
-    #endif
+  sample[0] = (uint8_t)(uptime & 0xFF);
+  sample[1] = (uint8_t)((uptime >> 8) & 0xFF);
+  sample[2] = (uint8_t)((uptime >> 16) & 0xFF);
+  sample[3] = (uint8_t)((uptime >> 24) & 0xFF);
+  packLiveSample(sample + 4);
+  offlineRamCount++;
+  
+  if (offlineRamCount >= OFFLINE_BLOCK_SAMPLES) {
+    spillOfflineBlock();
+    offlineRamCount = 0;
+  }
+}
+
+/**
+ * Write the RAM block to the next flash ring slot (dropping the oldest
+ * block if the ring is full). Blob length encodes the sample count.
+ */
+void spillOfflineBlock() {
+  if (offlineFlashCount >= OFFLINE_FLASH_BLOCKS) {
+    offlineFlashHead = (offlineFlashHead + 1) % OFFLINE_FLASH_BLOCKS;
+    offlineFlashCount--;
   }
   
-  if (currentHour == -1) {
-    currentHour = newHour;
-  } else if (newHour != currentHour) {
-    int oldHour = currentHour;
+  uint8_t slot = (offlineFlashHead + offlineFlashCount) % OFFLINE_FLASH_BLOCKS;
+  String key = "off" + String(slot);
+  preferences.putBytes(key.c_str(), offlineRam, offlineRamCount * OFFLINE_SAMPLE_SIZE);
+  
+  offlineFlashCount++;
+  preferences.putUChar("offHead", offlineFlashHead);
+  preferences.putUChar("offCnt", offlineFlashCount);
+}
+
+/**
+ * Load the oldest flash block into the RAM block for draining.
+ * 
+ * @return false if no blocks remain
+ */
+bool loadOldestOfflineBlock() {
+  while (offlineFlashCount > 0) {
+    String key = "off" + String(offlineFlashHead);
+    size_t len = preferences.getBytes(key.c_str(), offlineRam, sizeof(offlineRam));
     
-    saveHourlyData(currentHour);
-    bleHistoryDirty = true;
+    offlineRamCount = len / OFFLINE_SAMPLE_SIZE;
+    offlineDrainCursor = min(offlineDrainSkip, offlineRamCount);
+    offlineDrainSkip = 0;
+    if (offlineRamCount > 0) return true;
+    
+    // Empty or unreadable blob - skip it
+    preferences.remove(key.c_str());
+    offlineFlashHead = (offlineFlashHead + 1) % OFFLINE_FLASH_BLOCKS;
+    offlineFlashCount--;
+  }
+  
+  preferences.putUChar("offHead", offlineFlashHead);
+  preferences.putUChar("offCnt", offlineFlashCount);
+  return false;
+}
+
+/**
+ * Queue the next offline drain packet for the Sync characteristic.
+ * A packet is only built when the client's send queue has room, so the
+ * drain runs at the rate the link drains the queue and the cursor never
+ * skips samples. A block is removed from flash only after all of its
+ * samples have left the send queue, so an interrupted drain only has to
+ * resend what was still queued (see stopOfflineDrain).
+ * 
+ * Data packet:
+ *   [0] type (0xF1)
+ *   [1] sample count
+ *   [2-5] current device uptime in seconds (32-bit little-endian)
+ *   Per sample (11 bytes):
+ *     [0-3] device uptime in seconds when recorded (32-bit little-endian)
+ *     [4-10] 7-byte live sample (same layout as legacy live packet)
+ * 
+ * End packet:
+ *   [0] type (0xF2)
+ *   [1-2] samples delivered in this drain (16-bit little-endian)
+ */
+void sendOfflineDrainPacket() {
+  BleClient &client = bleClients[offlineDrainClient];
+  unsigned long now = millis();
+  
+  if (!sendQueueHasRoom(offlineDrainClient)) return;
+  
+  // Whole block sent - release its flash slot
+  if (offlineRamCount > 0 && offlineDrainCursor >= offlineRamCount) {
+    if (queuedDrainSamples(offlineDrainClient) > 0) return;
+    String key = "off" + String(offlineFlashHead);
+    preferences.remove(key.c_str());
+    offlineFlashHead = (offlineFlashHead + 1) % OFFLINE_FLASH_BLOCKS;
+    offlineFlashCount--;
+    preferences.putUChar("offHead", offlineFlashHead);
+    preferences.putUChar("offCnt", offlineFlashCount);
+    offlineRamCount = 0;
+  }
+  
+  if (offlineRamCount == 0) {
+    if (!loadOldestOfflineBlock()) {
+      bleSyncBuffer[0] = OFFLINE_PACKET_END;
+      bleSyncBuffer[1] = (uint8_t)(offlineDrainSent & 0xFF);
+      bleSyncBuffer[2] = (uint8_t)((offlineDrainSent >> 8) & 0xFF);
+      queueNotify(offlineDrainClient, BLE_CHANNEL_SYNC, bleSyncBuffer, 3, false);
+      
+      offlineDrainActive = false;
+      offlineRamCount = 0;
+      return;
+    }
+  }
+  
+  uint16_t payloadSize = min((int)client.mtu, BLE_PREFERRED_MTU) - 3;
+  uint8_t count = min((payloadSize - OFFLINE_HEADER_SIZE) / OFFLINE_SAMPLE_SIZE,
+                      offlineRamCount - offlineDrainCursor);
+  uint32_t uptime = now / 1000;
+  
+  bleSyncBuffer[0] = OFFLINE_PACKET_DATA;
+  bleSyncBuffer[1] = count;
+  bleSyncBuffer[2] = (uint8_t)(uptime & 0xFF);
+  bleSyncBuffer[3] = (uint8_t)((uptime >> 8) & 0xFF);
+  bleSyncBuffer[4] = (uint8_t)((uptime >> 16) & 0xFF);
+  bleSyncBuffer[5] = (uint8_t)((uptime >> 24) & 0xFF);
+  memcpy(bleSyncBuffer + OFFLINE_HEADER_SIZE,
+         offlineRam + offlineDrainCursor * OFFLINE_SAMPLE_SIZE,
+         count * OFFLINE_SAMPLE_SIZE);
+  
+  if (!queueNotify(offlineDrainClient, BLE_CHANNEL_SYNC, bleSyncBuffer,
+                   OFFLINE_HEADER_SIZE + count * OFFLINE_SAMPLE_SIZE, false)) {
+    return;
+  }
+  
+  offlineDrainCursor += count;
+  offlineDrainSent += count;
+}
+
+/**
+ * End a drain before its end packet (disconnect or Sync unsubscribed).
+ * Samples still in the send queue were never sent; everything before them
+ * in the loaded block is skipped when the next drain reloads that block,
+ * so the app doesn't store them twice.
+ */
+void stopOfflineDrain() {
+  if (!offlineDrainActive) return;
+  
+  if (offlineRamCount > 0) {
+    uint8_t unsent = queuedDrainSamples(offlineDrainClient);
+    offlineDrainSkip = (offlineDrainCursor > unsent) ? offlineDrainCursor - unsent : 0;
+  }
+  offlineDrainActive = false;
+  offlineRamCount = 0;
+}
+
+/**
+ * @return Offline samples in drain packets still waiting in the client's send queue
+ */
+uint8_t queuedDrainSamples(uint8_t client) {
+  const BleClient &c = bleClients[client];
+  uint8_t samples = 0;
+  for (uint8_t i = 0; i < c.sendCount; i++) {
+    const BleSendSlot &slot = c.sendQueue[(c.sendHead + i) % BLE_SEND_QUEUE_SIZE];
+    if (slot.channel == BLE_CHANNEL_SYNC && slot.data[0] == OFFLINE_PACKET_DATA) {
+      samples += slot.data[1];
+    }
+  }
+  return samples;
+}
+
+/**
+ * Accumulate sensor readings for the current hour.
+ * Called every second to build up hourly statistics. Tracks running sums
+ * for averages, peak values, and minutes spent in high-stress state.
+ * Only operates after calibration is complete.
+ */
+void updateHourlyAccumulator() {
+  if (!calibrationComplete) return;
+  
+  hourAccum.stressSum += (uint32_t)stressIndex;
+  hourAccum.gsrSum += (uint32_t)currentGSR;
+  
+  if (hrSensorActive && currentHR > 0) {
+    hourAccum.hrSum += (uint32_t)currentHR;
+    hourAccum.hrvSum += (uint32_t)currentHRV;
+    hourAccum.hrSampleCount++;
+  }
+  
+  hourAccum.activitySum += (uint32_t)currentActivity;
+  hourAccum.sampleCount++;
+  
+  if ((uint8_t)stressIndex > hourAccum.peakStress) {
+    hourAccum.peakStress = (uint8_t)stressIndex;
+  }
+  
+  // Track minutes spent in high-stress state (>70% threshold)
+  // (clock counts from boot until the first sync)
+  uint8_t currentMinute = localTime.minute;
+  
+  if (currentMinute != hourAccum.lastMinute) {
+    if (hourAccum.highStressThisMinute) {
+      hourAccum.highStressMins++;
+    }
+    hourAccum.highStressThisMinute = false;
+    hourAccum.lastMinute = currentMinute;
+  }
+  
+  if (stressIndex > 70) {
+    hourAccum.highStressThisMinute = true;
+  }
+}
+
+/**
+ * Check if hour has changed and handle data rollover.
+ * Uses the local clock, which counts from boot until the first BLE time sync.
+ * When hour changes, saves accumulated data and resets accumulator. Handles day rollover at midnight.
+ */
+void checkHourChange() {
+  int newHour = localTime.hour;
+  
+  #ifdef DEBUG_FAST_HOURS
+  if (!syncedTime.isValid) {
+    newHour = (uptimeMicros() / 300000000ULL) % 24;
+  }
+  #endif
+  
+  if (currentHour == -1) {
+    currentHour = newHour;
+  } else if (newHour != currentHour) {
+    int oldHour = currentHour;
+    
+    saveHourlyData(currentHour);
+    bleHistoryVersion++;
     
     memset(&hourAccum, 0, sizeof(hourAccum));
     hourAccum.lastMinute = 255;
@@ -673,9 +1751,10 @@ void checkHourChange() {
     
     if (syncedTime.isValid) {
       // Use synced time to detect day change
-      if (syncedTime.day != lastSyncedDay) {
+      uint32_t today = localTime.dayNumber;
+      if (today != lastSyncedDay) {
         dayRollover = true;
-        lastSyncedDay = syncedTime.day;
+        lastSyncedDay = today;
       }
     } else {
       // Fallback: detect day rollover from hour change (23 -> 0)
@@ -692,6 +1771,11 @@ void checkHourChange() {
       for (int i = 0; i < HOURS_PER_DAY; i++) {
         todayData[i].hour = i;
       }
+      
+      // Overwrite the recycled slot so the week summary no longer shows its old day
+      String key = "day" + String(currentDay);
+      preferences.putBytes(key.c_str(), todayData, sizeof(todayData));
+      markDayReset();
     }
   }
 }
@@ -707,11 +1791,16 @@ void checkHourChange() {
  */
 void loop() {
   unsigned long currentMillis = millis();
+  
+  // Apply commands and connection events queued by BLE callbacks
+  processBleEvents();
+  updateHistoryValues();
+  updateClock();
 
   // GSR calibration: establish baseline over 5 seconds at startup
   if (!calibrationComplete) {
     if (currentMillis - calibrationStartTime < 5000) {
-      if (currentMillis - lastGSRSampleTime >= 20) {
+      if (currentMillis - lastGSRSampleTime >= GSR_SAMPLE_INTERVAL_MS) {
         rawGSR = analogRead(GSR_PIN);
         calibrationSum += rawGSR;
         calibrationReadings++;
@@ -747,20 +1836,24 @@ void loop() {
         if (buttonState == LOW) {
           buttonPressStartTime = currentMillis;
           buttonHeldForPowerOff = false;
+          buttonWokeDisplay = (displayPower == DISPLAY_BLANK);
+          lastDisplayActivity = currentMillis;
         }
         
         // Button just released (after debounce)
         if (buttonState == HIGH) {
           unsigned long holdDuration = currentMillis - buttonPressStartTime;
           
-          // Short press (less than 10 seconds) = mode change
-          if (holdDuration < 10000 && !devicePoweredOff) {
+          // Short press (less than 10 seconds) = mode change, unless it
+          // only woke the display
+          if (holdDuration < POWER_HOLD_MS && !buttonWokeDisplay) {
             if (currentState == INFO) {
               // From INFO screen, short press returns to DASHBOARD
               currentState = DASHBOARD;
             } else {
-              // From DASHBOARD or BREATHE, cycle between them only (not INFO)
-              currentState = (currentState == DASHBOARD) ? BREATHE : DASHBOARD;
+              // Cycle DASHBOARD -> BREATHE -> TREND (not INFO)
+              currentState = (currentState == DASHBOARD) ? BREATHE :
+                             (currentState == BREATHE) ? TREND : DASHBOARD;
             }
           }
         }
@@ -770,17 +1863,14 @@ void loop() {
       if (buttonState == LOW) {
         unsigned long holdDuration = currentMillis - buttonPressStartTime;
         
-        if (holdDuration >= 10000 && !buttonHeldForPowerOff) {
+        if (holdDuration >= POWER_HOLD_MS && !buttonHeldForPowerOff) {
           buttonHeldForPowerOff = true;
           
-          if (devicePoweredOff) {
-            // Wake up from power off
-            wakeFromPowerOff();
-          } else if (currentState == INFO) {
+          if (currentState == INFO) {
             // From INFO screen, 10-second hold powers off
             enterPowerOff();
           } else {
-            // From DASHBOARD or BREATHE, 10-second hold goes to INFO screen
+            // From the other screens, 10-second hold goes to INFO screen
             currentState = INFO;
           }
         }
@@ -792,76 +1882,418 @@ void loop() {
     digitalRead(BUTTON_PIN);
   }
 
-  // Skip sensor updates when powered off
-  if (!devicePoweredOff) {
-    if (mpuReady && calibrationComplete) {
-      updateMotion();
-      updateActivityLevel();
-    }
+  if (mpuReady && calibrationComplete) {
+    updateMotion();
+    updateActivityLevel();
+  }
 
-    if (hrSensorActive && calibrationComplete) {
-      updateHeartRate();
-    }
+  if (hrSensorActive && calibrationComplete) {
+    updateHeartRate();
+  }
 
-    if (calibrationComplete) {
+  if (calibrationComplete) {
+    // Fixed sample clock, so GSR and stress smoothing don't depend on the loop rate
+    if (currentMillis - lastGSRSampleTime >= GSR_SAMPLE_INTERVAL_MS) {
       updateGSR();
       stressIndex = calculateStressIndex();  // Returns data value, also sets stressIndexDisplay
+      lastGSRSampleTime = currentMillis;
       
       // Haptic feedback for high stress (>80%) at 25% strength - use display value
       analogWrite(VIBRO_MOTOR_PIN, (stressIndexDisplay > 80) ? 64 : 0);  // 25% strength
-      
-      static unsigned long lastAccumUpdate = 0;
-      if (currentMillis - lastAccumUpdate >= 1000) {
-        updateHourlyAccumulator();
-        lastAccumUpdate = currentMillis;
-      }
-      
-      if (deviceConnected && (currentMillis - lastBLENotify >= 1000)) {
-        updateBLEData();
-        lastBLENotify = currentMillis;
-      }
-      
-      // Re-advertise when client disconnects
-      if (!deviceConnected && oldDeviceConnected) {
-        delay(500);
-        BLEDevice::startAdvertising();
-        oldDeviceConnected = deviceConnected;
-      }
-      if (deviceConnected && !oldDeviceConnected) {
-        oldDeviceConnected = deviceConnected;
-      }
     }
+    
+    if (currentMillis - lastAccumUpdate >= 1000) {
+      updateHourlyAccumulator();
+      lastAccumUpdate = currentMillis;
+    }
+    
+    if (deviceConnected) {
+      serviceBleClients(currentMillis);
+    }
+    
+    updateOfflineBuffer();
+    updateAdvertising();
   }
 
+  updateBroadcast();
+
   // Check hour transitions once per minute
   if (currentMillis - lastHourCheck >= 60000) {
     checkHourChange();
     lastHourCheck = currentMillis;
   }
 
-  // Only update display if not powered off
-  if (!devicePoweredOff) {
-    display.clearDisplay();
-    display.setTextColor(SSD1306_WHITE);
-    
-    if (!calibrationComplete) {
-      display.setCursor(25, 25);
-      display.print("CALIBRATING...");
-      display.drawRect(20, 40, 88, 6, WHITE);
-      display.fillRect(
-        20, 40,
-        map(currentMillis - calibrationStartTime, 0, 5000, 0, 88),
-        6, WHITE
-      );
+  updateDisplayPower(currentMillis);
+  if (displayPower != DISPLAY_BLANK) {
+    renderDisplay(currentMillis);
+  }
+  
+  idleUntilNextDeadline();
+}
+
+// ===========================================
+// IDLE MANAGEMENT
+// ===========================================
+
+/**
+ * Enable automatic light sleep and the wake sources the idle manager needs.
+ * Without CONFIG_PM_ENABLE in the core, esp_pm_configure() fails and the
+ * loop still blocks between deadlines (the idle task waits for interrupt).
+ */
+void configureIdle() {
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+  
+  // The button wakes the loop on each press and release, also from light
+  // sleep. GPIO wake is level-triggered and overrides the pin's interrupt
+  // type, so the button interrupt is a level one that onButtonLevel() flips
+  attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), onButtonLevel, ONLOW);
+  gpio_wakeup_enable((gpio_num_t)BUTTON_PIN, GPIO_INTR_LOW_LEVEL);
+  esp_sleep_enable_gpio_wakeup();
+  
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t pm = {};
+#else
+  esp_pm_config_esp32c3_t pm = {};
+#endif
+  pm.max_freq_mhz = 160;
+  pm.min_freq_mhz = 40;
+  pm.light_sleep_enable = true;
+  lightSleepEnabled = (esp_pm_configure(&pm) == ESP_OK);
+  
+  idleWindowStart = millis();
+  Serial.print("Idle: ");
+  Serial.println(lightSleepEnabled ? "automatic light sleep" : "blocking wait (power management not enabled)");
+}
+
+/**
+ * End the loop task's idle wait early (BLE stack context).
+ */
+void wakeLoop() {
+  if (loopTaskHandle) xTaskNotifyGive(loopTaskHandle);
+}
+
+/**
+ * Button level interrupt: wait for the opposite level next (so a held button
+ * does not keep firing), then wake the loop to debounce the press or release.
+ * If the pin changed again meanwhile, the new level fires right away.
+ */
+void IRAM_ATTR onButtonLevel() {
+  bool pressed = digitalRead(BUTTON_PIN) == LOW;
+  gpio_wakeup_enable((gpio_num_t)BUTTON_PIN, pressed ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL);
+  
+  BaseType_t woken = pdFALSE;
+  if (loopTaskHandle) vTaskNotifyGiveFromISR(loopTaskHandle, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+/**
+ * Time until the earliest periodic task in loop() is due. Tasks that
+ * tolerate slack (connection policy, clock fields) are covered by the
+ * IDLE_MAX_SLEEP_MS cap; event-driven work wakes the loop itself.
+ * 
+ * @param now Current millis()
+ * @return Milliseconds until something is due (0 = run again now)
+ */
+uint32_t nextDeadlineMs(unsigned long now) {
+  if (!calibrationComplete || renderRequested) return 0;
+  if (bleEventHead.load(std::memory_order_relaxed) != bleEventTail.load(std::memory_order_acquire)) return 0;
+  
+  uint32_t wait = IDLE_MAX_SLEEP_MS;
+  
+  // Button: debounce in progress, then the 10-second hold while pressed
+  if (lastButtonState != buttonState) {
+    wait = min(wait, msUntilDue(now, lastDebounceTime, 51));
+  } else if (buttonState == LOW && !buttonHeldForPowerOff) {
+    wait = min(wait, msUntilDue(now, buttonPressStartTime, POWER_HOLD_MS));
+  }
+  
+  if (mpuReady) wait = min(wait, msUntilDue(now, lastMotionUpdate, tunables.motionIntervalMs));
+  if (hrSensorActive) wait = min(wait, msUntilDue(now, lastIRRead, tunables.irIntervalMs));
+  wait = min(wait, msUntilDue(now, lastGSRSampleTime, GSR_SAMPLE_INTERVAL_MS));
+  wait = min(wait, msUntilDue(now, lastAccumUpdate, 1000));
+  
+  if (!deviceConnected) {
+    wait = min(wait, msUntilDue(now, lastOfflineSample, OFFLINE_SAMPLE_INTERVAL));
+  }
+  if (advertisingRestartPending) {
+    wait = min(wait, msUntilDue(now, connectionChangedAt, ADVERTISING_RESTART_MS));
+  }
+  if (offlineDrainActive) wait = 0;
+  
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    const BleClient &c = bleClients[i];
+    if (!c.connected) continue;
+    if (c.deltaSyncCursor >= 0 || c.timeSyncRoundsLeft > 0) wait = 0;
+    if (c.sendCount > 0) wait = min(wait, (uint32_t)IDLE_MIN_SLEEP_MS);  // Completions also wake
+    if (c.liveMode == LIVE_MODE_BATCHED || c.liveMode == LIVE_MODE_TLV) {
+      wait = min(wait, msUntilDue(now, c.lastLiveSample, c.liveSampleIntervalMs));
     } else {
-      switch (currentState) {
-        case DASHBOARD: drawDashboard(); break;
-        case BREATHE:   drawBreatheMode(); break;
-        case INFO:      drawInfoScreen(); break;
-      }
+      wait = min(wait, msUntilDue(now, c.lastBLENotify, tunables.notifyPeriodMs));
+    }
+  }
+  
+  if (displayPower != DISPLAY_BLANK) {
+    const ScreenRate& rate = SCREEN_RATES[currentState];
+    if (rate.animated) wait = min(wait, msUntilDue(now, lastFrameMillis, 1000 / rate.maxFps));
+    unsigned long timeout = (displayPower == DISPLAY_ON) ? DISPLAY_DIM_MS : DISPLAY_OFF_MS;
+    wait = min(wait, msUntilDue(now, lastDisplayActivity, timeout));
+  }
+  
+  if (tunables.broadcastPeriodMs > 0) {
+    wait = min(wait, msUntilDue(now, lastBroadcastUpdate, tunables.broadcastPeriodMs));
+  }
+  wait = min(wait, msUntilDue(now, lastHourCheck, 60000));
+  return wait;
+}
+
+/**
+ * @return Milliseconds from now until last + interval (0 if already due)
+ */
+uint32_t msUntilDue(unsigned long now, unsigned long last, unsigned long interval) {
+  unsigned long elapsed = now - last;
+  return (elapsed >= interval) ? 0 : interval - elapsed;
+}
+
+/**
+ * Block the loop task until the next deadline or a wake notification,
+ * and keep the awake share of each IDLE_WINDOW_MS window.
+ */
+void idleUntilNextDeadline() {
+  unsigned long now = millis();
+  uint32_t wait = nextDeadlineMs(now);
+  
+  if (wait >= IDLE_MIN_SLEEP_MS) {
+    uint64_t start = uptimeMicros();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+    idleWindowSleptUs += uptimeMicros() - start;
+  }
+  
+  now = millis();
+  if (now - idleWindowStart >= IDLE_WINDOW_MS) {
+    uint32_t windowUs = (now - idleWindowStart) * 1000;
+    awakePermille = 1000 - min((uint32_t)1000, (uint32_t)((uint64_t)idleWindowSleptUs * 1000 / windowUs));
+    idleWindowSleptUs = 0;
+    idleWindowStart = now;
+  }
+}
+
+// ===========================================
+// RUNTIME TUNABLES
+// ===========================================
+
+/**
+ * Load tunables saved by the app, falling back to defaults if none are
+ * stored, the layout version changed, or any stored value is out of range.
+ */
+void loadTunables() {
+  tunables = DEFAULT_TUNABLES;
+  
+  if (preferences.getBytesLength("tune") == sizeof(tunables)) {
+    preferences.getBytes("tune", &tunables, sizeof(tunables));
+    
+    // Re-validate against this firmware's ranges; any bad value discards the set
+    bool valid = (tunables.version == TUNABLES_VERSION) &&
+                 tunables.activityLight < tunables.activityActive &&
+                 tunables.activityActive < tunables.activityExercise;
+    for (uint8_t i = 0; i < TUNABLE_COUNT && valid; i++) {
+      valid = tunableInRange(TUNABLE_SPECS[i], getTunable(TUNABLE_SPECS[i].id));
     }
-    display.display();
+    if (!valid) {
+      tunables = DEFAULT_TUNABLES;
+    }
+  }
+  
+  irWave.intervalMs = tunables.irIntervalMs;
+}
+
+/**
+ * Persist current tunables to flash (only called when the app changes them).
+ */
+void saveTunables() {
+  preferences.putBytes("tune", &tunables, sizeof(tunables));
+}
+
+/**
+ * Check a wire value against a tunable's allowed range.
+ * 
+ * @param spec Tunable description
+ * @param value Raw wire value (integer, or IEEE-754 float bits)
+ * @return true if in range (NaN is always rejected)
+ */
+bool tunableInRange(const TunableSpec &spec, uint32_t value) {
+  float number = tunableNumber(spec, value);
+  return number >= spec.minValue && number <= spec.maxValue;
+}
+
+/**
+ * Convert a wire value to a number according to the tunable's type.
+ */
+float tunableNumber(const TunableSpec &spec, uint32_t value) {
+  if (!spec.isFloat) return (float)value;
+  float number;
+  memcpy(&number, &value, sizeof(number));
+  return number;
+}
+
+/**
+ * Validate and apply one tunable. Window changes restart the affected
+ * rolling buffer so indices never point past the new window.
+ * 
+ * @param id Tunable id (TUNE_*)
+ * @param value Raw wire value (integer, or IEEE-754 float bits)
+ * @return true if the id is known and the value was in range
+ */
+bool setTunable(uint8_t id, uint32_t value) {
+  const TunableSpec* spec = nullptr;
+  for (uint8_t i = 0; i < TUNABLE_COUNT; i++) {
+    if (TUNABLE_SPECS[i].id == id) spec = &TUNABLE_SPECS[i];
+  }
+  if (spec == nullptr || !tunableInRange(*spec, value)) return false;
+  
+  float number = tunableNumber(*spec, value);
+  
+  switch (id) {
+    case TUNE_IR_INTERVAL:
+      tunables.irIntervalMs = value;
+      irWave.intervalMs = value;
+      break;
+    case TUNE_MOTION_INTERVAL:
+      tunables.motionIntervalMs = value;
+      break;
+    case TUNE_RR_WINDOW:
+      tunables.rrWindow = value;
+      head = 0;
+      count = 0;
+      break;
+    case TUNE_MOTION_WINDOW:
+      tunables.motionWindow = value;
+      motionBufferIndex = 0;
+      break;
+    case TUNE_GSR_WINDOW:
+      tunables.gsrWindow = value;
+      gsrHead = 0;
+      gsrCount = 0;
+      break;
+    case TUNE_GSR_ALPHA:
+      tunables.gsrAlpha = number;
+      break;
+    case TUNE_HRV_LEARNING_RATE:
+      tunables.hrvLearningRate = number;
+      break;
+    case TUNE_MOTION_THRESHOLD:
+      tunables.motionThreshold = number;
+      break;
+    case TUNE_ACTIVITY_LIGHT:
+      // Activity thresholds must stay in ascending order
+      if (number >= tunables.activityActive) return false;
+      tunables.activityLight = number;
+      break;
+    case TUNE_ACTIVITY_ACTIVE:
+      if (number <= tunables.activityLight || number >= tunables.activityExercise) return false;
+      tunables.activityActive = number;
+      break;
+    case TUNE_ACTIVITY_EXERCISE:
+      if (number <= tunables.activityActive) return false;
+      tunables.activityExercise = number;
+      break;
+    case TUNE_NOTIFY_PERIOD:
+      tunables.notifyPeriodMs = value;
+      break;
+    case TUNE_LIVE_KEEPALIVE:
+      tunables.liveKeepaliveS = value;
+      break;
+    case TUNE_DEADBAND_STRESS:
+      tunables.deadbandStress = value;
+      break;
+    case TUNE_DEADBAND_HR:
+      tunables.deadbandHR = value;
+      break;
+    case TUNE_DEADBAND_HRV:
+      tunables.deadbandHRV = value;
+      break;
+    case TUNE_DEADBAND_GSR:
+      tunables.deadbandGSR = value;
+      break;
+    case TUNE_BROADCAST_PERIOD:
+      // Faster updates would only churn the controller's advertising data
+      if (value != 0 && value < 250) return false;
+      tunables.broadcastPeriodMs = value;
+      break;
+  }
+  return true;
+}
+
+/**
+ * Read one tunable in its wire representation.
+ * 
+ * @param id Tunable id (TUNE_*)
+ * @return Integer value, or IEEE-754 float bits for float tunables
+ */
+uint32_t getTunable(uint8_t id) {
+  float number;
+  switch (id) {
+    case TUNE_IR_INTERVAL:       return tunables.irIntervalMs;
+    case TUNE_MOTION_INTERVAL:   return tunables.motionIntervalMs;
+    case TUNE_RR_WINDOW:         return tunables.rrWindow;
+    case TUNE_MOTION_WINDOW:     return tunables.motionWindow;
+    case TUNE_GSR_WINDOW:        return tunables.gsrWindow;
+    case TUNE_GSR_ALPHA:         number = tunables.gsrAlpha; break;
+    case TUNE_HRV_LEARNING_RATE: number = tunables.hrvLearningRate; break;
+    case TUNE_MOTION_THRESHOLD:  number = tunables.motionThreshold; break;
+    case TUNE_ACTIVITY_LIGHT:    number = tunables.activityLight; break;
+    case TUNE_ACTIVITY_ACTIVE:   number = tunables.activityActive; break;
+    case TUNE_ACTIVITY_EXERCISE: number = tunables.activityExercise; break;
+    case TUNE_NOTIFY_PERIOD:     return tunables.notifyPeriodMs;
+    case TUNE_LIVE_KEEPALIVE:    return tunables.liveKeepaliveS;
+    case TUNE_DEADBAND_STRESS:   return tunables.deadbandStress;
+    case TUNE_DEADBAND_HR:       return tunables.deadbandHR;
+    case TUNE_DEADBAND_HRV:      return tunables.deadbandHRV;
+    case TUNE_DEADBAND_GSR:      return tunables.deadbandGSR;
+    case TUNE_BROADCAST_PERIOD:  return tunables.broadcastPeriodMs;
+    default:                     return 0;
+  }
+  uint32_t bits;
+  memcpy(&bits, &number, sizeof(bits));
+  return bits;
+}
+
+/**
+ * Restore compiled-in defaults and restart the rolling windows.
+ */
+void restoreDefaultTunables() {
+  tunables = DEFAULT_TUNABLES;
+  irWave.intervalMs = tunables.irIntervalMs;
+  head = 0;
+  count = 0;
+  motionBufferIndex = 0;
+  gsrHead = 0;
+  gsrCount = 0;
+}
+
+/**
+ * Refresh the Tunables characteristic and the capabilities that depend on them.
+ * 
+ * Format:
+ *   [0] tunables layout version
+ *   [1..] TLV entries (tag = TUNE_* id, 4-byte little-endian value)
+ */
+void publishTunables() {
+  uint8_t* p = bleTuneBuffer;
+  *p++ = TUNABLES_VERSION;
+  for (uint8_t i = 0; i < TUNABLE_COUNT; i++) {
+    p += putTlv(p, TUNABLE_SPECS[i].id, getTunable(TUNABLE_SPECS[i].id), 4);
   }
+  bleSetValue(BLE_CHANNEL_TUNE, bleTuneBuffer, p - bleTuneBuffer);
+  
+  // Advertised waveform interval follows the IR sample interval
+  buildCapabilities();
+}
+
+/**
+ * Beats required before HRV is trusted (never more than the RMSSD window holds).
+ */
+int hrvWarmupCount() {
+  return min(HRV_WARMUP_COUNT, (int)tunables.rrWindow);
 }
 
 // ===========================================
@@ -878,22 +2310,22 @@ void loop() {
 void addRRInterval(int rrIntervalMs) {
   // Reject outlier beats - >20% deviation from previous beat indicates noise/ectopic
   if (count > 0) {
-    int prevBeat = rrBuffer[(head - 1 + BUFFER_SIZE) % BUFFER_SIZE];
+    int prevBeat = rrBuffer[(head - 1 + tunables.rrWindow) % tunables.rrWindow];
     if (abs(rrIntervalMs - prevBeat) / (float)prevBeat > 0.20)
       rrIntervalMs = prevBeat;
   }
 
   rrBuffer[head] = rrIntervalMs;
-  head = (head + 1) % BUFFER_SIZE;
-  if (count < BUFFER_SIZE) count++;
+  head = (head + 1) % tunables.rrWindow;
+  if (count < tunables.rrWindow) count++;
 
-  if (count >= HRV_WARMUP_COUNT) {
+  if (count >= hrvWarmupCount()) {
     currentHRV = calculateRMSSD();
     
     // Exponential moving average adapts to user's personal HRV baseline
     longTermHRV =
-      (hrvLearningRate * currentHRV) +
-      ((1.0 - hrvLearningRate) * longTermHRV);
+      (tunables.hrvLearningRate * currentHRV) +
+      ((1.0 - tunables.hrvLearningRate) * longTermHRV);
   }
 }
 
@@ -910,8 +2342,8 @@ float calculateRMSSD() {
 
   // Calculate sum of squared differences between consecutive RR intervals
   for (int i = 0; i < count - 1; i++) {
-    int cur = (head - count + i + BUFFER_SIZE) % BUFFER_SIZE;
-    int nxt = (head - count + i + 1 + BUFFER_SIZE) % BUFFER_SIZE;
+    int cur = (head - count + i + tunables.rrWindow) % tunables.rrWindow;
+    int nxt = (head - count + i + 1 + tunables.rrWindow) % tunables.rrWindow;
     int diff = rrBuffer[nxt] - rrBuffer[cur];
     sumSq += (long)diff * diff;
   }
@@ -930,14 +2362,21 @@ float calculateRMSSD() {
  * and calculates BPM using peak interval method.
  */
 void updateHeartRate() {
-  static unsigned long lastIRRead = 0;
   unsigned long currentMillis = millis();
   
-  if (currentMillis - lastIRRead >= 20) {
+  if (currentMillis - lastIRRead >= tunables.irIntervalMs) {
     long irValue = particleSensor.getIR();
     rawIR = irValue;  // Store for display
+    if (lastIRRead != 0) {
+      unsigned long late = currentMillis - lastIRRead - tunables.irIntervalMs;
+      irSampleLateMaxMs = max(irSampleLateMaxMs, (uint16_t)min(late, 65535UL));
+    }
     lastIRRead = currentMillis;
     
+    if (waveSubscribed) {
+      addWaveSample(irWave, irValue);
+    }
+    
     // Print raw IR to Serial Monitor
     Serial.print("IR:");
     Serial.println(irValue);
@@ -1064,18 +2503,24 @@ void updateGSR() {
   rawGSR = analogRead(GSR_PIN);
   
   gsrBuffer[gsrHead] = rawGSR;
-  gsrHead = (gsrHead + 1) % GSR_BUFFER_SIZE;
-  if (gsrCount < GSR_BUFFER_SIZE) gsrCount++;
+  gsrHead = (gsrHead + 1) % tunables.gsrWindow;
+  if (gsrCount < tunables.gsrWindow) gsrCount++;
 
   long sum = 0;
   for (int i = 0; i < gsrCount; i++) sum += gsrBuffer[i];
   currentGSR = sum / (float)gsrCount;
 
-  // Exponential moving average with very low alpha (0.01) for slow baseline tracking
+  // Exponential moving average with very low alpha (0.01 default) for slow baseline tracking
   // Compensates for environmental factors without masking stress responses
   baselineGSR =
-    (GSR_ALPHA * currentGSR) +
-    ((1.0 - GSR_ALPHA) * baselineGSR);
+    (tunables.gsrAlpha * currentGSR) +
+    ((1.0 - tunables.gsrAlpha) * baselineGSR);
+  
+  // Raw GSR trace is decimated to 10Hz for waveform streaming
+  if (waveSubscribed && millis() - lastGSRWaveSample >= WAVE_GSR_INTERVAL_MS) {
+    addWaveSample(gsrWave, rawGSR);
+    lastGSRWaveSample = millis();
+  }
 }
 
 /**
@@ -1099,7 +2544,7 @@ float calculateStressIndex() {
 
   // HRV component: maps current HRV to activity-adjusted baseline range
   // Lower HRV relative to baseline = higher stress score
-  if (hrSensorActive && count >= HRV_WARMUP_COUNT) {
+  if (hrSensorActive && count >= hrvWarmupCount()) {
     hrvScore = constrain(
       mapFloat(currentHRV, activityAdjustedHRVBaseline * 0.4, activityAdjustedHRVBaseline, 100, 0),
       0, 100
@@ -1145,7 +2590,7 @@ float calculateStressIndex() {
   static float previousAdjustedStress = 0;   // For anxiety detection
   float rawStress;
   
-  if (hrSensorActive && count >= HRV_WARMUP_COUNT)
+  if (hrSensorActive && count >= hrvWarmupCount())
     rawStress = (0.6 * hrvScore) + (0.4 * gsrScore);
   else
     rawStress = gsrScore;
@@ -1217,22 +2662,775 @@ float calculateStressIndex() {
 }
 
 // ===========================================
-// UI RENDERING
+// RENDER SCHEDULER
 // ===========================================
 
 /**
- * Draw main dashboard screen showing current stress level.
- * Displays stress percentage, visual bar, and BLE connection status.
+ * Draw and flush a frame if the current screen is due one.
+ * A frame is due when the screen is animated or its model key changed,
+ * and at least 1/maxFps has passed since the last frame. It is deferred
+ * (up to RENDER_MAX_DEFER_MS) while an IR or motion read would fall due
+ * before the frame finished.
+ * 
+ * @param now Current millis()
  */
-void drawDashboard() {
-  if (deviceConnected) {
-    display.fillCircle(5, 5, 3, WHITE);
+void renderDisplay(unsigned long now) {
+  if (now - fpsWindowStart >= 1000) {
+    renderFps = framesThisWindow;
+    framesThisWindow = 0;
+    fpsWindowStart = now;
+  }
+  
+  const ScreenRate& rate = calibrationComplete ? SCREEN_RATES[currentState] : CALIBRATION_RATE;
+  uint32_t modelKey = screenModelKey();
+  if (!rate.animated && !renderRequested && modelKey == lastModelKey) return;
+  
+  unsigned long frameInterval = 1000 / rate.maxFps;
+  unsigned long sinceFrame = now - lastFrameMillis;
+  if (sinceFrame < frameInterval) return;
+  
+  if (sinceFrame < frameInterval + RENDER_MAX_DEFER_MS &&
+      sensorReadDueWithin(now, renderCostUs)) {
+    framesDeferred++;
+    return;
+  }
+  
+  unsigned long start = micros();
+  drawFrame(now);
+  
+  uint32_t cost = micros() - start;
+  renderCostUs = (renderCostUs == 0) ? cost : (renderCostUs * 7 + cost) / 8;
+  lastFrameMillis = now;
+  lastModelKey = modelKey;
+  renderRequested = false;
+  framesThisWindow++;
+}
+
+/**
+ * Draw the current screen (or calibration progress) and flush it.
+ * 
+ * @param now Current millis()
+ */
+void drawFrame(unsigned long now) {
+  display.clearDisplay();
+  display.setTextColor(SSD1306_WHITE);
+  
+  if (!calibrationComplete) {
+    display.setCursor(25, 25);
+    display.print("CALIBRATING...");
+    display.drawRect(20, 40, 88, 6, WHITE);
+    display.fillRect(
+      20, 40,
+      map(now - calibrationStartTime, 0, 5000, 0, 88),
+      6, WHITE
+    );
   } else {
-    display.drawCircle(5, 5, 3, WHITE);
+    switch (currentState) {
+      case DASHBOARD: drawDashboard(); break;
+      case BREATHE:   drawBreatheMode(); break;
+      case INFO:      drawInfoScreen(); break;
+      case TREND:     drawTrendScreen(); break;
+    }
   }
+  flushDisplay();
+}
 
-  display.setTextSize(1);
-  display.setCursor(35, 10);
+/**
+ * Summarize what the current screen shows, so a static screen redraws only
+ * when one of its inputs changes. Covers the screen itself and the values
+ * drawDashboard() and drawTrendScreen() display (the trend geometry and
+ * the live hour's average).
+ * 
+ * @return Key that changes whenever the visible content would
+ */
+uint32_t screenModelKey() {
+  uint32_t key = calibrationComplete ? (uint32_t)currentState + 1 : 0;
+  key = (key << 1) | (deviceConnected ? 1 : 0);
+  if (calibrationComplete && currentState == DASHBOARD) {
+    key = (key << 8) | (uint8_t)constrain((int)stressIndexDisplay, 0, 100);
+  } else if (calibrationComplete && currentState == TREND) {
+    refreshTrendGeometry();
+    key = (key << 16) | trendVersion;
+    key = (key << 8) | (uint8_t)(liveHourStress() + 1);
+  }
+  return key;
+}
+
+/**
+ * Check whether a rate-gated sensor read falls due within a time span.
+ * 
+ * @param now Current millis()
+ * @param us Span to check, in microseconds
+ * @return true if the IR or motion read is due before now + us
+ */
+bool sensorReadDueWithin(unsigned long now, uint32_t us) {
+  unsigned long spanMs = (us + 999) / 1000;
+  if (!calibrationComplete) return false;  // Neither sensor is read yet
+  if (hrSensorActive && now - lastIRRead + spanMs >= tunables.irIntervalMs) {
+    return true;
+  }
+  if (mpuReady && now - lastMotionUpdate + spanMs >= tunables.motionIntervalMs) {
+    return true;
+  }
+  return false;
+}
+
+// ===========================================
+// DISPLAY POWER
+// ===========================================
+
+/**
+ * Apply the inactivity policy: dim, then blank the display when nobody has
+ * looked at it for a while, and wake it on a wrist raise or when stress
+ * rises past DISPLAY_WAKE_STRESS. Button presses reset the timer directly.
+ * 
+ * @param now Current millis()
+ */
+void updateDisplayPower(unsigned long now) {
+  if (!calibrationComplete || currentState == BREATHE) {
+    lastDisplayActivity = now;
+  }
+  
+  if (wristRaiseDetected) {
+    wristRaiseDetected = false;
+    lastDisplayActivity = now;
+  }
+  
+  if (stressWakeArmed && stressIndexDisplay > DISPLAY_WAKE_STRESS) {
+    stressWakeArmed = false;
+    lastDisplayActivity = now;
+  } else if (!stressWakeArmed && stressIndexDisplay < DISPLAY_REARM_STRESS) {
+    stressWakeArmed = true;
+  }
+  
+  unsigned long idle = now - lastDisplayActivity;
+  if (idle >= DISPLAY_OFF_MS) {
+    setDisplayPower(DISPLAY_BLANK);
+  } else if (idle >= DISPLAY_DIM_MS) {
+    setDisplayPower(DISPLAY_DIMMED);
+  } else {
+    setDisplayPower(DISPLAY_ON);
+  }
+}
+
+/**
+ * Switch the panel between full brightness, dimmed and off.
+ * The panel keeps its RAM while off, so the tile checksums stay valid;
+ * the first frame after waking is forced to catch up on what changed.
+ * 
+ * @param level New display power level
+ */
+void setDisplayPower(DisplayPower level) {
+  if (level == displayPower) return;
+  
+  if (level == DISPLAY_BLANK) {
+    display.ssd1306_command(SSD1306_DISPLAYOFF);
+  } else {
+    if (displayPower == DISPLAY_BLANK) {
+      display.ssd1306_command(SSD1306_DISPLAYON);
+      renderRequested = true;
+    }
+    display.dim(level == DISPLAY_DIMMED);
+  }
+  displayPower = level;
+}
+
+// ===========================================
+// SCENE RENDERER
+// ===========================================
+
+// Classic 5x7 font, ASCII 0x20-0x7E. One byte per column, bit 0 is the top row.
+const uint8_t FONT_5X7[][FONT_WIDTH] = {
+  {0x00, 0x00, 0x00, 0x00, 0x00},  // space
+  {0x00, 0x00, 0x5F, 0x00, 0x00},  // !
+  {0x00, 0x07, 0x00, 0x07, 0x00},  // "
+  {0x14, 0x7F, 0x14, 0x7F, 0x14},  // #
+  {0x24, 0x2A, 0x7F, 0x2A, 0x12},  // $
+  {0x23, 0x13, 0x08, 0x64, 0x62},  // %
+  {0x36, 0x49, 0x55, 0x22, 0x50},  // &
+  {0x00, 0x05, 0x03, 0x00, 0x00},  // '
+  {0x00, 0x1C, 0x22, 0x41, 0x00},  // (
+  {0x00, 0x41, 0x22, 0x1C, 0x00},  // )
+  {0x14, 0x08, 0x3E, 0x08, 0x14},  // *
+  {0x08, 0x08, 0x3E, 0x08, 0x08},  // +
+  {0x00, 0x50, 0x30, 0x00, 0x00},  // ,
+  {0x08, 0x08, 0x08, 0x08, 0x08},  // -
+  {0x00, 0x60, 0x60, 0x00, 0x00},  // .
+  {0x20, 0x10, 0x08, 0x04, 0x02},  // /
+  {0x3E, 0x51, 0x49, 0x45, 0x3E},  // 0
+  {0x00, 0x42, 0x7F, 0x40, 0x00},  // 1
+  {0x42, 0x61, 0x51, 0x49, 0x46},  // 2
+  {0x21, 0x41, 0x45, 0x4B, 0x31},  // 3
+  {0x18, 0x14, 0x12, 0x7F, 0x10},  // 4
+  {0x27, 0x45, 0x45, 0x45, 0x39},  // 5
+  {0x3C, 0x4A, 0x49, 0x49, 0x30},  // 6
+  {0x01, 0x71, 0x09, 0x05, 0x03},  // 7
+  {0x36, 0x49, 0x49, 0x49, 0x36},  // 8
+  {0x06, 0x49, 0x49, 0x29, 0x1E},  // 9
+  {0x00, 0x36, 0x36, 0x00, 0x00},  // :
+  {0x00, 0x56, 0x36, 0x00, 0x00},  // ;
+  {0x08, 0x14, 0x22, 0x41, 0x00},  // <
+  {0x14, 0x14, 0x14, 0x14, 0x14},  // =
+  {0x00, 0x41, 0x22, 0x14, 0x08},  // >
+  {0x02, 0x01, 0x51, 0x09, 0x06},  // ?
+  {0x32, 0x49, 0x79, 0x41, 0x3E},  // @
+  {0x7E, 0x11, 0x11, 0x11, 0x7E},  // A
+  {0x7F, 0x49, 0x49, 0x49, 0x36},  // B
+  {0x3E, 0x41, 0x41, 0x41, 0x22},  // C
+  {0x7F, 0x41, 0x41, 0x22, 0x1C},  // D
+  {0x7F, 0x49, 0x49, 0x49, 0x41},  // E
+  {0x7F, 0x09, 0x09, 0x09, 0x01},  // F
+  {0x3E, 0x41, 0x49, 0x49, 0x7A},  // G
+  {0x7F, 0x08, 0x08, 0x08, 0x7F},  // H
+  {0x00, 0x41, 0x7F, 0x41, 0x00},  // I
+  {0x20, 0x40, 0x41, 0x3F, 0x01},  // J
+  {0x7F, 0x08, 0x14, 0x22, 0x41},  // K
+  {0x7F, 0x40, 0x40, 0x40, 0x40},  // L
+  {0x7F, 0x02, 0x0C, 0x02, 0x7F},  // M
+  {0x7F, 0x04, 0x08, 0x10, 0x7F},  // N
+  {0x3E, 0x41, 0x41, 0x41, 0x3E},  // O
+  {0x7F, 0x09, 0x09, 0x09, 0x06},  // P
+  {0x3E, 0x41, 0x51, 0x21, 0x5E},  // Q
+  {0x7F, 0x09, 0x19, 0x29, 0x46},  // R
+  {0x46, 0x49, 0x49, 0x49, 0x31},  // S
+  {0x01, 0x01, 0x7F, 0x01, 0x01},  // T
+  {0x3F, 0x40, 0x40, 0x40, 0x3F},  // U
+  {0x1F, 0x20, 0x40, 0x20, 0x1F},  // V
+  {0x3F, 0x40, 0x38, 0x40, 0x3F},  // W
+  {0x63, 0x14, 0x08, 0x14, 0x63},  // X
+  {0x07, 0x08, 0x70, 0x08, 0x07},  // Y
+  {0x61, 0x51, 0x49, 0x45, 0x43},  // Z
+  {0x00, 0x7F, 0x41, 0x41, 0x00},  // [
+  {0x02, 0x04, 0x08, 0x10, 0x20},  // backslash
+  {0x00, 0x41, 0x41, 0x7F, 0x00},  // ]
+  {0x04, 0x02, 0x01, 0x02, 0x04},  // ^
+  {0x40, 0x40, 0x40, 0x40, 0x40},  // _
+  {0x00, 0x01, 0x02, 0x04, 0x00},  // `
+  {0x20, 0x54, 0x54, 0x54, 0x78},  // a
+  {0x7F, 0x48, 0x44, 0x44, 0x38},  // b
+  {0x38, 0x44, 0x44, 0x44, 0x20},  // c
+  {0x38, 0x44, 0x44, 0x48, 0x7F},  // d
+  {0x38, 0x54, 0x54, 0x54, 0x18},  // e
+  {0x08, 0x7E, 0x09, 0x01, 0x02},  // f
+  {0x0C, 0x52, 0x52, 0x52, 0x3E},  // g
+  {0x7F, 0x08, 0x04, 0x04, 0x78},  // h
+  {0x00, 0x44, 0x7D, 0x40, 0x00},  // i
+  {0x20, 0x40, 0x44, 0x3D, 0x00},  // j
+  {0x7F, 0x10, 0x28, 0x44, 0x00},  // k
+  {0x00, 0x41, 0x7F, 0x40, 0x00},  // l
+  {0x7C, 0x04, 0x18, 0x04, 0x78},  // m
+  {0x7C, 0x08, 0x04, 0x04, 0x78},  // n
+  {0x38, 0x44, 0x44, 0x44, 0x38},  // o
+  {0x7C, 0x14, 0x14, 0x14, 0x08},  // p
+  {0x08, 0x14, 0x14, 0x18, 0x7C},  // q
+  {0x7C, 0x08, 0x04, 0x04, 0x08},  // r
+  {0x48, 0x54, 0x54, 0x54, 0x20},  // s
+  {0x04, 0x3F, 0x44, 0x40, 0x20},  // t
+  {0x3C, 0x40, 0x40, 0x20, 0x7C},  // u
+  {0x1C, 0x20, 0x40, 0x20, 0x1C},  // v
+  {0x3C, 0x40, 0x30, 0x40, 0x3C},  // w
+  {0x44, 0x28, 0x10, 0x28, 0x44},  // x
+  {0x0C, 0x50, 0x50, 0x50, 0x3C},  // y
+  {0x44, 0x64, 0x54, 0x4C, 0x44},  // z
+  {0x00, 0x08, 0x36, 0x41, 0x00},  // {
+  {0x00, 0x00, 0x7F, 0x00, 0x00},  // |
+  {0x00, 0x41, 0x36, 0x08, 0x00},  // }
+  {0x08, 0x04, 0x08, 0x10, 0x08},  // ~
+};
+
+/**
+ * Initialize the SSD1306 (128x64, horizontal addressing) and clear the scene.
+ * 
+ * @param vcc SSD1306_SWITCHCAPVCC to enable the internal charge pump
+ * @param address I2C address of the panel
+ * @return true if the panel acknowledged
+ */
+bool SceneDisplay::begin(uint8_t vcc, uint8_t address) {
+  const uint8_t init[] = {
+    SSD1306_DISPLAYOFF,
+    0xD5, 0x80,                                       // Clock divide / oscillator
+    0xA8, SCREEN_HEIGHT - 1,                          // Multiplex ratio
+    0xD3, 0x00,                                       // Display offset
+    0x40,                                             // Start line 0
+    0x8D, (uint8_t)(vcc == SSD1306_SWITCHCAPVCC ? 0x14 : 0x10),  // Charge pump
+    0x20, 0x00,                                       // Horizontal addressing
+    0xA1, 0xC8,                                       // Segment remap, COM scan descending
+    0xDA, 0x12,                                       // COM pins (128x64)
+    SSD1306_SETCONTRAST, 0xCF,
+    0xD9, (uint8_t)(vcc == SSD1306_SWITCHCAPVCC ? 0xF1 : 0x22),  // Precharge
+    0xDB, 0x40,                                       // VCOMH deselect level
+    0xA4, 0xA6,                                       // Resume from RAM, normal (not inverted)
+    0x2E,                                             // Scrolling off
+    SSD1306_DISPLAYON
+  };
+  
+  Wire.beginTransmission(address);
+  bool present = (Wire.endTransmission() == 0);
+  if (present) {
+    sendDisplayCommands(init, sizeof(init));
+  }
+  displayTilesValid = false;
+  clearDisplay();
+  return present;
+}
+
+/**
+ * Start a new, empty scene and home the text cursor.
+ */
+void SceneDisplay::clearDisplay() {
+  sceneItemCount = 0;
+  sceneDataUsed = 0;
+  cursorX = 0;
+  cursorY = 0;
+}
+
+void SceneDisplay::drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  addSceneItem(SCENE_RECT, color ? WHITE : BLACK, x, y, w, h);
+}
+
+void SceneDisplay::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  addSceneItem(SCENE_FILL_RECT, color ? WHITE : BLACK, x, y, w, h);
+}
+
+void SceneDisplay::drawCircle(int16_t x, int16_t y, int16_t r, uint16_t color) {
+  addSceneItem(SCENE_CIRCLE, color ? WHITE : BLACK, x, y, r, 1);
+}
+
+void SceneDisplay::fillCircle(int16_t x, int16_t y, int16_t r, uint16_t color) {
+  addSceneItem(SCENE_FILL_CIRCLE, color ? WHITE : BLACK, x, y, r, 1);
+}
+
+/**
+ * Draw a series as connected points, one per pitch columns, rising from
+ * a baseline. SCENE_NO_VALUE entries break the line.
+ * 
+ * @param x Left column of the first point's slot
+ * @param baseline Row of height 0
+ * @param pitch Columns per point
+ * @param heights Point heights in pixels
+ * @param count Number of points
+ */
+void SceneDisplay::drawSparkline(int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color) {
+  addSceneSeries(SCENE_SPARKLINE, x, baseline, pitch, heights, count, color);
+}
+
+/**
+ * Draw a series as bars pitch - 1 columns wide standing on a baseline.
+ * Zero heights draw a one-pixel stub; SCENE_NO_VALUE entries draw nothing.
+ */
+void SceneDisplay::drawBars(int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color) {
+  addSceneSeries(SCENE_BARS, x, baseline, pitch, heights, count, color);
+}
+
+/**
+ * Lower or restore the panel contrast.
+ */
+void SceneDisplay::dim(bool dimmed) {
+  const uint8_t contrast[] = {SSD1306_SETCONTRAST, (uint8_t)(dimmed ? 0x00 : 0xCF)};
+  sendDisplayCommands(contrast, sizeof(contrast));
+}
+
+void SceneDisplay::ssd1306_command(uint8_t command) {
+  sendDisplayCommands(&command, 1);
+}
+
+/**
+ * Print one character at the cursor. Consecutive characters extend the
+ * same text run, so a label followed by a value is a single scene item.
+ */
+size_t SceneDisplay::write(uint8_t c) {
+  if (c == '\n') {
+    cursorX = 0;
+    cursorY += 8 * textSize;
+    return 1;
+  }
+  if (c == '\r') return 1;
+  
+  SceneItem* run = sceneItemCount ? &sceneItems[sceneItemCount - 1] : nullptr;
+  uint8_t style = (textSize << 1) | textColor;
+  bool extends = run && run->kind == SCENE_TEXT && run->style == style &&
+                 run->y == cursorY && run->a + run->b == sceneDataUsed &&
+                 run->x + run->b * 6 * textSize == cursorX;
+  
+  if (sceneDataUsed >= SCENE_DATA_SIZE ||
+      (!extends && !addSceneItem(SCENE_TEXT, style, cursorX, cursorY, sceneDataUsed, 0))) {
+    sceneOverflows++;
+    return 0;
+  }
+  run = &sceneItems[sceneItemCount - 1];
+  sceneData[sceneDataUsed++] = c;
+  run->b++;
+  cursorX += 6 * textSize;
+  return 1;
+}
+
+/**
+ * Append a primitive to the scene.
+ * 
+ * @param kind SceneKind
+ * @param style Color, plus text scale for text runs
+ * @param x Left (center for circles)
+ * @param y Top (center for circles)
+ * @param a Width, radius or text offset
+ * @param b Height or text length
+ * @return false if the primitive is empty or the scene is full
+ */
+bool addSceneItem(uint8_t kind, uint8_t style, int16_t x, int16_t y, int16_t a, int16_t b) {
+  if (kind != SCENE_TEXT && (a <= 0 || b <= 0)) return false;
+  if (sceneItemCount >= SCENE_MAX_ITEMS) {
+    sceneOverflows++;
+    return false;
+  }
+  
+  SceneItem& item = sceneItems[sceneItemCount++];
+  item.kind = kind;
+  item.style = style;
+  item.x = x;
+  item.y = y;
+  item.a = min(a, (int16_t)255);
+  item.b = min(b, (int16_t)255);
+  return true;
+}
+
+/**
+ * Append a data series to the scene, copying its values into sceneData.
+ * 
+ * @return false if the scene is full
+ */
+bool addSceneSeries(uint8_t kind, int16_t x, int16_t baseline, uint8_t pitch, const uint8_t* heights, uint8_t count, uint16_t color) {
+  if (count > SCENE_DATA_SIZE - sceneDataUsed) {
+    sceneOverflows++;
+    return false;
+  }
+  uint8_t style = (pitch << 1) | (color ? WHITE : BLACK);
+  if (!addSceneItem(kind, style, x, baseline, sceneDataUsed, count)) return false;
+  
+  memcpy(sceneData + sceneDataUsed, heights, count);
+  sceneDataUsed += count;
+  return true;
+}
+
+/**
+ * FNV-1a checksum of the scene (primitives, text and series values).
+ */
+uint32_t sceneChecksum() {
+  uint32_t hash = 2166136261UL;
+  const uint8_t* items = (const uint8_t*)sceneItems;
+  for (size_t i = 0; i < sceneItemCount * sizeof(SceneItem); i++) {
+    hash = (hash ^ items[i]) * 16777619UL;
+  }
+  for (uint8_t i = 0; i < sceneDataUsed; i++) {
+    hash = (hash ^ (uint8_t)sceneData[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * Render every scene item that crosses one page into a page row buffer.
+ * 
+ * @param page Page (8-row band) 0-7
+ * @param row Output, SCREEN_WIDTH bytes in SSD1306 column format
+ */
+void composeDisplayPage(uint8_t page, uint8_t* row) {
+  int16_t top = page * 8;
+  memset(row, 0, SCREEN_WIDTH);
+  
+  for (uint8_t i = 0; i < sceneItemCount; i++) {
+    const SceneItem& item = sceneItems[i];
+    uint8_t color = item.style & 1;
+    
+    switch (item.kind) {
+      case SCENE_FILL_RECT:
+        composeFill(row, top, item.x, item.y, item.a, item.b, color);
+        break;
+      case SCENE_RECT:
+        composeFill(row, top, item.x, item.y, item.a, 1, color);
+        composeFill(row, top, item.x, item.y + item.b - 1, item.a, 1, color);
+        composeFill(row, top, item.x, item.y, 1, item.b, color);
+        composeFill(row, top, item.x + item.a - 1, item.y, 1, item.b, color);
+        break;
+      case SCENE_CIRCLE:
+      case SCENE_FILL_CIRCLE:
+        if (item.y + item.a >= top && item.y - item.a < top + 8) {
+          composeCircle(row, top, item, item.kind == SCENE_FILL_CIRCLE);
+        }
+        break;
+      case SCENE_TEXT:
+        composeText(row, top, item);
+        break;
+      case SCENE_SPARKLINE:
+      case SCENE_BARS:
+        composeSeries(row, top, item);
+        break;
+    }
+  }
+}
+
+/**
+ * Set or clear the part of a rectangle that lies inside one page.
+ * 
+ * @param row Page row buffer
+ * @param top First pixel row of the page
+ * @param x, y, w, h Rectangle in screen pixels
+ * @param color WHITE sets, BLACK clears
+ */
+void composeFill(uint8_t* row, int16_t top, int16_t x, int16_t y, int16_t w, int16_t h, uint8_t color) {
+  int16_t y0 = max(y, top);
+  int16_t y1 = min((int16_t)(y + h - 1), (int16_t)(top + 7));
+  int16_t x0 = max(x, (int16_t)0);
+  int16_t x1 = min((int16_t)(x + w - 1), (int16_t)(SCREEN_WIDTH - 1));
+  if (y0 > y1 || x0 > x1) return;
+  
+  uint8_t mask = (0xFF << (y0 - top)) & (0xFF >> (top + 7 - y1));
+  for (int16_t col = x0; col <= x1; col++) {
+    if (color) row[col] |= mask;
+    else row[col] &= ~mask;
+  }
+}
+
+/**
+ * Midpoint circle (same pixels as Adafruit_GFX), clipped to one page.
+ * Filled circles are drawn as vertical spans.
+ */
+void composeCircle(uint8_t* row, int16_t top, const SceneItem& item, bool filled) {
+  int16_t cx = item.x;
+  int16_t cy = item.y;
+  int16_t r = item.a;
+  uint8_t color = item.style & 1;
+  int16_t f = 1 - r;
+  int16_t ddFx = 1;
+  int16_t ddFy = -2 * r;
+  int16_t x = 0;
+  int16_t y = r;
+  
+  if (filled) {
+    composeFill(row, top, cx, cy - r, 1, 2 * r + 1, color);
+  } else {
+    composeFill(row, top, cx, cy + r, 1, 1, color);
+    composeFill(row, top, cx, cy - r, 1, 1, color);
+    composeFill(row, top, cx + r, cy, 1, 1, color);
+    composeFill(row, top, cx - r, cy, 1, 1, color);
+  }
+  
+  while (x < y) {
+    if (f >= 0) {
+      y--;
+      ddFy += 2;
+      f += ddFy;
+    }
+    x++;
+    ddFx += 2;
+    f += ddFx;
+    
+    if (filled) {
+      composeFill(row, top, cx + x, cy - y, 1, 2 * y + 1, color);
+      composeFill(row, top, cx - x, cy - y, 1, 2 * y + 1, color);
+      composeFill(row, top, cx + y, cy - x, 1, 2 * x + 1, color);
+      composeFill(row, top, cx - y, cy - x, 1, 2 * x + 1, color);
+    } else {
+      composeFill(row, top, cx + x, cy + y, 1, 1, color);
+      composeFill(row, top, cx - x, cy + y, 1, 1, color);
+      composeFill(row, top, cx + x, cy - y, 1, 1, color);
+      composeFill(row, top, cx - x, cy - y, 1, 1, color);
+      composeFill(row, top, cx + y, cy + x, 1, 1, color);
+      composeFill(row, top, cx - y, cy + x, 1, 1, color);
+      composeFill(row, top, cx + y, cy - x, 1, 1, color);
+      composeFill(row, top, cx - y, cy - x, 1, 1, color);
+    }
+  }
+}
+
+/**
+ * Render the part of a text run that lies inside one page. Scale 1 glyph
+ * columns are shifted straight into the page bytes; larger scales draw
+ * each font pixel as a scale x scale block.
+ */
+void composeText(uint8_t* row, int16_t top, const SceneItem& item) {
+  uint8_t scale = item.style >> 1;
+  uint8_t color = item.style & 1;
+  if (item.y + 8 * scale <= top || item.y >= top + 8) return;
+  
+  for (uint8_t i = 0; i < item.b; i++) {
+    uint8_t c = sceneData[item.a + i];
+    if (c < FONT_FIRST_CHAR || c > FONT_LAST_CHAR) continue;
+    const uint8_t* glyph = FONT_5X7[c - FONT_FIRST_CHAR];
+    int16_t left = item.x + i * 6 * scale;
+    
+    for (uint8_t col = 0; col < FONT_WIDTH; col++) {
+      if (scale == 1) {
+        int16_t x = left + col;
+        if (x < 0 || x >= SCREEN_WIDTH) continue;
+        int16_t shift = item.y - top;
+        uint8_t bits = (shift >= 0) ? (uint8_t)(glyph[col] << shift) : (uint8_t)(glyph[col] >> -shift);
+        if (color) row[x] |= bits;
+        else row[x] &= ~bits;
+      } else {
+        for (uint8_t bit = 0; bit < 8; bit++) {
+          if (glyph[col] & (1 << bit)) {
+            composeFill(row, top, left + col * scale, item.y + bit * scale, scale, scale, color);
+          }
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Render the part of a sparkline or bar series that lies inside one page.
+ */
+void composeSeries(uint8_t* row, int16_t top, const SceneItem& item) {
+  uint8_t pitch = item.style >> 1;
+  uint8_t color = item.style & 1;
+  const uint8_t* heights = (const uint8_t*)sceneData + item.a;
+  
+  for (uint8_t i = 0; i < item.b; i++) {
+    if (heights[i] == SCENE_NO_VALUE) continue;
+    int16_t x = item.x + i * pitch;
+    int16_t y = item.y - heights[i];
+    
+    if (item.kind == SCENE_BARS) {
+      int16_t h = max((int16_t)heights[i], (int16_t)1);
+      composeFill(row, top, x, item.y - h + 1, pitch - 1, h, color);
+    } else if (i + 1 < item.b && heights[i + 1] != SCENE_NO_VALUE) {
+      composeLine(row, top, x + pitch / 2, y, x + pitch + pitch / 2, item.y - heights[i + 1], color);
+    } else if (i == 0 || heights[i - 1] == SCENE_NO_VALUE) {
+      composeFill(row, top, x + pitch / 2, y, 1, 1, color);  // Isolated point
+    }
+  }
+}
+
+/**
+ * Bresenham line, clipped to one page.
+ */
+void composeLine(uint8_t* row, int16_t top, int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t color) {
+  if (max(y0, y1) < top || min(y0, y1) > top + 7) return;
+  
+  int16_t dx = abs(x1 - x0);
+  int16_t dy = -abs(y1 - y0);
+  int16_t sx = (x0 < x1) ? 1 : -1;
+  int16_t sy = (y0 < y1) ? 1 : -1;
+  int16_t err = dx + dy;
+  
+  while (true) {
+    composeFill(row, top, x0, y0, 1, 1, color);
+    if (x0 == x1 && y0 == y1) break;
+    int16_t e2 = 2 * err;
+    if (e2 >= dy) { err += dy; x0 += sx; }
+    if (e2 <= dx) { err += dx; y0 += sy; }
+  }
+}
+
+/**
+ * Send a command sequence to the panel in one I2C transaction.
+ */
+void sendDisplayCommands(const uint8_t* commands, uint8_t count) {
+  Wire.beginTransmission(OLED_ADDRESS);
+  Wire.write((uint8_t)0x00);  // Command stream
+  Wire.write(commands, count);
+  Wire.endTransmission();
+}
+
+// ===========================================
+// DISPLAY FLUSH
+// ===========================================
+
+/**
+ * Compose the scene page by page and send the tiles that differ from what
+ * the panel shows. Only one 128-byte page exists at a time. An unchanged
+ * scene is detected by its checksum and costs nothing else; a changing
+ * number costs composing all pages and sending the tiles it touches.
+ */
+void flushDisplay() {
+  unsigned long start = micros();
+  uint32_t sum = sceneChecksum();
+  
+  if (!displayTilesValid || sum != shownSceneSum) {
+    uint8_t row[SCREEN_WIDTH];
+    
+    for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+      composeDisplayPage(page, row);
+      int8_t firstTile = -1;
+      int8_t lastTile = -1;
+      
+      for (uint8_t tile = 0; tile < DISPLAY_TILES; tile++) {
+        uint32_t tileSum = displayTileChecksum(row + tile * DISPLAY_TILE_WIDTH);
+        if (displayTilesValid && tileSum == displayTileSums[page][tile]) continue;
+        displayTileSums[page][tile] = tileSum;
+        if (firstTile < 0) firstTile = tile;
+        lastTile = tile;
+      }
+      
+      // Unchanged tiles between two changed ones are resent; one transaction is cheaper
+      if (firstTile >= 0) {
+        sendDisplayRange(page, firstTile * DISPLAY_TILE_WIDTH,
+                         (lastTile + 1) * DISPLAY_TILE_WIDTH - 1, row);
+      }
+    }
+    shownSceneSum = sum;
+  }
+  
+  displayTilesValid = true;
+  displayFlushes++;
+  displayFlushUs += micros() - start;
+}
+
+/**
+ * FNV-1a checksum of one tile (DISPLAY_TILE_WIDTH column bytes).
+ */
+uint32_t displayTileChecksum(const uint8_t* data) {
+  uint32_t hash = 2166136261UL;
+  for (uint8_t i = 0; i < DISPLAY_TILE_WIDTH; i++) {
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+  return hash;
+}
+
+/**
+ * Write one column range of a page to the panel.
+ * 
+ * @param page Page (8-row band) 0-7
+ * @param firstColumn First column to write
+ * @param lastColumn Last column to write (inclusive)
+ * @param data Page row of the frame buffer (SCREEN_WIDTH bytes)
+ */
+void sendDisplayRange(uint8_t page, uint8_t firstColumn, uint8_t lastColumn, const uint8_t* data) {
+  Wire.beginTransmission(OLED_ADDRESS);
+  Wire.write((uint8_t)0x00);  // Command stream
+  Wire.write((uint8_t)SSD1306_COLUMNADDR);
+  Wire.write(firstColumn);
+  Wire.write(lastColumn);
+  Wire.write((uint8_t)SSD1306_PAGEADDR);
+  Wire.write(page);
+  Wire.write(page);
+  Wire.endTransmission();
+  
+  for (uint16_t column = firstColumn; column <= lastColumn; column += DISPLAY_I2C_CHUNK) {
+    uint16_t count = min((uint16_t)(lastColumn + 1 - column), (uint16_t)DISPLAY_I2C_CHUNK);
+    Wire.beginTransmission(OLED_ADDRESS);
+    Wire.write((uint8_t)0x40);  // Data stream
+    Wire.write(data + column, count);
+    Wire.endTransmission();
+    displayBytesSent += count;
+  }
+}
+
+// ===========================================
+// UI RENDERING
+// ===========================================
+
+/**
+ * Draw main dashboard screen showing current stress level.
+ * Displays stress percentage, visual bar, and BLE connection status.
+ */
+void drawDashboard() {
+  if (deviceConnected) {
+    display.fillCircle(5, 5, 3, WHITE);
+  } else {
+    display.drawCircle(5, 5, 3, WHITE);
+  }
+
+  display.setTextSize(1);
+  display.setCursor(35, 10);
   display.print("STRESS %");
 
   display.setTextSize(2);
@@ -1332,190 +3530,2199 @@ void drawInfoScreen() {
   display.print("HR:");
   display.print(hrSensorActive ? "OK" : "NO");
 
-  display.setCursor(0, 54);
-  display.print("HRV Beats:");
-  display.print(count);
+  display.setCursor(0, 54);
+  display.print("HRV Beats:");
+  display.print(count);
+  
+  // BLE connection interval of the first connected client (ms)
+  uint16_t interval = 0;
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS && interval == 0; i++) {
+    if (bleClients[i].connected) interval = bleClients[i].connInterval;
+  }
+  display.setCursor(80, 54);
+  display.print("CI:");
+  if (interval > 0) {
+    display.print((interval * 5) / 4);
+  } else {
+    display.print("--");
+  }
+}
+
+/**
+ * Draw today's stress trend: average stress per hour as a sparkline,
+ * minutes above 70% stress per hour as bars, and a marker under the
+ * current hour. The current hour comes from the live accumulator.
+ * Uses the geometry cached by refreshTrendGeometry().
+ */
+void drawTrendScreen() {
+  refreshTrendGeometry();
+  
+  display.setTextSize(1);
+  display.setCursor(0, 0);
+  display.print("TODAY");
+  
+  int liveStress = liveHourStress();
+  if (liveStress >= 0) {
+    display.setCursor(80, 0);
+    display.print("NOW ");
+    display.print(liveStress);
+    display.print("%");
+  }
+  
+  display.drawSparkline(TREND_LEFT, TREND_SPARK_BASE, TREND_PITCH, trendSpark, HOURS_PER_DAY, WHITE);
+  display.drawBars(TREND_LEFT, TREND_BAR_BASE, TREND_PITCH, trendBars, HOURS_PER_DAY, WHITE);
+  
+  if (currentHour >= 0) {
+    display.fillRect(TREND_LEFT + currentHour * TREND_PITCH, TREND_MARKER_Y, TREND_PITCH - 1, 2, WHITE);
+  }
+}
+
+/**
+ * Average stress of the current hour so far, as shown by "NOW" on the
+ * trend screen.
+ * 
+ * @return Average stress (0-100), or -1 before the hour has a sample
+ */
+int liveHourStress() {
+  if (currentHour < 0 || hourAccum.sampleCount == 0) return -1;
+  return (int)min(hourAccum.stressSum / hourAccum.sampleCount, (uint32_t)100);
+}
+
+/**
+ * Bring the cached trend heights up to date. Stored hours are rescaled
+ * only when historySeq or the hour changed; the live hour is recomputed
+ * from the accumulator every call (two divisions).
+ * 
+ * @return true if any cached height changed (trendVersion was bumped)
+ */
+bool refreshTrendGeometry() {
+  bool changed = false;
+  
+  if (trendSeq != historySeq || trendHour != currentHour) {
+    for (uint8_t h = 0; h < HOURS_PER_DAY; h++) {
+      if (todayData[h].sampleCount == 0) {
+        trendSpark[h] = SCENE_NO_VALUE;
+        trendBars[h] = SCENE_NO_VALUE;
+      } else {
+        trendSpark[h] = (uint16_t)min(todayData[h].avgStress, (uint8_t)100) * TREND_SPARK_HEIGHT / 100;
+        trendBars[h] = (uint16_t)min(todayData[h].highStressMins, (uint8_t)60) * TREND_BAR_HEIGHT / 60;
+      }
+    }
+    trendSeq = historySeq;
+    trendHour = currentHour;
+    changed = true;
+  }
+  
+  int stress = liveHourStress();
+  if (stress >= 0) {
+    uint8_t spark = (uint16_t)stress * TREND_SPARK_HEIGHT / 100;
+    uint8_t bar = (uint16_t)min(hourAccum.highStressMins, (uint8_t)60) * TREND_BAR_HEIGHT / 60;
+    if (trendSpark[currentHour] != spark || trendBars[currentHour] != bar) {
+      trendSpark[currentHour] = spark;
+      trendBars[currentHour] = bar;
+      changed = true;
+    }
+  }
+  
+  if (changed) trendVersion++;
+  return changed;
+}
+
+// ===========================================
+// BLE EVENT PROCESSING
+// ===========================================
+
+/**
+ * Queue a BLE event for loop() (called from BLE stack task only).
+ * Never blocks: if the queue is full or the payload too large, the event
+ * is dropped and counted.
+ * 
+ * @param client Client slot the event belongs to
+ * @param type Event type (BLE_EVENT_*)
+ * @param data Payload bytes (may be nullptr when length is 0)
+ * @param length Payload length
+ * @return true if queued
+ */
+bool pushBleEvent(uint8_t client, uint8_t type, const uint8_t* data, size_t length) {
+  uint8_t tail = bleEventTail.load(std::memory_order_relaxed);
+  uint8_t next = (tail + 1) & (BLE_EVENT_QUEUE_SIZE - 1);
+  
+  if (next == bleEventHead.load(std::memory_order_acquire) || length > BLE_EVENT_MAX_LENGTH) {
+    bleEventsDropped++;
+    return false;
+  }
+  
+  BleEvent &event = bleEventQueue[tail];
+  event.client = client;
+  event.type = type;
+  event.receivedMillis = millis();
+  event.length = (uint8_t)length;
+  if (length > 0) {
+    memcpy(event.data, data, length);
+  }
+  
+  // Publish slot contents before the new tail becomes visible to loop()
+  bleEventTail.store(next, std::memory_order_release);
+  wakeLoop();
+  return true;
+}
+
+/**
+ * Drain the BLE event queue and apply each event (called from loop() only).
+ */
+void processBleEvents() {
+  uint8_t head = bleEventHead.load(std::memory_order_relaxed);
+  
+  while (head != bleEventTail.load(std::memory_order_acquire)) {
+    BleEvent &event = bleEventQueue[head];
+    BleClient &client = bleClients[event.client % BLE_MAX_CLIENTS];
+    
+    switch (event.type) {
+      case BLE_EVENT_COMMAND:
+        handleCommand(event.client, event.data, event.length, event.receivedMillis);
+        break;
+        
+      case BLE_EVENT_CONNECTED:
+        // New client starts in legacy mode until it opts in to batching
+        resetBleClient(client);
+        client.connected = true;
+        memcpy(client.peerAddress, event.data, sizeof(client.peerAddress));
+        client.connectedAtMillis = millis();
+        client.notifySent = client.notifyCompleted;  // Nothing in flight yet
+        client.completedDeficit = 0;
+        bleClientCount++;
+        deviceConnected = true;
+        
+        // The controller stops advertising when a central connects
+        advertisingActive = false;
+        advertisingRestartPending = true;
+        connectionChangedAt = millis();
+        break;
+        
+      case BLE_EVENT_DISCONNECTED:
+        if (!client.connected) break;
+        client.connected = false;
+        bleClientCount--;
+        deviceConnected = (bleClientCount > 0);
+        advertisingRestartPending = true;
+        connectionChangedAt = millis();
+        
+        if (notifyCalls > 0) {
+          Serial.print("Notify cost (" BLE_BACKEND_NAME "): ");
+          Serial.print(notifyCalls);
+          Serial.print(" calls, avg ");
+          Serial.print(notifyTotalUs / notifyCalls);
+          Serial.print("us, max ");
+          Serial.print(notifyMaxUs);
+          Serial.println("us");
+          notifyCalls = 0;
+          notifyTotalUs = 0;
+          notifyMaxUs = 0;
+        }
+        
+        Serial.print("Live notifications: ");
+        Serial.print(liveNotifySent);
+        Serial.print(" sent, ");
+        Serial.print(liveNotifySuppressed);
+        Serial.println(" suppressed");
+        
+        client.subscriptions = 0;
+        updateWaveSubscribers();
+        
+        // Loaded block is still in flash; the next drain resumes where this one stopped
+        if (offlineDrainActive && offlineDrainClient == event.client) {
+          stopOfflineDrain();
+        }
+        break;
+        
+      case BLE_EVENT_MTU:
+        client.mtu = event.data[0] | (event.data[1] << 8);
+        updateWaveSubscribers();
+        break;
+        
+      case BLE_EVENT_SUBSCRIBE:
+        if (event.data[0] >= BLE_CHANNEL_COUNT) break;
+        if (event.data[1]) {
+          client.subscriptions |= (1 << event.data[0]);
+        } else {
+          client.subscriptions &= ~(1 << event.data[0]);
+        }
+        if (event.data[0] == BLE_CHANNEL_WAVE) {
+          updateWaveSubscribers();
+        }
+        // Drain client turned Sync off without disconnecting
+        if (event.data[0] == BLE_CHANNEL_SYNC && !event.data[1] &&
+            offlineDrainActive && offlineDrainClient == event.client) {
+          stopOfflineDrain();
+        }
+        break;
+    }
+    
+    head = (head + 1) & (BLE_EVENT_QUEUE_SIZE - 1);
+    bleEventHead.store(head, std::memory_order_release);
+  }
+}
+
+/**
+ * Put a client slot back to the state a new connection starts in.
+ * Connection parameters and history read time are left alone - the backend
+ * reports the new connection's parameters before this runs, and clears the
+ * previous peer's when it frees the slot.
+ * 
+ * @param client Client slot
+ */
+void resetBleClient(BleClient &client) {
+  client.connected = false;
+  client.mtu = BLE_DEFAULT_MTU;
+  client.subscriptions = 0;
+  client.liveMode = LIVE_MODE_LEGACY;
+  client.liveSampleIntervalMs = 100;  // 10Hz effective rate in batched mode
+  client.lastLiveSample = 0;
+  client.lastBLENotify = 0;
+  client.liveFieldMask = 0xFFFFFFFF;
+  client.historyFieldMask = 0xFFFFFFFF;
+  client.liveBatchCount = 0;
+  client.lastSentLiveValid = false;  // New client gets a sample straight away
+  client.deltaSyncCursor = -1;
+  client.deltaSyncEncoding = HISTORY_ENCODING_FIXED;
+  client.deltaSyncCompression = HISTORY_COMPRESS_NONE;
+  client.connProfile = CONN_PROFILE_NONE;
+  client.lastBulkActivity = 0;
+  client.lastConnParamRequest = 0;
+  client.sendHead = 0;
+  client.sendCount = 0;
+  client.timeSyncRoundsLeft = 0;
+  client.timeSyncAwaiting = false;
+}
+
+/**
+ * @return true if the client is connected and has notifications enabled on the channel
+ */
+bool clientSubscribed(uint8_t client, uint8_t channel) {
+  return bleClients[client].connected && (bleClients[client].subscriptions & (1 << channel));
+}
+
+/**
+ * Queue a notification for one client if it subscribed to the channel.
+ * A coalescing packet replaces a queued, not yet sent packet on the same
+ * channel (newest live sample wins) and is never refused for space.
+ * 
+ * @param client Client slot
+ * @param channel Notify channel
+ * @param data Payload (copied)
+ * @param length Payload length (at most the client's MTU - 3)
+ * @param coalesce true for packets that only carry the latest state
+ * @return true if queued
+ */
+bool queueNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length, bool coalesce) {
+  if (!clientSubscribed(client, channel)) return false;
+  
+  BleClient &c = bleClients[client];
+  BleSendSlot* slot = nullptr;
+  
+  if (coalesce) {
+    for (uint8_t i = 0; i < c.sendCount; i++) {
+      BleSendSlot &queued = c.sendQueue[(c.sendHead + i) % BLE_SEND_QUEUE_SIZE];
+      if (queued.coalesce && queued.channel == channel) {
+        slot = &queued;
+        bleSendCoalesced++;
+        break;
+      }
+    }
+  }
+  
+  if (slot == nullptr) {
+    if (c.sendCount == BLE_SEND_QUEUE_SIZE) {
+      bleSendDropped++;
+      return false;
+    }
+    slot = &c.sendQueue[(c.sendHead + c.sendCount) % BLE_SEND_QUEUE_SIZE];
+    c.sendCount++;
+    if (c.sendCount > bleSendHighWater) bleSendHighWater = c.sendCount;
+    slot->queuedMillis = millis();
+  }
+  
+  slot->channel = channel;
+  slot->coalesce = coalesce;
+  slot->length = min(length, sizeof(slot->data));
+  memcpy(slot->data, data, slot->length);
+  return true;
+}
+
+/**
+ * @return true if a bulk producer may queue another packet for the client
+ */
+bool sendQueueHasRoom(uint8_t client) {
+  return bleClients[client].sendCount < BLE_SEND_QUEUE_SIZE;
+}
+
+/**
+ * Hand queued notifications to the stack while it has room.
+ * Stops at the in-flight limit, on reported congestion, or when the stack
+ * rejects a packet (kept at the head and retried on a later pass). Packets
+ * for a channel the client has since unsubscribed from are discarded.
+ * 
+ * @param client Client slot
+ */
+void pumpSendQueue(uint8_t client) {
+  BleClient &c = bleClients[client];
+  unsigned long now = millis();
+  
+  while (c.sendCount > 0 && !c.congested) {
+    // Completions lost earlier are counted as received, so later ones
+    // still open the window
+    uint32_t reported = c.notifyCompleted;
+    uint32_t completed = min(reported + c.completedDeficit, c.notifySent);
+    if (c.notifySent - completed >= BLE_MAX_IN_FLIGHT) {
+      // A backend without completion events must not stall the queue forever
+      if (now - c.lastSendMillis < BLE_COMPLETION_TIMEOUT_MS) return;
+      c.completedDeficit = c.notifySent - reported;
+    }
+    
+    BleSendSlot &slot = c.sendQueue[c.sendHead];
+    if (!(c.subscriptions & (1 << slot.channel))) {
+      // Discard: the stack would refuse it until the send timeout
+    } else if (!bleNotify(client, slot.channel, slot.data, slot.length)) {
+      bleSendRetries++;
+      if (now - slot.queuedMillis < BLE_SEND_TIMEOUT_MS) return;
+      bleSendDropped++;
+    } else {
+      c.notifySent++;
+      c.lastSendMillis = now;
+    }
+    
+    c.sendHead = (c.sendHead + 1) % BLE_SEND_QUEUE_SIZE;
+    c.sendCount--;
+  }
+}
+
+/**
+ * @return Notifications waiting in all send queues
+ */
+uint8_t sendQueueDepth() {
+  uint8_t depth = 0;
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (bleClients[i].connected) depth += bleClients[i].sendCount;
+  }
+  return depth;
+}
+
+/**
+ * Recompute the shared waveform stream state after a subscription, MTU or
+ * connection change. Packets are sized for the smallest subscriber MTU so
+ * one packet can go to every subscriber; partial packets are dropped.
+ */
+void updateWaveSubscribers() {
+  bool subscribed = false;
+  uint16_t mtu = BLE_PREFERRED_MTU;
+  
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (clientSubscribed(i, BLE_CHANNEL_WAVE)) {
+      subscribed = true;
+      mtu = min(mtu, bleClients[i].mtu);
+    }
+  }
+  
+  waveSubscribed = subscribed;
+  waveMTU = subscribed ? mtu : BLE_DEFAULT_MTU;
+  irWave.count = 0;
+  gsrWave.count = 0;
+}
+
+/**
+ * Run the live stream and connection policy of every connected client, then
+ * at most one delta sync packet, then hand queued packets to the stack.
+ * Clients are visited from a rotating start so none is always first to meet
+ * a congested stack, and syncing clients take turns for the single bulk
+ * packet, so a long sync to one central never starves live updates to another.
+ * 
+ * @param now Current millis()
+ */
+void serviceBleClients(unsigned long now) {
+  for (uint8_t n = 0; n < BLE_MAX_CLIENTS; n++) {
+    uint8_t i = (bleServiceStart + n) % BLE_MAX_CLIENTS;
+    BleClient &client = bleClients[i];
+    if (!client.connected) continue;
+    
+    if (client.liveMode == LIVE_MODE_BATCHED) {
+      if (now - client.lastLiveSample >= client.liveSampleIntervalMs) {
+        addLiveBatchSample(i);
+        client.lastLiveSample = now;
+      }
+    } else if (client.liveMode == LIVE_MODE_TLV) {
+      if (now - client.lastLiveSample >= client.liveSampleIntervalMs) {
+        sendLiveTlvFrame(i);
+        client.lastLiveSample = now;
+      }
+    } else if (now - client.lastBLENotify >= tunables.notifyPeriodMs) {
+      updateBLEData(i);
+      client.lastBLENotify = now;
+    }
+    
+    updateConnectionPolicy(i);
+    serviceTimeSync(i, now);
+  }
+  
+  // One delta sync packet per pass keeps the loop responsive during sync
+  for (uint8_t n = 0; n < BLE_MAX_CLIENTS; n++) {
+    uint8_t i = (bleBulkNext + n) % BLE_MAX_CLIENTS;
+    if (bleClients[i].connected && bleClients[i].deltaSyncCursor >= 0 && sendQueueHasRoom(i)) {
+      sendDeltaSyncPacket(i);
+      bleBulkNext = (i + 1) % BLE_MAX_CLIENTS;
+      break;
+    }
+  }
+  
+  for (uint8_t n = 0; n < BLE_MAX_CLIENTS; n++) {
+    uint8_t i = (bleServiceStart + n) % BLE_MAX_CLIENTS;
+    if (bleClients[i].connected) pumpSendQueue(i);
+  }
+  bleServiceStart = (bleServiceStart + 1) % BLE_MAX_CLIENTS;
+}
+
+/**
+ * Restart advertising once a connection change has settled, while a client
+ * slot is free. Polled from loop() instead of blocking after a disconnect.
+ */
+void updateAdvertising() {
+  if (!advertisingRestartPending) return;
+  if (millis() - connectionChangedAt < ADVERTISING_RESTART_MS) return;
+  
+  advertisingRestartPending = false;
+  if (!advertisingActive && bleClientCount < BLE_MAX_CLIENTS) {
+    bleStartAdvertising();
+    advertisingActive = true;
+  }
+}
+
+/**
+ * Serve a read of a characteristic with a read callback (BLE stack context).
+ * Stats is packed on every read. Today and Week values are kept current by
+ * updateHistoryValues() in loop(), since packing them reads history that
+ * loop() writes (and Week reads flash); here the read is only recorded.
+ * 
+ * @param client Client slot that issued the read
+ * @param channel BLE_CHANNEL_TODAY, BLE_CHANNEL_WEEK or BLE_CHANNEL_STATS
+ * @param data Set to the packed buffer
+ * @return Number of bytes in the buffer, or 0 to serve the stored value
+ */
+size_t handleBleRead(uint8_t client, uint8_t channel, const uint8_t** data) {
+  if (channel == BLE_CHANNEL_STATS) {
+    *data = bleStatsBuffer;
+    return packStats(bleStatsBuffer);
+  }
+  
+  bleClients[client].lastHistoryRead = millis();
+  return 0;
+}
+
+/**
+ * Repack the Today and Week characteristic values when history changed
+ * (new sequence number, hour change or refresh command). Called every
+ * loop() pass; between changes this is two compares.
+ */
+void updateHistoryValues() {
+  if (bleHistoryVersion == bleHistoryPackedVersion && historySeq == bleHistoryPackedSeq) return;
+  bleHistoryPackedVersion = bleHistoryVersion;
+  bleHistoryPackedSeq = historySeq;
+  
+  packTodayData(bleTodayBuffer);
+  bleSetValue(BLE_CHANNEL_TODAY, bleTodayBuffer, sizeof(bleTodayBuffer));
+  packWeekData(bleWeekBuffer);
+  bleSetValue(BLE_CHANNEL_WEEK, bleWeekBuffer, sizeof(bleWeekBuffer));
+}
+
+/**
+ * Record connection parameters chosen by the central (BLE stack context).
+ * Only stores values for loop() to read.
+ * 
+ * @param client Client slot of the connection
+ * @param interval Connection interval in 1.25ms units
+ * @param latency Slave latency in connection events
+ * @param timeout Supervision timeout in 10ms units
+ */
+void handleConnParamsUpdated(uint8_t client, uint16_t interval, uint16_t latency, uint16_t timeout) {
+  bleClients[client].connInterval = interval;
+  bleClients[client].connLatency = latency;
+  bleClients[client].connTimeout = timeout;
+}
+
+/**
+ * Record that the stack finished sending one notification (BLE stack context).
+ * 
+ * @param client Client slot of the connection
+ */
+void handleNotifyComplete(uint8_t client) {
+  bleClients[client].notifyCompleted++;
+  wakeLoop();
+}
+
+/**
+ * Record the stack's congestion state for a connection (BLE stack context).
+ * 
+ * @param client Client slot of the connection
+ * @param congested true to stop sending until cleared
+ */
+void handleCongestion(uint8_t client, bool congested) {
+  bleClients[client].congested = congested;
+  if (!congested) wakeLoop();
+}
+
+/**
+ * Account the time one bleNotify() call spent in the BLE stack.
+ * 
+ * @param startMicros micros() when the call started
+ */
+void recordNotifyTime(unsigned long startMicros) {
+  uint32_t elapsed = micros() - startMicros;
+  notifyCalls++;
+  notifyTotalUs += elapsed;
+  if (elapsed > notifyMaxUs) notifyMaxUs = elapsed;
+}
+
+/**
+ * Execute an app command written to the Command characteristic.
+ * Command 0x01: Time sync (8 bytes: command + year(2) + month + day + hour + minute + second)
+ * Command 0x02: Force history buffer rebuild
+ * Command 0x03: Live mode (3 bytes: command + mode + sample rate in Hz)
+ * Command 0x04: Delta sync (5-7 bytes: command + last-seen sequence number + encoding + compression)
+ * Command 0x05: TLV field selection (9 bytes: command + live mask + history mask)
+ * Command 0x06: Set tunables (command + up to 3 id/value pairs of 5 bytes)
+ * Command 0x07: Restore default tunables (1 byte)
+ * Command 0x08: Precise time sync (1 byte; starts the exchange, see TIME SYNCHRONIZATION)
+ * Command 0x09: Time sync reply (15 bytes: command + T1 echo + T2 + turnaround)
+ * Command 0x0A: Time zone (5 bytes: command + UTC offset(2) + DST offset + DST rule)
+ * Live mode, delta sync, field selection and time sync rounds apply to the
+ * issuing client only.
+ * 
+ * @param client Client slot that wrote the command
+ * @param data Command bytes
+ * @param length Number of bytes written by the app
+ * @param receivedMillis millis() when the BLE callback received the write
+ */
+void handleCommand(uint8_t client, const uint8_t* data, uint8_t length, unsigned long receivedMillis) {
+  if (length == 0) return;
+  
+  BleClient &c = bleClients[client];
+  
+  uint8_t command = data[0];
+  if (command == 0x01) {
+    // Time sync: 8 bytes total
+    // [0] = command (0x01)
+    // [1-2] = year (little-endian, uint16_t)
+    // [3] = month (1-12)
+    // [4] = day (1-31)
+    // [5] = hour (0-23)
+    // [6] = minute (0-59)
+    // [7] = second (0-59)
+    if (length >= 8) {
+      uint16_t year = ((uint16_t)data[2] << 8) | (uint16_t)data[1];
+      uint8_t month = data[3];
+      uint8_t day = data[4];
+      uint8_t hour = data[5];
+      uint8_t minute = data[6];
+      uint8_t second = data[7];
+      
+      // Validate time values
+      if (year >= 2024 && year <= 2100 &&
+          month >= 1 && month <= 12 &&
+          day >= 1 && day <= 31 &&
+          hour < 24 && minute < 60 && second < 60) {
+        
+        // Fields are local time; the zone offset in effect then gives UTC
+        uint64_t localSeconds = (uint64_t)daysFromCivil(year, month, day) * 86400ULL +
+                                hour * 3600UL + minute * 60UL + second;
+        uint64_t utcSeconds = localSeconds - timeZone.standardOffsetMin * 60LL;
+        utcSeconds = localSeconds - zoneOffsetAt(utcSeconds) * 60LL;
+        uint64_t now = uptimeMicros();
+        setSyncedTime(now - (uint64_t)(uint32_t)(millis() - receivedMillis) * 1000ULL,
+                      utcSeconds * 1000000ULL);
+        logSyncedTime("Time synced");
+      }
+    }
+  } else if (command == 0x02) {
+    bleHistoryVersion++;
+  } else if (command == 0x03) {
+    // Live mode: 3 bytes total
+    // [0] = command (0x03)
+    // [1] = mode (0x00 = legacy 7-byte, 0x01 = batched, 0x02 = TLV)
+    // [2] = effective sample rate in Hz (1-50, batched and TLV modes)
+    if (length >= 3) {
+      uint8_t mode = data[1];
+      uint8_t rateHz = data[2];
+      
+      // Sensors update at 50Hz, so faster rates would only repeat samples
+      if (mode <= LIVE_MODE_TLV && rateHz >= 1 && rateHz <= 50) {
+        c.liveMode = mode;
+        c.liveSampleIntervalMs = 1000 / rateHz;
+        c.liveBatchCount = 0;
+        c.lastSentLiveValid = false;
+      }
+    }
+  } else if (command == 0x04) {
+    // Delta sync: 5-7 bytes
+    // [0] = command (0x04)
+    // [1-4] = last sequence number seen by app (little-endian, uint32_t)
+    // [5] = optional record encoding (0x00 = fixed 10-byte, 0x01 = TLV)
+    // [6] = optional compression (0x00 = none, 0x01 = LZ)
+    // Changed records are streamed from loop() over the Sync characteristic
+    if (length >= 5) {
+      c.deltaSyncFromSeq = (uint32_t)data[1] |
+                           ((uint32_t)data[2] << 8) |
+                           ((uint32_t)data[3] << 16) |
+                           ((uint32_t)data[4] << 24);
+      c.deltaSyncEncoding = (length >= 6 && data[5] == HISTORY_ENCODING_TLV) ?
+                            HISTORY_ENCODING_TLV : HISTORY_ENCODING_FIXED;
+      c.deltaSyncCompression = (length >= 7 && data[6] == HISTORY_COMPRESS_LZ) ?
+                               HISTORY_COMPRESS_LZ : HISTORY_COMPRESS_NONE;
+      c.deltaSyncCursor = 0;
+    }
+  } else if (command == 0x05) {
+    // TLV field selection: 9 bytes total
+    // [0] = command (0x05)
+    // [1-4] = live field mask (bit n = live tag n, little-endian)
+    // [5-8] = history field mask (bit n = history tag 0x20 + n, little-endian)
+    if (length >= 9) {
+      c.liveFieldMask = (uint32_t)data[1] |
+                        ((uint32_t)data[2] << 8) |
+                        ((uint32_t)data[3] << 16) |
+                        ((uint32_t)data[4] << 24);
+      c.historyFieldMask = (uint32_t)data[5] |
+                           ((uint32_t)data[6] << 8) |
+                           ((uint32_t)data[7] << 16) |
+                           ((uint32_t)data[8] << 24);
+    }
+  } else if (command == 0x06) {
+    // Set tunables: 1 + 5n bytes
+    // [0] = command (0x06)
+    // [1] = tunable id (TUNE_*)
+    // [2-5] = value (little-endian; integer or IEEE-754 float per tunable)
+    // ...repeated for further pairs; invalid pairs are ignored
+    // App reads the Tunables characteristic to confirm what was applied
+    bool changed = false;
+    for (uint8_t i = 1; i + 5 <= length; i += 5) {
+      uint32_t value = (uint32_t)data[i + 1] |
+                       ((uint32_t)data[i + 2] << 8) |
+                       ((uint32_t)data[i + 3] << 16) |
+                       ((uint32_t)data[i + 4] << 24);
+      if (setTunable(data[i], value)) changed = true;
+    }
+    if (changed) {
+      saveTunables();
+      publishTunables();
+    }
+  } else if (command == 0x07) {
+    restoreDefaultTunables();
+    saveTunables();
+    publishTunables();
+  } else if (command == 0x08) {
+    // Precise time sync: 1 byte. Device sends TIME_SYNC_ROUNDS requests over
+    // the Sync characteristic (app must be subscribed) and keeps the best reply
+    c.timeSyncRoundsLeft = TIME_SYNC_ROUNDS;
+    c.timeSyncStartMillis = millis();
+    c.timeSyncAwaiting = false;
+    c.timeSyncBestRoundTrip = 0xFFFF;
+  } else if (command == 0x09) {
+    // Time sync reply: 15 bytes total
+    // [0] = command (0x09)
+    // [1-4] = T1 echoed from the request (little-endian, uint32_t)
+    // [5-12] = T2: app UTC time when the request arrived (ms since 1970, little-endian)
+    // [13-14] = T3 - T2: app turnaround in ms (little-endian, uint16_t)
+    if (length >= 15) {
+      handleTimeSyncReply(client, data, receivedMillis);
+    }
+  } else if (command == 0x0A) {
+    // Time zone: 5 bytes total
+    // [0] = command (0x0A)
+    // [1-2] = standard UTC offset in minutes (little-endian, int16_t)
+    // [3] = daylight saving offset in minutes (0 if none)
+    // [4] = daylight saving rule (DST_RULE_*)
+    if (length >= 5) {
+      int16_t offset = (int16_t)((uint16_t)data[1] | ((uint16_t)data[2] << 8));
+      if (offset >= -720 && offset <= 840 && data[3] <= 120 && data[4] <= DST_RULE_US) {
+        timeZone.standardOffsetMin = offset;
+        timeZone.dstOffsetMin = data[3];
+        timeZone.dstRule = data[4];
+        preferences.putInt("tzOffset", timeZone.standardOffsetMin);
+        preferences.putUChar("tzDst", timeZone.dstOffsetMin);
+        preferences.putUChar("tzRule", timeZone.dstRule);
+        
+        // A zone change is a clock step in local time, not an hour rollover
+        if (syncedTime.isValid) {
+          setSyncedTime(syncedTime.uptimeUsAtSync, syncedTime.epochUsAtSync);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Send the next precise time sync request once the previous round is answered
+ * or timed out. A request is only queued while the client's send queue is
+ * empty, so T1 is taken right before the packet reaches the stack, not
+ * while the connection still runs with slave latency, and not during a delta
+ * sync, which shares the Sync characteristic and would delay the reply.
+ * 
+ * @param client Client slot
+ * @param now Current millis()
+ */
+void serviceTimeSync(uint8_t client, unsigned long now) {
+  BleClient &c = bleClients[client];
+  if (c.timeSyncRoundsLeft == 0) return;
+  
+  if (c.timeSyncAwaiting) {
+    if (now - c.timeSyncSentMillis < TIME_SYNC_TIMEOUT_MS) return;
+    c.timeSyncAwaiting = false;
+    c.timeSyncRoundsLeft--;
+  }
+  
+  if (c.timeSyncRoundsLeft == 0) {
+    if (c.timeSyncBestRoundTrip != 0xFFFF) {
+      applyPreciseTime(c.timeSyncBestUptime, c.timeSyncBestOffset, c.timeSyncBestRoundTrip);
+    }
+    return;
+  }
+  
+  if (c.sendCount > 0 || c.deltaSyncCursor >= 0) return;
+  if (c.connLatency > 0 && now - c.timeSyncStartMillis < TIME_SYNC_SETTLE_MS) return;
+  
+  uint8_t request[5];
+  uint32_t t1 = millis();
+  request[0] = TIME_PACKET_REQUEST;
+  memcpy(&request[1], &t1, 4);
+  if (!queueNotify(client, BLE_CHANNEL_SYNC, request, sizeof(request), false)) {
+    c.timeSyncRoundsLeft = 0;  // Not subscribed to Sync
+    return;
+  }
+  c.timeSyncSentMillis = t1;
+  c.timeSyncAwaiting = true;
+}
+
+/**
+ * Evaluate one time sync reply (command 0x09) and keep it if its round trip
+ * is the shortest so far; the final round applies the best offset.
+ * 
+ * @param client Client slot
+ * @param data Command bytes (15)
+ * @param receivedMillis millis() when the write arrived (T4)
+ */
+void handleTimeSyncReply(uint8_t client, const uint8_t* data, unsigned long receivedMillis) {
+  BleClient &c = bleClients[client];
+  
+  uint32_t t1Echo;
+  uint64_t t2;
+  uint16_t turnaround;
+  memcpy(&t1Echo, &data[1], 4);
+  memcpy(&t2, &data[5], 8);
+  memcpy(&turnaround, &data[13], 2);
+  
+  if (!c.timeSyncAwaiting || t1Echo != (uint32_t)c.timeSyncSentMillis) return;  // Stale reply
+  
+  // Everything in microseconds; T1 and T4 extended to 64-bit uptime
+  uint32_t nowMillis = millis();
+  uint64_t now = uptimeMicros();
+  int64_t t1 = (int64_t)(now - (uint64_t)(uint32_t)(nowMillis - t1Echo) * 1000ULL);
+  int64_t t4 = (int64_t)(now - (uint64_t)(uint32_t)(nowMillis - receivedMillis) * 1000ULL);
+  int64_t t2us = (int64_t)t2 * 1000LL;
+  int64_t t3us = t2us + turnaround * 1000LL;
+  
+  int64_t roundTrip = ((t4 - t1) - turnaround * 1000LL) / 1000;
+  if (roundTrip < 0) roundTrip = 0;
+  int64_t offset = ((t2us - t1) + (t3us - t4)) / 2;
+  
+  if (roundTrip < c.timeSyncBestRoundTrip) {
+    c.timeSyncBestRoundTrip = (uint16_t)min(roundTrip, (int64_t)0xFFFE);
+    c.timeSyncBestOffset = offset;
+    c.timeSyncBestUptime = (uint64_t)t4;
+  }
+  
+  c.timeSyncAwaiting = false;
+  c.timeSyncRoundsLeft--;
+  if (c.timeSyncRoundsLeft == 0) {
+    applyPreciseTime(c.timeSyncBestUptime, c.timeSyncBestOffset, c.timeSyncBestRoundTrip);
+  }
+}
+
+// ===========================================
+// BLE INITIALIZATION
+// ===========================================
+
+/**
+ * Initialize Bluetooth Low Energy service and characteristics.
+ * Sets up four characteristics:
+ * - Live: Real-time sensor data notifications (7 bytes)
+ * - Today: 24-hour hourly summaries (240 bytes, on-demand read)
+ * - Week: 7-day daily summaries (70 bytes, on-demand read)
+ * - Command: App control commands (write-only)
+ * - Wave: Raw IR/GSR waveform stream (notify, subscribe-on-demand)
+ * - Sync: Changed history records and offline sample drain (notify)
+ * - Caps: Protocol version, supported fields, rates and commands (read-only)
+ * - Tune: Runtime tunables in effect (read-only)
+ * 
+ * The GATT stack itself lives behind the BLE transport functions so the
+ * protocol code can run against other backends (see BLE_BACKEND). Logs the
+ * heap taken by the stack so backends can be compared on real hardware.
+ */
+void initBLE() {
+  uint32_t heapBefore = ESP.getFreeHeap();
+  
+  bleTransportInit();
+  buildCapabilities();
+  publishTunables();
+  bleStartAdvertising();
+  advertisingActive = true;
+  
+  // Footprint of the selected stack, for comparing backends on the device
+  Serial.print("BLE backend: " BLE_BACKEND_NAME ", heap used ");
+  Serial.print(heapBefore - ESP.getFreeHeap());
+  Serial.print(" bytes, free heap ");
+  Serial.print(ESP.getFreeHeap());
+  Serial.print(" bytes, sketch ");
+  Serial.print(ESP.getSketchSize());
+  Serial.println(" bytes");
+}
+
+/**
+ * Write one TLV field (tag, length, little-endian value).
+ * 
+ * @param buffer Output buffer
+ * @param tag Field tag
+ * @param value Field value
+ * @param size Value size in bytes (1, 2 or 4)
+ * @return Number of bytes written
+ */
+uint8_t putTlv(uint8_t* buffer, uint8_t tag, uint32_t value, uint8_t size) {
+  buffer[0] = tag;
+  buffer[1] = size;
+  for (uint8_t i = 0; i < size; i++) {
+    buffer[2 + i] = (uint8_t)((value >> (8 * i)) & 0xFF);
+  }
+  return 2 + size;
+}
+
+/**
+ * Write one history TLV field if the app selected it in its history field mask.
+ * 
+ * @return Number of bytes written (0 if the field is masked out)
+ */
+uint8_t putHistTlv(uint8_t* buffer, uint32_t mask, uint8_t tag, uint32_t value, uint8_t size) {
+  if (!(mask & (1UL << (tag - 0x20)))) return 0;
+  return putTlv(buffer, tag, value, size);
+}
+
+/**
+ * Encode one live field as TLV. Adding a metric means adding its tag to
+ * TLV_LIVE_FIELDS and a case here - existing clients skip unknown tags.
+ * 
+ * @param tag Live field tag
+ * @param buffer Output buffer (at least 6 bytes)
+ * @return Number of bytes written (0 for unknown tags)
+ */
+uint8_t packLiveTlvField(uint8_t tag, uint8_t* buffer) {
+  switch (tag) {
+    case TLV_LIVE_STRESS:         return putTlv(buffer, tag, (uint8_t)constrain(stressIndex, 0, 100), 1);
+    case TLV_LIVE_HR:             return putTlv(buffer, tag, currentHR, 1);
+    case TLV_LIVE_HRV:            return putTlv(buffer, tag, (uint16_t)currentHRV, 2);
+    case TLV_LIVE_GSR:            return putTlv(buffer, tag, (uint16_t)currentGSR, 2);
+    case TLV_LIVE_STATUS: {
+      uint8_t sample[7];
+      packLiveSample(sample);
+      return putTlv(buffer, tag, sample[6], 1);
+    }
+    case TLV_LIVE_STRESS_DISPLAY: return putTlv(buffer, tag, (uint8_t)constrain(stressIndexDisplay, 0, 100), 1);
+    case TLV_LIVE_ACTIVITY:       return putTlv(buffer, tag, currentActivity, 1);
+    case TLV_LIVE_MOTION_VAR:     return putTlv(buffer, tag, (uint16_t)constrain(motionVariance * 1000, 0, 65535), 2);
+    case TLV_LIVE_HRV_BASELINE:   return putTlv(buffer, tag, (uint16_t)longTermHRV, 2);
+    case TLV_LIVE_RAW_GSR:        return putTlv(buffer, tag, (uint16_t)rawGSR, 2);
+    case TLV_LIVE_RAW_IR:         return putTlv(buffer, tag, (uint32_t)rawIR, 4);
+    case TLV_LIVE_TIMESTAMP:      return putTlv(buffer, tag, millis(), 4);
+  }
+  return 0;
+}
+
+/**
+ * Send one TLV live frame with the fields the client selected.
+ * Fields that would overflow the client's MTU are omitted, so clients on
+ * small MTUs should request only the fields they render.
+ * 
+ * Frame format:
+ *   [0] frame type (0xE1)
+ *   [1] protocol version
+ *   [2..] TLV fields
+ * 
+ * @param client Client slot
+ */
+void sendLiveTlvFrame(uint8_t client) {
+  if (!clientSubscribed(client, BLE_CHANNEL_LIVE)) return;
+  
+  const BleClient &c = bleClients[client];
+  uint16_t payloadSize = min((int)c.mtu, BLE_PREFERRED_MTU) - 3;
+  uint16_t length = 2;
+  uint8_t field[6];
+  
+  bleLiveTlvBuffer[0] = TLV_LIVE_FRAME;
+  bleLiveTlvBuffer[1] = TLV_PROTOCOL_VERSION;
+  
+  for (size_t i = 0; i < sizeof(TLV_LIVE_FIELDS); i++) {
+    uint8_t tag = TLV_LIVE_FIELDS[i];
+    if (!(c.liveFieldMask & (1UL << tag))) continue;
+    
+    uint8_t fieldSize = packLiveTlvField(tag, field);
+    if (length + fieldSize > payloadSize) continue;
+    
+    memcpy(bleLiveTlvBuffer + length, field, fieldSize);
+    length += fieldSize;
+  }
+  
+  queueNotify(client, BLE_CHANNEL_LIVE, bleLiveTlvBuffer, length, true);
+}
+
+/**
+ * Encode an hourly record as history TLV fields.
+ * 
+ * @param hour Hour index (0-23)
+ * @param mask History field mask selected by the client (command 0x05)
+ * @param buffer Output buffer (at least DELTA_TLV_MAX_RECORD bytes)
+ * @return Number of bytes written
+ */
+uint8_t packHourTlv(int hour, uint32_t mask, uint8_t* buffer) {
+  HourlySummary &h = todayData[hour];
+  uint8_t length = 0;
+  
+  length += putHistTlv(buffer + length, mask, TLV_HIST_HOUR, h.hour, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_STRESS, h.avgStress, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_PEAK_STRESS, h.peakStress, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_HIGH_MINS, h.highStressMins, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_HR, h.avgHR, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_HRV, h.avgHRV, 2);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_GSR, h.avgGSR, 2);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_SAMPLE_COUNT, h.sampleCount, 2);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_ACTIVITY, h.avgActivityLevel, 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_VALID, h.sampleCount > 0 ? 1 : 0, 1);
+  
+  return length;
+}
+
+/**
+ * Encode a daily summary as history TLV fields.
+ * 
+ * @param day Storage slot index (0-6)
+ * @param mask History field mask selected by the client (command 0x05)
+ * @param buffer Output buffer (at least DELTA_TLV_MAX_RECORD bytes)
+ * @return Number of bytes written
+ */
+uint8_t packDayTlv(int day, uint32_t mask, uint8_t* buffer) {
+  uint8_t record[10];
+  uint8_t length = 0;
+  
+  packDaySummary(day, record);
+  
+  length += putHistTlv(buffer + length, mask, TLV_HIST_DAY, record[0], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_STRESS, record[1], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_PEAK_STRESS, record[2], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_PEAK_HOUR, record[3], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_HIGH_MINS, record[4], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_HR, record[5], 1);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_AVG_HRV, record[6] | (record[7] << 8), 2);
+  length += putHistTlv(buffer + length, mask, TLV_HIST_VALID, record[9], 1);
+  
+  return length;
+}
+
+/**
+ * Build the read-only capabilities value from the supported field,
+ * command and mode tables. Called once from initBLE().
+ * 
+ * Format:
+ *   [0] protocol version
+ *   [1..] TLV entries (TLV_CAP_* tags)
+ */
+void buildCapabilities() {
+  uint8_t* p = bleCapsBuffer;
+  *p++ = TLV_PROTOCOL_VERSION;
+  
+  *p++ = TLV_CAP_LIVE_FIELDS;
+  *p++ = sizeof(TLV_LIVE_FIELDS);
+  memcpy(p, TLV_LIVE_FIELDS, sizeof(TLV_LIVE_FIELDS));
+  p += sizeof(TLV_LIVE_FIELDS);
+  
+  *p++ = TLV_CAP_HIST_FIELDS;
+  *p++ = sizeof(TLV_HIST_FIELDS);
+  memcpy(p, TLV_HIST_FIELDS, sizeof(TLV_HIST_FIELDS));
+  p += sizeof(TLV_HIST_FIELDS);
+  
+  *p++ = TLV_CAP_COMMANDS;
+  *p++ = sizeof(SUPPORTED_COMMANDS);
+  memcpy(p, SUPPORTED_COMMANDS, sizeof(SUPPORTED_COMMANDS));
+  p += sizeof(SUPPORTED_COMMANDS);
+  
+  *p++ = TLV_CAP_LIVE_MODES;
+  *p++ = 3;
+  *p++ = LIVE_MODE_LEGACY;
+  *p++ = LIVE_MODE_BATCHED;
+  *p++ = LIVE_MODE_TLV;
+  
+  *p++ = TLV_CAP_LIVE_RATES;
+  *p++ = 2;
+  *p++ = 1;   // Min Hz
+  *p++ = 50;  // Max Hz (sensor acquisition rate)
+  
+  *p++ = TLV_CAP_WAVE_STREAMS;
+  *p++ = 4;
+  *p++ = WAVE_STREAM_IR;
+  *p++ = irWave.intervalMs;
+  *p++ = WAVE_STREAM_GSR;
+  *p++ = WAVE_GSR_INTERVAL_MS;
+  
+  p += putTlv(p, TLV_CAP_MTU, BLE_PREFERRED_MTU, 2);
+  
+  *p++ = TLV_CAP_COMPRESSION;
+  *p++ = 1;
+  *p++ = HISTORY_COMPRESS_LZ;
+  
+  bleSetValue(BLE_CHANNEL_CAPS, bleCapsBuffer, p - bleCapsBuffer);
+}
+
+/**
+ * Choose connection parameters for the current workload.
+ * Requests a fast interval right after connecting and while bulk transfers
+ * (delta sync, history reads, waveform streaming) or a time sync are active,
+ * then falls back to a long interval with slave latency once only 1Hz live data remains.
+ * Requests are rate limited and only sent when the wanted profile changes.
+ * Each connection has its own parameters, so a syncing phone doesn't keep
+ * an idle desktop on the fast profile.
+ * 
+ * @param client Client slot
+ */
+void updateConnectionPolicy(uint8_t client) {
+  BleClient &c = bleClients[client];
+  if (!c.connected) return;
+  
+  unsigned long now = millis();
+  
+  if (c.deltaSyncCursor >= 0 || clientSubscribed(client, BLE_CHANNEL_WAVE) ||
+      (offlineDrainActive && offlineDrainClient == client) || c.timeSyncRoundsLeft > 0) {
+    c.lastBulkActivity = now;
+  }
+  if ((long)(c.lastHistoryRead - c.lastBulkActivity) > 0) {
+    c.lastBulkActivity = c.lastHistoryRead;
+  }
+  
+  bool wantFast = (now - c.connectedAtMillis < CONN_STARTUP_FAST_MS) ||
+                  (now - c.lastBulkActivity < CONN_FAST_LINGER_MS);
+  uint8_t profile = wantFast ? CONN_PROFILE_FAST : CONN_PROFILE_IDLE;
+  
+  if (profile == c.connProfile) return;
+  if (now - c.lastConnParamRequest < CONN_UPDATE_MIN_GAP_MS) return;
+  
+  if (profile == CONN_PROFILE_FAST) {
+    bleUpdateConnParams(client, CONN_FAST_MIN_INTERVAL, CONN_FAST_MAX_INTERVAL,
+                        CONN_FAST_LATENCY, CONN_FAST_TIMEOUT);
+  } else {
+    bleUpdateConnParams(client, CONN_IDLE_MIN_INTERVAL, CONN_IDLE_MAX_INTERVAL,
+                        CONN_IDLE_LATENCY, CONN_IDLE_TIMEOUT);
+  }
+  
+  c.connProfile = profile;
+  c.lastConnParamRequest = now;
+  
+  Serial.print("Conn params requested for client ");
+  Serial.print(client);
+  Serial.print(": ");
+  Serial.print(profile == CONN_PROFILE_FAST ? "FAST" : "IDLE");
+  Serial.print(" (current interval ");
+  Serial.print((c.connInterval * 5) / 4);
+  Serial.print("ms, latency ");
+  Serial.print(c.connLatency);
+  Serial.println(")");
+}
+
+/**
+ * Send live sensor data via BLE notification.
+ * Packs current sensor readings into 7-byte packet format.
+ * Called every notify period (1Hz by default) when a client is connected,
+ * but only notifies when the reading changed or the keepalive is due, so a
+ * resting user causes far less radio traffic. Format matches parser.js.
+ * 
+ * Packet format:
+ *   [0] stress index (0-100)
+ *   [1] heart rate BPM (0-255)
+ *   [2-3] HRV in ms (16-bit little-endian)
+ *   [4-5] GSR raw value (16-bit little-endian)
+ *   [6] status byte (bit flags for sensor states)
+ * 
+ * @param client Client slot
+ */
+void updateBLEData(uint8_t client) {
+  if (!clientSubscribed(client, BLE_CHANNEL_LIVE)) return;
+  
+  BleClient &c = bleClients[client];
+  uint8_t buffer[7];
+  packLiveSample(buffer);
+  
+  unsigned long now = millis();
+  bool keepaliveDue = now - c.lastLiveSentMillis >= tunables.liveKeepaliveS * 1000UL;
+  
+  if (c.lastSentLiveValid && !keepaliveDue && !liveSampleChanged(c, buffer)) {
+    liveNotifySuppressed++;
+    return;
+  }
+  
+  // Coalesces with a queued sample the link hasn't sent yet
+  if (queueNotify(client, BLE_CHANNEL_LIVE, buffer, 7, true)) {
+    memcpy(c.lastSentLive, buffer, sizeof(c.lastSentLive));
+    c.lastSentLiveValid = true;
+    c.lastLiveSentMillis = now;
+    liveNotifySent++;
+  }
+}
+
+/**
+ * Compare a packed live sample with the last one sent to a client.
+ * 
+ * @param client Client state
+ * @param sample 7-byte live sample
+ * @return true if the status byte differs or any reading moved past its deadband
+ */
+bool liveSampleChanged(const BleClient &client, const uint8_t* sample) {
+  const uint8_t* last = client.lastSentLive;
+  int hrv = sample[2] | (sample[3] << 8);
+  int gsr = sample[4] | (sample[5] << 8);
+  int lastHrv = last[2] | (last[3] << 8);
+  int lastGsr = last[4] | (last[5] << 8);
+  
+  return sample[6] != last[6] ||
+         abs(sample[0] - last[0]) > tunables.deadbandStress ||
+         abs(sample[1] - last[1]) > tunables.deadbandHR ||
+         abs(hrv - lastHrv) > tunables.deadbandHRV ||
+         abs(gsr - lastGsr) > tunables.deadbandGSR;
+}
+
+/**
+ * Pack runtime counters for the Stats characteristic.
+ * 
+ * Format:
+ *   [0] protocol version
+ *   [1..] TLV entries (TLV_STAT_* tags)
+ * 
+ * @param buffer Output buffer (bleStatsBuffer)
+ * @return Number of bytes written
+ */
+size_t packStats(uint8_t* buffer) {
+  uint8_t* p = buffer;
+  *p++ = TLV_PROTOCOL_VERSION;
+  p += putTlv(p, TLV_STAT_LIVE_SENT, liveNotifySent, 4);
+  p += putTlv(p, TLV_STAT_LIVE_SUPPRESSED, liveNotifySuppressed, 4);
+  p += putTlv(p, TLV_STAT_EVENTS_DROPPED, bleEventsDropped, 2);
+  p += putTlv(p, TLV_STAT_SEND_DEPTH, sendQueueDepth(), 1);
+  p += putTlv(p, TLV_STAT_SEND_HIGH, bleSendHighWater, 1);
+  p += putTlv(p, TLV_STAT_SEND_DROPPED, bleSendDropped, 4);
+  p += putTlv(p, TLV_STAT_SEND_COALESCED, bleSendCoalesced, 4);
+  p += putTlv(p, TLV_STAT_SEND_RETRIES, bleSendRetries, 4);
+  p += putTlv(p, TLV_STAT_RENDER_FPS, renderFps, 1);
+  p += putTlv(p, TLV_STAT_FRAMES_DEFERRED, framesDeferred, 4);
+  p += putTlv(p, TLV_STAT_AWAKE_PERMILLE, awakePermille, 2);
+  p += putTlv(p, TLV_STAT_IR_LATE_MAX, irSampleLateMaxMs, 2);
+  return p - buffer;
+}
+
+/**
+ * Refresh the broadcast summary in the advertising data.
+ * Runs whether or not a client is connected; the controller only transmits
+ * it while advertising. Turning broadcast off removes the manufacturer data.
+ * 
+ * Manufacturer data format:
+ *   [0-1] company id (0xFFFF, little-endian)
+ *   [2] format (0x01)
+ *   [3] sequence (increments on every update, wraps)
+ *   [4-10] 7-byte live sample (same layout as the Live characteristic)
+ */
+void updateBroadcast() {
+  unsigned long now = millis();
+  
+  if (tunables.broadcastPeriodMs == 0) {
+    if (broadcastActive) {
+      bleSetBroadcastData(nullptr, 0);
+      broadcastActive = false;
+    }
+    return;
+  }
+  
+  if (broadcastActive && now - lastBroadcastUpdate < tunables.broadcastPeriodMs) return;
+  
+  broadcastBuffer[0] = (uint8_t)(BROADCAST_COMPANY_ID & 0xFF);
+  broadcastBuffer[1] = (uint8_t)(BROADCAST_COMPANY_ID >> 8);
+  broadcastBuffer[2] = BROADCAST_FORMAT;
+  broadcastBuffer[3] = broadcastSequence++;
+  packLiveSample(broadcastBuffer + 4);
+  
+  bleSetBroadcastData(broadcastBuffer, BROADCAST_SIZE);
+  broadcastActive = true;
+  lastBroadcastUpdate = now;
+}
+
+/**
+ * Pack current sensor readings into the 7-byte live sample layout.
+ * Shared by legacy notifications and batched samples so both stay in sync.
+ * 
+ * @param buffer Output buffer (must be 7 bytes)
+ */
+void packLiveSample(uint8_t* buffer) {
+  buffer[0] = (uint8_t)constrain(stressIndex, 0, 100);
+  buffer[1] = currentHR;
+  buffer[2] = (uint8_t)((uint16_t)currentHRV & 0xFF);
+  buffer[3] = (uint8_t)(((uint16_t)currentHRV >> 8) & 0xFF);
+  buffer[4] = (uint8_t)((uint16_t)currentGSR & 0xFF);
+  buffer[5] = (uint8_t)(((uint16_t)currentGSR >> 8) & 0xFF);
+  buffer[6] = (hrSensorActive ? 0x01 : 0x00) |
+              (calibrationComplete ? 0x02 : 0x00) |
+              (motionDetected ? 0x04 : 0x00) |
+              ((currentActivity & 0x03) << 3) |
+              (mpuReady ? 0x80 : 0x00);
+}
+
+/**
+ * Append one timestamped sample to the live batch (batched mode only).
+ * Called at the configured effective rate. The batch is sent as soon as
+ * another sample would not fit in the negotiated MTU, or once it has been
+ * held for LIVE_BATCH_MAX_LATENCY so the app chart never stalls.
+ * 
+ * Packet format:
+ *   [0] marker (0xB1)
+ *   [1] sample count
+ *   [2-5] timestamp of first sample in ms (32-bit little-endian, device millis())
+ *   Per sample (9 bytes):
+ *     [0-1] offset from first sample in ms (16-bit little-endian)
+ *     [2-8] 7-byte live sample (same layout as legacy packet)
+ * 
+ * @param client Client slot
+ */
+void addLiveBatchSample(uint8_t client) {
+  if (!clientSubscribed(client, BLE_CHANNEL_LIVE)) return;
+  
+  BleClient &c = bleClients[client];
+  unsigned long now = millis();
+  
+  if (c.liveBatchCount == 0) {
+    c.liveBatchStartMillis = now;
+    c.liveBatchBuffer[0] = LIVE_BATCH_MARKER;
+    c.liveBatchBuffer[2] = (uint8_t)(now & 0xFF);
+    c.liveBatchBuffer[3] = (uint8_t)((now >> 8) & 0xFF);
+    c.liveBatchBuffer[4] = (uint8_t)((now >> 16) & 0xFF);
+    c.liveBatchBuffer[5] = (uint8_t)((now >> 24) & 0xFF);
+  }
+  
+  uint16_t timeOffset = (uint16_t)(now - c.liveBatchStartMillis);
+  uint8_t* sample = c.liveBatchBuffer + LIVE_BATCH_HEADER_SIZE + c.liveBatchCount * LIVE_SAMPLE_SIZE;
+  sample[0] = (uint8_t)(timeOffset & 0xFF);
+  sample[1] = (uint8_t)((timeOffset >> 8) & 0xFF);
+  packLiveSample(sample + 2);
+  c.liveBatchCount++;
+  
+  // Payload capacity is MTU minus 3-byte ATT notification header
+  uint16_t payloadSize = min((int)c.mtu, BLE_PREFERRED_MTU) - 3;
+  uint16_t nextSize = LIVE_BATCH_HEADER_SIZE + (c.liveBatchCount + 1) * LIVE_SAMPLE_SIZE;
+  
+  if (nextSize > payloadSize || (now - c.liveBatchStartMillis) >= LIVE_BATCH_MAX_LATENCY) {
+    flushLiveBatch(client);
+  }
+}
+
+/**
+ * Send a client's pending live batch as a single notification and reset it.
+ * 
+ * @param client Client slot
+ */
+void flushLiveBatch(uint8_t client) {
+  BleClient &c = bleClients[client];
+  if (c.liveBatchCount == 0) return;
+  
+  c.liveBatchBuffer[1] = c.liveBatchCount;
+  queueNotify(client, BLE_CHANNEL_LIVE, c.liveBatchBuffer,
+              LIVE_BATCH_HEADER_SIZE + c.liveBatchCount * LIVE_SAMPLE_SIZE, false);
+  c.liveBatchCount = 0;
+}
+
+/**
+ * Append one raw sample to a waveform stream packet (delta encoded).
+ * The first sample of each packet is stored in full, later samples as
+ * zigzag varint deltas from their predecessor (1 byte for |delta| < 64,
+ * 2 bytes for < 8192). Packets are sent when the next worst-case sample
+ * would overflow the smallest subscriber MTU or after WAVE_MAX_LATENCY.
+ * 
+ * Packet format:
+ *   [0] stream type (0x01 = IR, 0x02 = GSR)
+ *   [1-2] sequence number (16-bit little-endian, per stream, wraps)
+ *   [3] sample count
+ *   [4] sample interval in ms
+ *   [5-8] first sample (32-bit little-endian, signed)
+ *   [9..] zigzag varint deltas for remaining samples
+ * 
+ * @param stream Waveform stream state
+ * @param value Raw sensor sample
+ */
+void addWaveSample(WaveStream &stream, int32_t value) {
+  if (!waveSubscribed) return;
+  
+  unsigned long now = millis();
+  
+  if (stream.count == 0) {
+    stream.startMillis = now;
+    stream.buffer[0] = stream.type;
+    stream.buffer[1] = (uint8_t)(stream.sequence & 0xFF);
+    stream.buffer[2] = (uint8_t)((stream.sequence >> 8) & 0xFF);
+    stream.buffer[4] = stream.intervalMs;
+    stream.buffer[5] = (uint8_t)(value & 0xFF);
+    stream.buffer[6] = (uint8_t)((value >> 8) & 0xFF);
+    stream.buffer[7] = (uint8_t)((value >> 16) & 0xFF);
+    stream.buffer[8] = (uint8_t)((value >> 24) & 0xFF);
+    stream.length = WAVE_HEADER_SIZE;
+  } else {
+    int32_t delta = value - stream.lastValue;
+    uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    
+    while (zigzag >= 0x80) {
+      stream.buffer[stream.length++] = (uint8_t)(zigzag | 0x80);
+      zigzag >>= 7;
+    }
+    stream.buffer[stream.length++] = (uint8_t)zigzag;
+  }
+  
+  stream.lastValue = value;
+  stream.count++;
+  
+  uint16_t payloadSize = min((int)waveMTU, BLE_PREFERRED_MTU) - 3;
+  
+  if (stream.length + WAVE_MAX_DELTA_SIZE > payloadSize ||
+      stream.count == 255 ||
+      (now - stream.startMillis) >= WAVE_MAX_LATENCY) {
+    flushWaveStream(stream);
+  }
+}
+
+/**
+ * Send a pending waveform packet to every subscriber and advance its
+ * sequence number.
+ * 
+ * @param stream Waveform stream state
+ */
+void flushWaveStream(WaveStream &stream) {
+  if (stream.count == 0) return;
+  
+  stream.buffer[3] = stream.count;
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    queueNotify(i, BLE_CHANNEL_WAVE, stream.buffer, stream.length, false);
+  }
+  
+  stream.sequence++;
+  stream.count = 0;
+}
+
+/**
+ * Pack today's 24 hourly summaries into BLE buffer.
+ * Each hour uses 10 bytes: hour, stress stats, HR/HRV, GSR, activity.
+ * Called by updateHistoryValues() when history changes.
+ * 
+ * @param buffer Output buffer (must be 240 bytes)
+ */
+void packTodayData(uint8_t* buffer) {
+  for (int i = 0; i < HOURS_PER_DAY; i++) {
+    packHourSummary(i, buffer + i * 10);
+  }
+}
+
+/**
+ * Pack a single hourly summary into the 10-byte Today record layout.
+ * 
+ * @param hour Hour index (0-23)
+ * @param buffer Output buffer (must be 10 bytes)
+ */
+void packHourSummary(int hour, uint8_t* buffer) {
+  buffer[0] = todayData[hour].hour;
+  buffer[1] = todayData[hour].avgStress;
+  buffer[2] = todayData[hour].peakStress;
+  buffer[3] = todayData[hour].highStressMins;
+  buffer[4] = todayData[hour].avgHR;
+  buffer[5] = (uint8_t)(todayData[hour].avgHRV & 0xFF);
+  buffer[6] = (uint8_t)((todayData[hour].avgHRV >> 8) & 0xFF);
+  buffer[7] = (uint8_t)(todayData[hour].avgGSR & 0xFF);
+  buffer[8] = (uint8_t)((todayData[hour].avgGSR >> 8) & 0xFF);
+  buffer[9] = ((todayData[hour].sampleCount > 0) ? 0x01 : 0x00) |
+              ((todayData[hour].avgActivityLevel & 0x03) << 1);
+}
+
+/**
+ * Pack 7-day weekly summaries into BLE buffer.
+ * Aggregates hourly data from each day into daily averages and peaks.
+ * Each day uses 10 bytes. Called by updateHistoryValues() when history changes.
+ * 
+ * @param buffer Output buffer (must be 70 bytes)
+ */
+void packWeekData(uint8_t* buffer) {
+  for (int d = 0; d < DAYS_TO_STORE; d++) {
+    packDaySummary(d, buffer + d * 10);
+  }
+}
+
+/**
+ * Pack a single day's summary into the 10-byte Week record layout.
+ * Reads that day's hourly records from flash and aggregates them.
+ * 
+ * @param day Storage slot index (0-6)
+ * @param buffer Output buffer (must be 10 bytes)
+ */
+void packDaySummary(int day, uint8_t* buffer) {
+  String key = "day" + String(day);
+  HourlySummary dayData[HOURS_PER_DAY];
+  size_t len = preferences.getBytesLength(key.c_str());
+  
+  uint32_t stressSum = 0, hrSum = 0, hrvSum = 0;
+  uint8_t peakStress = 0, peakHour = 0, highMins = 0;
+  int validHours = 0;
+  
+  if (len == sizeof(dayData)) {
+    preferences.getBytes(key.c_str(), dayData, sizeof(dayData));
+    
+    // Aggregate all valid hours into daily statistics
+    for (int h = 0; h < HOURS_PER_DAY; h++) {
+      if (dayData[h].sampleCount > 0) {
+        stressSum += dayData[h].avgStress;
+        hrSum += dayData[h].avgHR;
+        hrvSum += dayData[h].avgHRV;
+        highMins += dayData[h].highStressMins;
+        validHours++;
+        
+        if (dayData[h].peakStress > peakStress) {
+          peakStress = dayData[h].peakStress;
+          peakHour = h;
+        }
+      }
+    }
+  }
+  
+  buffer[0] = day;
+  buffer[1] = validHours > 0 ? (stressSum / validHours) : 0;
+  buffer[2] = peakStress;
+  buffer[3] = peakHour;
+  buffer[4] = highMins;
+  buffer[5] = validHours > 0 ? (hrSum / validHours) : 0;
+  buffer[6] = validHours > 0 ? ((hrvSum / validHours) & 0xFF) : 0;
+  buffer[7] = validHours > 0 ? (((hrvSum / validHours) >> 8) & 0xFF) : 0;
+  buffer[8] = 0;
+  buffer[9] = validHours > 0 ? 0x01 : 0x00;
+}
+
+/**
+ * Send a client's next delta sync packet (records changed since its deltaSyncFromSeq).
+ * Walks today's 24 hour slots then the 7 day slots, packing every record
+ * with a newer sequence number until the packet reaches the MTU. When no
+ * changed records remain, sends the end packet and finishes the sync.
+ * 
+ * Records packet:
+ *   [0] type (0xD1)
+ *   [1] record count
+ *   Per record (15 bytes):
+ *     [0] kind (0x00 = hour of today, 0x01 = day of week)
+ *     [1-4] sequence number (32-bit little-endian)
+ *     [5-14] 10-byte record (same layout as Today/Week characteristics)
+ * 
+ * TLV records packet (encoding 0x01 requested and MTU large enough):
+ *   [0] type (0xD3)
+ *   [1] record count
+ *   Per record:
+ *     [0] kind, [1-4] sequence number (as above)
+ *     [5] TLV length
+ *     [6..] history TLV fields selected by the client's history field mask
+ * 
+ * LZ records packet (compression 0x01 requested and MTU holds several records):
+ *   [0] type (0xD4)
+ *   [1] record count
+ *   [2] type of the packet the records belong to (0xD1 or 0xD3)
+ *   [3..] LZ stream that expands to that packet's records (see lzEncode)
+ * 
+ * End packet:
+ *   [0] type (0xD2)
+ *   [1] current day slot (0-6)
+ *   [2-5] latest sequence number (32-bit little-endian)
+ * 
+ * @param client Client slot
+ */
+void sendDeltaSyncPacket(uint8_t client) {
+  BleClient &c = bleClients[client];
+  uint16_t payloadSize = min((int)c.mtu, BLE_PREFERRED_MTU) - 3;
+  uint16_t length = 0;
+  uint8_t count = 0;
+  
+  // TLV records are larger, so they are only used once the MTU can hold one
+  bool useTlv = (c.deltaSyncEncoding == HISTORY_ENCODING_TLV) &&
+                (payloadSize >= DELTA_HEADER_SIZE + 6 + DELTA_TLV_MAX_RECORD);
+  
+  // Compression only once the MTU can hold several records that don't
+  // compress at all: with room for one, matches only reach into that record
+  // and the extra header eats the gain
+  uint16_t maxRecordSize = useTlv ? 6 + DELTA_TLV_MAX_RECORD : DELTA_RECORD_SIZE;
+  bool compress = (c.deltaSyncCompression == HISTORY_COMPRESS_LZ) &&
+                  (payloadSize >= DELTA_LZ_HEADER_SIZE + 1 + DELTA_LZ_MIN_RECORDS * maxRecordSize);
+  
+  // Records are staged raw for the compressor, or packed straight into the packet
+  uint8_t* records = compress ? lzRawBuffer : bleSyncBuffer + DELTA_HEADER_SIZE;
+  uint16_t capacity = compress ? LZ_RAW_BUFFER_SIZE : payloadSize - DELTA_HEADER_SIZE;
+  LzEncoder lz = {bleSyncBuffer + DELTA_LZ_HEADER_SIZE, 0,
+                  (uint16_t)(payloadSize - DELTA_LZ_HEADER_SIZE), lzRawBuffer, 0, 0, 0};
+  
+  while (c.deltaSyncCursor < HOURS_PER_DAY + DAYS_TO_STORE) {
+    int slot = c.deltaSyncCursor;
+    bool isHour = slot < HOURS_PER_DAY;
+    uint32_t seq = isHour ? todaySeq[slot] : daySeq[slot - HOURS_PER_DAY];
+    
+    if (seq <= c.deltaSyncFromSeq) {
+      c.deltaSyncCursor++;
+      continue;
+    }
+    
+    uint8_t* record = records + length;
+    uint16_t recordSize;
+    
+    if (useTlv) {
+      uint8_t tlv[DELTA_TLV_MAX_RECORD];
+      uint8_t tlvLength = isHour ? packHourTlv(slot, c.historyFieldMask, tlv) :
+                                   packDayTlv(slot - HOURS_PER_DAY, c.historyFieldMask, tlv);
+      recordSize = 6 + tlvLength;
+      if (length + recordSize > capacity) break;
+      record[5] = tlvLength;
+      memcpy(record + 6, tlv, tlvLength);
+    } else {
+      recordSize = DELTA_RECORD_SIZE;
+      if (length + recordSize > capacity) break;
+      if (isHour) {
+        packHourSummary(slot, record + 5);
+      } else {
+        packDaySummary(slot - HOURS_PER_DAY, record + 5);
+      }
+    }
+    
+    record[0] = isHour ? DELTA_KIND_HOUR : DELTA_KIND_DAY;
+    record[1] = (uint8_t)(seq & 0xFF);
+    record[2] = (uint8_t)((seq >> 8) & 0xFF);
+    record[3] = (uint8_t)((seq >> 16) & 0xFF);
+    record[4] = (uint8_t)((seq >> 24) & 0xFF);
+    
+    // Leave the record for the next packet if its compressed form doesn't fit
+    if (compress) {
+      LzEncoder saved = lz;
+      if (!lzEncode(lz, length + recordSize)) {
+        lzRollback(lz, saved);
+        break;
+      }
+    }
+    
+    length += recordSize;
+    count++;
+    c.deltaSyncCursor++;
+  }
+  
+  if (count > 0) {
+    uint8_t type = useTlv ? DELTA_PACKET_TLV_RECORDS : DELTA_PACKET_RECORDS;
+    if (compress) {
+      bleSyncBuffer[0] = DELTA_PACKET_LZ_RECORDS;
+      bleSyncBuffer[1] = count;
+      bleSyncBuffer[2] = type;
+      queueNotify(client, BLE_CHANNEL_SYNC, bleSyncBuffer, DELTA_LZ_HEADER_SIZE + lz.outLength, false);
+    } else {
+      bleSyncBuffer[0] = type;
+      bleSyncBuffer[1] = count;
+      queueNotify(client, BLE_CHANNEL_SYNC, bleSyncBuffer, DELTA_HEADER_SIZE + length, false);
+    }
+    return;
+  }
+  
+  // All changed records sent - report latest sequence for the app's next sync
+  bleSyncBuffer[0] = DELTA_PACKET_END;
+  bleSyncBuffer[1] = currentDay;
+  bleSyncBuffer[2] = (uint8_t)(historySeq & 0xFF);
+  bleSyncBuffer[3] = (uint8_t)((historySeq >> 8) & 0xFF);
+  bleSyncBuffer[4] = (uint8_t)((historySeq >> 16) & 0xFF);
+  bleSyncBuffer[5] = (uint8_t)((historySeq >> 24) & 0xFF);
+  queueNotify(client, BLE_CHANNEL_SYNC, bleSyncBuffer, 6, false);
+  c.deltaSyncCursor = -1;
+}
+
+/**
+ * Compress raw bytes [encoder.rawLength, rawEnd) onto the encoder output.
+ * Byte-aligned LZ77 with a 256-byte window, so it needs no RAM beyond the
+ * raw input and the decoder is a few lines on the app side. Matches may
+ * reference any earlier raw byte and may overlap the bytes they produce
+ * (runs of zeros become one match).
+ * 
+ * Stream format, repeated:
+ *   [0xxxxxxx] literal run: x + 1 raw bytes follow
+ *   [1xxxxxxx][offset - 1] match: copy x + 3 bytes starting offset bytes back
+ * 
+ * @param encoder Encoder state, advanced on success
+ * @param rawEnd End of the raw bytes to encode
+ * @return false if the output is full (encoder is then partly advanced - roll back)
+ */
+bool lzEncode(LzEncoder& encoder, uint16_t rawEnd) {
+  const uint8_t* raw = encoder.raw;
+  uint16_t pos = encoder.rawLength;
+  
+  while (pos < rawEnd) {
+    // Longest match in the window (brute force: the window is small and syncs are rare)
+    uint16_t maxLength = min(rawEnd - pos, LZ_MAX_MATCH);
+    uint16_t windowStart = pos > LZ_WINDOW ? pos - LZ_WINDOW : 0;
+    uint16_t bestLength = 0;
+    uint16_t bestOffset = 0;
+    
+    for (uint16_t candidate = windowStart; candidate < pos; candidate++) {
+      uint16_t matchLength = 0;
+      while (matchLength < maxLength && raw[candidate + matchLength] == raw[pos + matchLength]) {
+        matchLength++;
+      }
+      if (matchLength >= bestLength) {
+        bestLength = matchLength;
+        bestOffset = pos - candidate;
+      }
+    }
+    
+    if (bestLength >= LZ_MIN_MATCH) {
+      if (encoder.outLength + 2 > encoder.outCapacity) return false;
+      encoder.out[encoder.outLength++] = 0x80 | (bestLength - LZ_MIN_MATCH);
+      encoder.out[encoder.outLength++] = bestOffset - 1;
+      encoder.literalCount = 0;
+      pos += bestLength;
+      continue;
+    }
+    
+    // Literal: extend the open run or start a new one
+    if (encoder.literalCount == 0 || encoder.literalCount == LZ_MAX_LITERALS) {
+      if (encoder.outLength + 2 > encoder.outCapacity) return false;
+      encoder.literalPos = encoder.outLength++;
+      encoder.literalCount = 0;
+    } else if (encoder.outLength + 1 > encoder.outCapacity) {
+      return false;
+    }
+    encoder.out[encoder.outLength++] = raw[pos++];
+    encoder.out[encoder.literalPos] = encoder.literalCount++;
+  }
+  
+  encoder.rawLength = rawEnd;
+  return true;
+}
+
+/**
+ * Undo a failed lzEncode() call.
+ * The open literal run's control byte may have been rewritten, so it is
+ * restored along with the encoder state.
+ * 
+ * @param encoder Encoder to restore
+ * @param saved Copy of the encoder taken before the call
+ */
+void lzRollback(LzEncoder& encoder, const LzEncoder& saved) {
+  encoder = saved;
+  if (encoder.literalCount > 0) {
+    encoder.out[encoder.literalPos] = encoder.literalCount - 1;
+  }
+}
+
+// ===========================================
+// BLE BACKEND: BLUEDROID
+// ===========================================
+// ESP32 Arduino BLE library. Callbacks run in the Bluetooth stack task and
+// only forward to the BLE event queue or the transport upcalls.
+#if BLE_BACKEND == BLE_BACKEND_BLUEDROID
+
+BLEServer* pServer = nullptr;
+BLECharacteristic* bleChars[BLE_CHANNEL_COUNT];
+BLE2902* bleCCCDs[BLE_CHANNEL_COUNT];  // Notify channels only
+
+// Client slots by GATT connection id (written from the stack task only)
+bool bleSlotUsed[BLE_MAX_CLIENTS];
+uint16_t bleConnIds[BLE_MAX_CLIENTS];
+esp_bd_addr_t bleSlotAddress[BLE_MAX_CLIENTS];
+
+/**
+ * @return Client slot of a connection id, or -1 if unknown
+ */
+int8_t bleSlotForConn(uint16_t connId) {
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (bleSlotUsed[i] && bleConnIds[i] == connId) return i;
+  }
+  return -1;
+}
+
+class ServerCallbacks : public BLEServerCallbacks {
+  void onConnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+      if (bleSlotUsed[i]) continue;
+      bleSlotUsed[i] = true;
+      bleConnIds[i] = param->connect.conn_id;
+      memcpy(bleSlotAddress[i], param->connect.remote_bda, sizeof(esp_bd_addr_t));
+      handleConnParamsUpdated(i, param->connect.conn_params.interval,
+                              param->connect.conn_params.latency, param->connect.conn_params.timeout);
+      pushBleEvent(i, BLE_EVENT_CONNECTED, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+      return;
+    }
+    // Stack allows more links than there are client slots
+    pServer->disconnect(param->connect.conn_id);
+  }
+  
+  void onDisconnect(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    int8_t slot = bleSlotForConn(param->disconnect.conn_id);
+    if (slot < 0) return;
+    handleConnParamsUpdated(slot, 0, 0, 0);  // Before the slot can be reused
+    bleSlotUsed[slot] = false;
+    pushBleEvent(slot, BLE_EVENT_DISCONNECTED, nullptr, 0);
+  }
+  
+  void onMtuChanged(BLEServer* pServer, esp_ble_gatts_cb_param_t* param) {
+    int8_t slot = bleSlotForConn(param->mtu.conn_id);
+    if (slot < 0) return;
+    uint8_t mtu[2] = {(uint8_t)(param->mtu.mtu & 0xFF), (uint8_t)(param->mtu.mtu >> 8)};
+    pushBleEvent(slot, BLE_EVENT_MTU, mtu, 2);
+  }
+};
+
+/**
+ * BLE callback for Command characteristic - queues app commands.
+ * Commands are executed by handleCommand() from loop(); see there for formats.
+ */
+class CommandCallbacks : public BLECharacteristicCallbacks {
+  void onWrite(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+    int8_t slot = bleSlotForConn(param->write.conn_id);
+    if (slot < 0) return;
+    pushBleEvent(slot, BLE_EVENT_COMMAND, pCharacteristic->getData(), pCharacteristic->getLength());
+  }
+};
+
+/**
+ * BLE callback for Today/Week/Stats characteristics - serves the buffer
+ * packed by handleBleRead(), or the value loop() stored if it packed none.
+ */
+class PackedReadCallback : public BLECharacteristicCallbacks {
+ public:
+  PackedReadCallback(uint8_t channel) : channel(channel) {}
+  
+  void onRead(BLECharacteristic* pCharacteristic, esp_ble_gatts_cb_param_t* param) {
+    int8_t slot = bleSlotForConn(param->read.conn_id);
+    if (slot < 0) return;
+    const uint8_t* data;
+    size_t length = handleBleRead(slot, channel, &data);
+    if (length > 0) pCharacteristic->setValue((uint8_t*)data, length);
+  }
+  
+ private:
+  uint8_t channel;
+};
+
+/**
+ * GAP event hook - reports connection parameters chosen by the central.
+ */
+void gapEventHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+  if (event != ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT || param->update_conn_params.status != 0) return;
+  
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (bleSlotUsed[i] && memcmp(bleSlotAddress[i], param->update_conn_params.bda, sizeof(esp_bd_addr_t)) == 0) {
+      handleConnParamsUpdated(i, param->update_conn_params.conn_int,
+                              param->update_conn_params.latency,
+                              param->update_conn_params.timeout);
+    }
+  }
+}
+
+/**
+ * GATTS event hook - reports CCCD writes per connection (BLE2902 keeps a
+ * single value for all clients, so subscriptions are tracked from here),
+ * notification completions and stack congestion for the send queue.
+ */
+void gattsEventHandler(esp_gatts_cb_event_t event, esp_gatt_if_t gattsIf, esp_ble_gatts_cb_param_t* param) {
+  if (event == ESP_GATTS_CONF_EVT) {
+    int8_t slot = bleSlotForConn(param->conf.conn_id);
+    if (slot >= 0) handleNotifyComplete(slot);
+    return;
+  }
+  if (event == ESP_GATTS_CONGEST_EVT) {
+    int8_t slot = bleSlotForConn(param->congest.conn_id);
+    if (slot >= 0) handleCongestion(slot, param->congest.congested);
+    return;
+  }
+  if (event != ESP_GATTS_WRITE_EVT || param->write.len < 2) return;
+  
+  int8_t slot = bleSlotForConn(param->write.conn_id);
+  if (slot < 0) return;
+  
+  for (uint8_t channel = 0; channel < BLE_CHANNEL_COUNT; channel++) {
+    if (bleCCCDs[channel] != nullptr && bleCCCDs[channel]->getHandle() == param->write.handle) {
+      uint8_t value[2] = {channel, (uint8_t)(param->write.value[0] & 0x01)};
+      pushBleEvent(slot, BLE_EVENT_SUBSCRIBE, value, 2);
+    }
+  }
+}
+
+/**
+ * Create the StressView GATT service. Advertising is started separately.
+ */
+void bleTransportInit() {
+  BLEDevice::init("StressView");
+  BLEDevice::setMTU(BLE_PREFERRED_MTU);  // Larger MTU lets batched mode pack more samples
+  BLEDevice::setCustomGapHandler(gapEventHandler);  // Reports negotiated connection parameters
+  BLEDevice::setCustomGattsHandler(gattsEventHandler);  // Reports per-client subscriptions
+  
+  pServer = BLEDevice::createServer();
+  pServer->setCallbacks(new ServerCallbacks());
+  
+  BLEService* pService = pServer->createService(SERVICE_UUID);
+  
+  bleChars[BLE_CHANNEL_LIVE] = pService->createCharacteristic(
+    CHAR_LIVE_UUID,
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+  bleCCCDs[BLE_CHANNEL_LIVE] = new BLE2902();
+  bleChars[BLE_CHANNEL_LIVE]->addDescriptor(bleCCCDs[BLE_CHANNEL_LIVE]);
+  
+  bleChars[BLE_CHANNEL_TODAY] = pService->createCharacteristic(
+    CHAR_TODAY_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  bleChars[BLE_CHANNEL_TODAY]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_TODAY));
+  
+  bleChars[BLE_CHANNEL_WEEK] = pService->createCharacteristic(
+    CHAR_WEEK_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  bleChars[BLE_CHANNEL_WEEK]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_WEEK));
+  
+  bleChars[BLE_CHANNEL_COMMAND] = pService->createCharacteristic(
+    CHAR_COMMAND_UUID,
+    BLECharacteristic::PROPERTY_WRITE
+  );
+  bleChars[BLE_CHANNEL_COMMAND]->setCallbacks(new CommandCallbacks());
+  
+  // Waveform characteristic - notify only, streams while any CCCD is enabled
+  bleChars[BLE_CHANNEL_WAVE] = pService->createCharacteristic(
+    CHAR_WAVE_UUID,
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+  bleCCCDs[BLE_CHANNEL_WAVE] = new BLE2902();
+  bleChars[BLE_CHANNEL_WAVE]->addDescriptor(bleCCCDs[BLE_CHANNEL_WAVE]);
+  
+  // Sync characteristic - notify only, carries delta sync and offline drain
+  bleChars[BLE_CHANNEL_SYNC] = pService->createCharacteristic(
+    CHAR_SYNC_UUID,
+    BLECharacteristic::PROPERTY_NOTIFY
+  );
+  bleCCCDs[BLE_CHANNEL_SYNC] = new BLE2902();
+  bleChars[BLE_CHANNEL_SYNC]->addDescriptor(bleCCCDs[BLE_CHANNEL_SYNC]);
+  
+  bleChars[BLE_CHANNEL_CAPS] = pService->createCharacteristic(
+    CHAR_CAPS_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  
+  bleChars[BLE_CHANNEL_TUNE] = pService->createCharacteristic(
+    CHAR_TUNE_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  
+  bleChars[BLE_CHANNEL_STATS] = pService->createCharacteristic(
+    CHAR_STATS_UUID,
+    BLECharacteristic::PROPERTY_READ
+  );
+  bleChars[BLE_CHANNEL_STATS]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_STATS));
+  
+  pService->start();
+  
+  BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+  pAdvertising->addServiceUUID(SERVICE_UUID);
+  pAdvertising->setScanResponse(true);
+  pAdvertising->setMinPreferred(0x06);
+  pAdvertising->setMaxPreferred(0x12);
+}
+
+/**
+ * Send a notification to one client. BLECharacteristic::notify() would go
+ * to every connected peer, so the packet is handed to the stack directly.
+ * 
+ * @return true if the stack accepted it (false if congested or not connected)
+ */
+bool bleNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length) {
+  if (!bleSlotUsed[client]) return false;
+  
+  unsigned long start = micros();
+  esp_err_t result = esp_ble_gatts_send_indicate(pServer->getGattsIf(), bleConnIds[client],
+                                                 bleChars[channel]->getHandle(), length,
+                                                 (uint8_t*)data, false);
+  recordNotifyTime(start);
+  return result == ESP_OK;
+}
+
+/**
+ * Set the value returned by reads of a characteristic.
+ */
+void bleSetValue(uint8_t channel, const uint8_t* data, size_t length) {
+  bleChars[channel]->setValue((uint8_t*)data, length);
+}
+
+void bleStartAdvertising() {
+  BLEDevice::startAdvertising();
+}
+
+void bleStopAdvertising() {
+  BLEDevice::stopAdvertising();
+}
+
+/**
+ * Switch to explicit advertising data: flags, 16-bit service UUID and the
+ * broadcast manufacturer data (if any), with the name in the scan response.
+ * Takes effect immediately if advertising.
+ */
+void bleSetBroadcastData(const uint8_t* data, size_t length) {
+  BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+  
+  BLEAdvertisementData advData;
+  advData.setFlags(0x06);  // General discoverable, BR/EDR not supported
+  advData.setCompleteServices(BLEUUID((uint16_t)SERVICE_UUID16));
+  if (length > 0) {
+    advData.setManufacturerData(String((const char*)data, length));
+  }
+  pAdvertising->setAdvertisementData(advData);
+  
+  BLEAdvertisementData scanData;
+  scanData.setName("StressView");
+  pAdvertising->setScanResponseData(scanData);
+}
+
+void bleDisconnect(uint8_t client) {
+  if (bleSlotUsed[client]) {
+    pServer->disconnect(bleConnIds[client]);
+  }
+}
+
+void bleUpdateConnParams(uint8_t client, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+  pServer->updateConnParams(bleSlotAddress[client], minInterval, maxInterval, latency, timeout);
 }
 
+#endif  // BLE_BACKEND_BLUEDROID
+
 // ===========================================
-// BLE INITIALIZATION
+// BLE BACKEND: NIMBLE
 // ===========================================
+// NimBLE-Arduino (1.4.x API). Same GATT layout and behaviour as the Bluedroid
+// backend with a much smaller host stack; CCCDs are created automatically.
+// Build with -DBLE_BACKEND=3 and the NimBLE-Arduino library installed.
+#if BLE_BACKEND == BLE_BACKEND_NIMBLE
+
+NimBLEServer* pServer = nullptr;
+NimBLECharacteristic* bleChars[BLE_CHANNEL_COUNT];
+
+// Client slots by connection handle (written from the host task only)
+bool bleSlotUsed[BLE_MAX_CLIENTS];
+uint16_t bleConnHandles[BLE_MAX_CLIENTS];
 
 /**
- * Initialize Bluetooth Low Energy service and characteristics.
- * Sets up four characteristics:
- * - Live: Real-time sensor data notifications (7 bytes)
- * - Today: 24-hour hourly summaries (240 bytes, on-demand read)
- * - Week: 7-day daily summaries (70 bytes, on-demand read)
- * - Command: App control commands (write-only)
- * 
- * Pre-populates read buffers to prevent connection errors on first read.
+ * @return Client slot of a connection handle, or -1 if unknown
  */
-void initBLE() {
-  BLEDevice::init("StressView");
-  
-  pServer = BLEDevice::createServer();
-  pServer->setCallbacks(new ServerCallbacks());
+int8_t bleSlotForConn(uint16_t connHandle) {
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (bleSlotUsed[i] && bleConnHandles[i] == connHandle) return i;
+  }
+  return -1;
+}
+
+class ServerCallbacks : public NimBLEServerCallbacks {
+  void onConnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+      if (bleSlotUsed[i]) continue;
+      bleSlotUsed[i] = true;
+      bleConnHandles[i] = desc->conn_handle;
+      handleConnParamsUpdated(i, desc->conn_itvl, desc->conn_latency, desc->supervision_timeout);
+      pushBleEvent(i, BLE_EVENT_CONNECTED, desc->peer_ota_addr.val, sizeof(desc->peer_ota_addr.val));
+      return;
+    }
+    // Stack allows more links than there are client slots
+    pServer->disconnect(desc->conn_handle);
+  }
   
-  BLEService* pService = pServer->createService(SERVICE_UUID);
+  void onDisconnect(NimBLEServer* pServer, ble_gap_conn_desc* desc) {
+    int8_t slot = bleSlotForConn(desc->conn_handle);
+    if (slot < 0) return;
+    handleConnParamsUpdated(slot, 0, 0, 0);  // Before the slot can be reused
+    bleSlotUsed[slot] = false;
+    pushBleEvent(slot, BLE_EVENT_DISCONNECTED, nullptr, 0);
+  }
   
-  pLiveChar = pService->createCharacteristic(
-    CHAR_LIVE_UUID,
-    BLECharacteristic::PROPERTY_NOTIFY
-  );
-  pLiveChar->addDescriptor(new BLE2902());
+  void onMTUChange(uint16_t mtu, ble_gap_conn_desc* desc) {
+    int8_t slot = bleSlotForConn(desc->conn_handle);
+    if (slot < 0) return;
+    uint8_t value[2] = {(uint8_t)(mtu & 0xFF), (uint8_t)(mtu >> 8)};
+    pushBleEvent(slot, BLE_EVENT_MTU, value, 2);
+  }
+};
+
+/**
+ * BLE callback for Command characteristic - queues app commands.
+ */
+class CommandCallbacks : public NimBLECharacteristicCallbacks {
+  void onWrite(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {
+    int8_t slot = bleSlotForConn(desc->conn_handle);
+    if (slot < 0) return;
+    NimBLEAttValue value = pCharacteristic->getValue();
+    pushBleEvent(slot, BLE_EVENT_COMMAND, value.data(), value.length());
+  }
+};
+
+/**
+ * BLE callback for notify characteristics - forwards each client's
+ * subscription changes.
+ */
+class SubscribeCallbacks : public NimBLECharacteristicCallbacks {
+  void onSubscribe(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc, uint16_t subValue) {
+    int8_t slot = bleSlotForConn(desc->conn_handle);
+    if (slot < 0) return;
+    for (uint8_t channel = 0; channel < BLE_CHANNEL_COUNT; channel++) {
+      if (bleChars[channel] == pCharacteristic) {
+        uint8_t value[2] = {channel, (uint8_t)(subValue & 0x0001)};
+        pushBleEvent(slot, BLE_EVENT_SUBSCRIBE, value, 2);
+      }
+    }
+  }
+};
+
+/**
+ * BLE callback for Today/Week/Stats characteristics - serves the buffer
+ * packed by handleBleRead(), or the value loop() stored if it packed none.
+ */
+class PackedReadCallback : public NimBLECharacteristicCallbacks {
+ public:
+  PackedReadCallback(uint8_t channel) : channel(channel) {}
   
-  pTodayChar = pService->createCharacteristic(
-    CHAR_TODAY_UUID,
-    BLECharacteristic::PROPERTY_READ
-  );
-  pTodayChar->setCallbacks(new TodayReadCallback());
+  void onRead(NimBLECharacteristic* pCharacteristic, ble_gap_conn_desc* desc) {
+    int8_t slot = bleSlotForConn(desc->conn_handle);
+    if (slot < 0) return;
+    const uint8_t* data;
+    size_t length = handleBleRead(slot, channel, &data);
+    if (length > 0) pCharacteristic->setValue(data, length);
+  }
   
-  // Initialize buffer with invalid flags to prevent errors on first read
-  memset(bleTodayBuffer, 0, 240);
-  for (int i = 0; i < HOURS_PER_DAY; i++) {
-    bleTodayBuffer[i * 10] = i;
-    bleTodayBuffer[i * 10 + 9] = 0x00;
+ private:
+  uint8_t channel;
+};
+
+/**
+ * GAP event hook - reports connection parameters after an update and
+ * notification completions for the send queue.
+ */
+int gapEventHandler(ble_gap_event* event, void* arg) {
+  if (event->type == BLE_GAP_EVENT_CONN_UPDATE && event->conn_update.status == 0) {
+    int8_t slot = bleSlotForConn(event->conn_update.conn_handle);
+    ble_gap_conn_desc desc;
+    if (slot >= 0 && ble_gap_conn_find(event->conn_update.conn_handle, &desc) == 0) {
+      handleConnParamsUpdated(slot, desc.conn_itvl, desc.conn_latency, desc.supervision_timeout);
+    }
+  } else if (event->type == BLE_GAP_EVENT_NOTIFY_TX && !event->notify_tx.indication) {
+    int8_t slot = bleSlotForConn(event->notify_tx.conn_handle);
+    if (slot >= 0) handleNotifyComplete(slot);
   }
-  pTodayChar->setValue(bleTodayBuffer, 240);
+  return 0;
+}
+
+/**
+ * Create the StressView GATT service. Advertising is started separately.
+ */
+void bleTransportInit() {
+  NimBLEDevice::init("StressView");
+  NimBLEDevice::setMTU(BLE_PREFERRED_MTU);
+  NimBLEDevice::setCustomGapHandler(gapEventHandler);
   
-  pWeekChar = pService->createCharacteristic(
-    CHAR_WEEK_UUID,
-    BLECharacteristic::PROPERTY_READ
-  );
-  pWeekChar->setCallbacks(new WeekReadCallback());
+  pServer = NimBLEDevice::createServer();
+  pServer->setCallbacks(new ServerCallbacks());
+  pServer->advertiseOnDisconnect(false);  // loop() restarts advertising
   
-  memset(bleWeekBuffer, 0, 70);
-  for (int d = 0; d < DAYS_TO_STORE; d++) {
-    bleWeekBuffer[d * 10] = d;
-    bleWeekBuffer[d * 10 + 9] = 0x00;
-  }
-  pWeekChar->setValue(bleWeekBuffer, 70);
+  NimBLEService* pService = pServer->createService(SERVICE_UUID);
+  SubscribeCallbacks* subscribeCallbacks = new SubscribeCallbacks();
   
-  pCommandChar = pService->createCharacteristic(
-    CHAR_COMMAND_UUID,
-    BLECharacteristic::PROPERTY_WRITE
-  );
-  pCommandChar->setCallbacks(new CommandCallbacks());
+  bleChars[BLE_CHANNEL_LIVE] = pService->createCharacteristic(CHAR_LIVE_UUID, NIMBLE_PROPERTY::NOTIFY);
+  bleChars[BLE_CHANNEL_TODAY] = pService->createCharacteristic(CHAR_TODAY_UUID, NIMBLE_PROPERTY::READ);
+  bleChars[BLE_CHANNEL_WEEK] = pService->createCharacteristic(CHAR_WEEK_UUID, NIMBLE_PROPERTY::READ);
+  bleChars[BLE_CHANNEL_COMMAND] = pService->createCharacteristic(CHAR_COMMAND_UUID, NIMBLE_PROPERTY::WRITE);
+  bleChars[BLE_CHANNEL_WAVE] = pService->createCharacteristic(CHAR_WAVE_UUID, NIMBLE_PROPERTY::NOTIFY);
+  bleChars[BLE_CHANNEL_SYNC] = pService->createCharacteristic(CHAR_SYNC_UUID, NIMBLE_PROPERTY::NOTIFY);
+  bleChars[BLE_CHANNEL_CAPS] = pService->createCharacteristic(CHAR_CAPS_UUID, NIMBLE_PROPERTY::READ);
+  bleChars[BLE_CHANNEL_TUNE] = pService->createCharacteristic(CHAR_TUNE_UUID, NIMBLE_PROPERTY::READ);
+  bleChars[BLE_CHANNEL_STATS] = pService->createCharacteristic(CHAR_STATS_UUID, NIMBLE_PROPERTY::READ);
+  
+  bleChars[BLE_CHANNEL_LIVE]->setCallbacks(subscribeCallbacks);
+  bleChars[BLE_CHANNEL_WAVE]->setCallbacks(subscribeCallbacks);
+  bleChars[BLE_CHANNEL_SYNC]->setCallbacks(subscribeCallbacks);
+  bleChars[BLE_CHANNEL_TODAY]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_TODAY));
+  bleChars[BLE_CHANNEL_WEEK]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_WEEK));
+  bleChars[BLE_CHANNEL_STATS]->setCallbacks(new PackedReadCallback(BLE_CHANNEL_STATS));
+  bleChars[BLE_CHANNEL_COMMAND]->setCallbacks(new CommandCallbacks());
   
   pService->start();
   
-  BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+  NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
   pAdvertising->addServiceUUID(SERVICE_UUID);
   pAdvertising->setScanResponse(true);
   pAdvertising->setMinPreferred(0x06);
   pAdvertising->setMaxPreferred(0x12);
-  BLEDevice::startAdvertising();
 }
 
 /**
- * Send live sensor data via BLE notification.
- * Packs current sensor readings into 7-byte packet format.
- * Called at 1Hz when device is connected. Format matches parser.js.
- * 
- * Packet format:
- *   [0] stress index (0-100)
- *   [1] heart rate BPM (0-255)
- *   [2-3] HRV in ms (16-bit little-endian)
- *   [4-5] GSR raw value (16-bit little-endian)
- *   [6] status byte (bit flags for sensor states)
+ * Send a notification to one client through the host API, since
+ * NimBLECharacteristic::notify() goes to every subscribed peer.
  */
-void updateBLEData() {
-  if (!deviceConnected) return;
-  
-  uint8_t buffer[7];
-  buffer[0] = (uint8_t)constrain(stressIndex, 0, 100);
-  buffer[1] = currentHR;
-  buffer[2] = (uint8_t)((uint16_t)currentHRV & 0xFF);
-  buffer[3] = (uint8_t)(((uint16_t)currentHRV >> 8) & 0xFF);
-  buffer[4] = (uint8_t)((uint16_t)currentGSR & 0xFF);
-  buffer[5] = (uint8_t)(((uint16_t)currentGSR >> 8) & 0xFF);
-  buffer[6] = (hrSensorActive ? 0x01 : 0x00) |
-              (calibrationComplete ? 0x02 : 0x00) |
-              (motionDetected ? 0x04 : 0x00) |
-              ((currentActivity & 0x03) << 3) |
-              (mpuReady ? 0x80 : 0x00);
+bool bleNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length) {
+  if (!bleSlotUsed[client]) return false;
   
-  pLiveChar->setValue(buffer, 7);
-  pLiveChar->notify();
+  unsigned long start = micros();
+  os_mbuf* packet = ble_hs_mbuf_from_flat(data, length);
+  // The host takes ownership of the buffer, also on failure
+  int result = packet ? ble_gattc_notify_custom(bleConnHandles[client], bleChars[channel]->getHandle(), packet)
+                      : BLE_HS_ENOMEM;
+  recordNotifyTime(start);
+  return result == 0;
 }
 
-/**
- * Pack today's 24 hourly summaries into BLE buffer.
- * Each hour uses 10 bytes: hour, stress stats, HR/HRV, GSR, activity.
- * Called on-demand when app reads the Today characteristic.
- * 
- * @param buffer Output buffer (must be 240 bytes)
- */
-void packTodayData(uint8_t* buffer) {
-  for (int i = 0; i < HOURS_PER_DAY; i++) {
-    int offset = i * 10;
-    buffer[offset + 0] = todayData[i].hour;
-    buffer[offset + 1] = todayData[i].avgStress;
-    buffer[offset + 2] = todayData[i].peakStress;
-    buffer[offset + 3] = todayData[i].highStressMins;
-    buffer[offset + 4] = todayData[i].avgHR;
-    buffer[offset + 5] = (uint8_t)(todayData[i].avgHRV & 0xFF);
-    buffer[offset + 6] = (uint8_t)((todayData[i].avgHRV >> 8) & 0xFF);
-    buffer[offset + 7] = (uint8_t)(todayData[i].avgGSR & 0xFF);
-    buffer[offset + 8] = (uint8_t)((todayData[i].avgGSR >> 8) & 0xFF);
-    buffer[offset + 9] = ((todayData[i].sampleCount > 0) ? 0x01 : 0x00) |
-                         ((todayData[i].avgActivityLevel & 0x03) << 1);
+void bleSetValue(uint8_t channel, const uint8_t* data, size_t length) {
+  bleChars[channel]->setValue(data, length);
+}
+
+void bleStartAdvertising() {
+  NimBLEDevice::startAdvertising();
+}
+
+void bleStopAdvertising() {
+  NimBLEDevice::stopAdvertising();
+}
+
+void bleSetBroadcastData(const uint8_t* data, size_t length) {
+  NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
+  
+  NimBLEAdvertisementData advData;
+  advData.setFlags(0x06);  // General discoverable, BR/EDR not supported
+  advData.setCompleteServices16({NimBLEUUID((uint16_t)SERVICE_UUID16)});
+  if (length > 0) {
+    advData.setManufacturerData(std::string((const char*)data, length));
   }
+  pAdvertising->setAdvertisementData(advData);
+  
+  NimBLEAdvertisementData scanData;
+  scanData.setName("StressView");
+  pAdvertising->setScanResponseData(scanData);
 }
 
-/**
- * Pack 7-day weekly summaries into BLE buffer.
- * Aggregates hourly data from each day into daily averages and peaks.
- * Each day uses 10 bytes. Called on-demand when app reads Week characteristic.
- * 
- * @param buffer Output buffer (must be 70 bytes)
- */
-void packWeekData(uint8_t* buffer) {
-  for (int d = 0; d < DAYS_TO_STORE; d++) {
-    int offset = d * 10;
-    
-    String key = "day" + String(d);
-    HourlySummary dayData[HOURS_PER_DAY];
-    size_t len = preferences.getBytesLength(key.c_str());
-    
-    uint32_t stressSum = 0, hrSum = 0, hrvSum = 0;
-    uint8_t peakStress = 0, peakHour = 0, highMins = 0;
-    int validHours = 0;
-    
-    if (len == sizeof(dayData)) {
-      preferences.getBytes(key.c_str(), dayData, sizeof(dayData));
-      
-      // Aggregate all valid hours into daily statistics
-      for (int h = 0; h < HOURS_PER_DAY; h++) {
-        if (dayData[h].sampleCount > 0) {
-          stressSum += dayData[h].avgStress;
-          hrSum += dayData[h].avgHR;
-          hrvSum += dayData[h].avgHRV;
-          highMins += dayData[h].highStressMins;
-          validHours++;
-          
-          if (dayData[h].peakStress > peakStress) {
-            peakStress = dayData[h].peakStress;
-            peakHour = h;
-          }
-        }
-      }
-    }
-    
-    buffer[offset + 0] = d;
-    buffer[offset + 1] = validHours > 0 ? (stressSum / validHours) : 0;
-    buffer[offset + 2] = peakStress;
-    buffer[offset + 3] = peakHour;
-    buffer[offset + 4] = highMins;
-    buffer[offset + 5] = validHours > 0 ? (hrSum / validHours) : 0;
-    buffer[offset + 6] = validHours > 0 ? ((hrvSum / validHours) & 0xFF) : 0;
-    buffer[offset + 7] = validHours > 0 ? (((hrvSum / validHours) >> 8) & 0xFF) : 0;
-    buffer[offset + 8] = 0;
-    buffer[offset + 9] = validHours > 0 ? 0x01 : 0x00;
+void bleDisconnect(uint8_t client) {
+  if (bleSlotUsed[client]) {
+    pServer->disconnect(bleConnHandles[client]);
   }
 }
 
+void bleUpdateConnParams(uint8_t client, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+  pServer->updateConnParams(bleConnHandles[client], minInterval, maxInterval, latency, timeout);
+}
+
+#endif  // BLE_BACKEND_NIMBLE
+
 // ===========================================
 // MOTION SENSING (MPU6050)
 // ===========================================
@@ -1527,12 +5734,14 @@ void packWeekData(uint8_t* buffer) {
  * Initializes motion buffer to 1g (resting gravitational acceleration).
  */
 void initMPU() {
-  mpu.setAddress(0x69);
+  mpuAddress = 0x69;
+  mpu.setAddress(mpuAddress);
   
   byte status = mpu.begin();
   
   if (status != 0) {
-    mpu.setAddress(0x68);
+    mpuAddress = 0x68;
+    mpu.setAddress(mpuAddress);
     status = mpu.begin();
   }
   
@@ -1544,7 +5753,7 @@ void initMPU() {
   display.clearDisplay();
   display.setCursor(20, 25);
   display.print("Calibrating IMU...");
-  display.display();
+  flushDisplay();
   
   mpu.calcOffsets();
   
@@ -1564,7 +5773,7 @@ void initMPU() {
 void updateMotion() {
   unsigned long currentMillis = millis();
   
-  if (currentMillis - lastMotionUpdate < 20) return;
+  if (currentMillis - lastMotionUpdate < tunables.motionIntervalMs) return;
   lastMotionUpdate = currentMillis;
   
   mpu.update();
@@ -1575,22 +5784,36 @@ void updateMotion() {
   float az = mpu.getAccZ();
   float accelMag = sqrt(ax*ax + ay*ay + az*az);
   
+  // Wrist raise: face up for WRIST_RAISE_HOLD_MS after having pointed away
+  static unsigned long faceUpSince = 0;
+  static bool raiseArmed = false;
+  bool faceUp = az > WRIST_FACE_UP_G && fabs(ax) < WRIST_TILT_G && fabs(ay) < WRIST_TILT_G;
+  if (!faceUp) {
+    faceUpSince = 0;
+    raiseArmed = true;
+  } else if (faceUpSince == 0) {
+    faceUpSince = currentMillis;
+  } else if (raiseArmed && currentMillis - faceUpSince >= WRIST_RAISE_HOLD_MS) {
+    wristRaiseDetected = true;
+    raiseArmed = false;
+  }
+  
   motionBuffer[motionBufferIndex] = accelMag;
-  motionBufferIndex = (motionBufferIndex + 1) % MOTION_BUFFER_SIZE;
+  motionBufferIndex = (motionBufferIndex + 1) % tunables.motionWindow;
   
-  // Calculate variance over 1-second window (50 samples at 50Hz)
+  // Calculate variance over 1-second window (50 samples at 50Hz by default)
   // Variance = E[X²] - (E[X])²
   float sum = 0, sumSq = 0;
-  for (int i = 0; i < MOTION_BUFFER_SIZE; i++) {
+  for (int i = 0; i < tunables.motionWindow; i++) {
     sum += motionBuffer[i];
     sumSq += motionBuffer[i] * motionBuffer[i];
   }
-  float mean = sum / MOTION_BUFFER_SIZE;
-  motionVariance = (sumSq / MOTION_BUFFER_SIZE) - (mean * mean);
+  float mean = sum / tunables.motionWindow;
+  motionVariance = (sumSq / tunables.motionWindow) - (mean * mean);
   
   // Binary motion flag (used to indicate HR reading reliability)
-  // Threshold 0.02 tuned for wrist-worn device placement
-  motionDetected = (motionVariance > 0.02);
+  // Default threshold 0.02 tuned for wrist-worn device placement
+  motionDetected = (motionVariance > tunables.motionThreshold);
 }
 
 /**
@@ -1600,11 +5823,11 @@ void updateMotion() {
  * Used to contextualize stress readings (exercise vs rest).
  */
 void updateActivityLevel() {
-  if (motionVariance < 0.005) {
+  if (motionVariance < tunables.activityLight) {
     currentActivity = STILL;
-  } else if (motionVariance < 0.03) {
+  } else if (motionVariance < tunables.activityActive) {
     currentActivity = LIGHT;
-  } else if (motionVariance < 0.15) {
+  } else if (motionVariance < tunables.activityExercise) {
     currentActivity = ACTIVE;
   } else {
     currentActivity = EXERCISE;
@@ -1616,42 +5839,222 @@ void updateActivityLevel() {
 // ===========================================
 
 /**
- * Get current time from BLE-synced timestamp + millis() offset.
- * Handles millis() rollover (occurs every ~49.7 days on ESP32).
- * Returns zeros if time has never been synced via BLE.
+ * Microseconds since boot from the 64-bit esp_timer (no rollover).
+ */
+uint64_t uptimeMicros() {
+  return (uint64_t)esp_timer_get_time();
+}
+
+/**
+ * UTC at an uptime from the last sync, corrected by learned drift. Before the
+ * first sync the clock simply counts from 1970-01-01 at boot.
  * 
- * @param hour Output hour (0-23)
- * @param minute Output minute (0-59)
- * @param second Output second (0-59)
+ * @param uptimeUs uptimeMicros() value
+ * @return Microseconds since 1970-01-01 UTC
  */
-void getCurrentTime(uint8_t &hour, uint8_t &minute, uint8_t &second) {
-  if (!syncedTime.isValid) {
-    hour = 0;
-    minute = 0;
-    second = 0;
-    return;
+uint64_t currentEpochMicros(uint64_t uptimeUs) {
+  if (!syncedTime.isValid) return uptimeUs;
+  
+  // Drift applied per millisecond keeps the product in range for years of uptime
+  int64_t elapsed = (int64_t)(uptimeUs - syncedTime.uptimeUsAtSync);
+  return syncedTime.epochUsAtSync + elapsed + (elapsed / 1000) * syncedTime.driftPpb / 1000000LL;
+}
+
+/**
+ * Refresh the cached local calendar fields once the current second has
+ * passed. Called every loop() pass; between boundaries this is a single
+ * compare. Set localTime.nextUpdateUs to 0 to force a refresh.
+ */
+void updateClock() {
+  uint64_t now = uptimeMicros();
+  if (now < localTime.nextUpdateUs) return;
+  
+  uint64_t utcUs = currentEpochMicros(now);
+  uint64_t utcSeconds = utcUs / 1000000ULL;
+  localTime.nextUpdateUs = now + (1000000ULL - utcUs % 1000000ULL);
+  
+  // Daylight saving changes on UTC hour boundaries
+  uint32_t utcHour = (uint32_t)(utcSeconds / 3600);
+  if (utcHour != localTime.utcHour) {
+    localTime.utcHour = utcHour;
+    localTime.utcOffsetMin = syncedTime.isValid ? zoneOffsetAt(utcSeconds) : 0;
   }
   
-  unsigned long currentMillis = millis();
-  unsigned long elapsedMillis;
+  uint64_t localSeconds = utcSeconds + localTime.utcOffsetMin * 60LL;
+  uint32_t dayNumber = (uint32_t)(localSeconds / 86400);
+  uint32_t secondOfDay = (uint32_t)(localSeconds % 86400);
+  
+  if (dayNumber != localTime.dayNumber) {
+    localTime.dayNumber = dayNumber;
+    localTime.weekday = (dayNumber + 4) % 7;  // 1970-01-01 was a Thursday
+    civilFromDays((int32_t)dayNumber, localTime.year, localTime.month, localTime.day);
+  }
+  
+  localTime.hour = secondOfDay / 3600;
+  localTime.minute = secondOfDay / 60 % 60;
+  localTime.second = secondOfDay % 60;
+}
+
+/**
+ * UTC offset of the configured zone at a moment, including daylight saving.
+ * 
+ * @param utcSeconds Seconds since 1970-01-01 UTC
+ * @return Offset in minutes
+ */
+int16_t zoneOffsetAt(uint64_t utcSeconds) {
+  int16_t offset = timeZone.standardOffsetMin;
+  if (timeZone.dstRule == DST_RULE_NONE || timeZone.dstOffsetMin == 0) return offset;
+  
+  uint16_t year;
+  uint8_t month, day;
+  civilFromDays((int32_t)(utcSeconds / 86400), year, month, day);
   
-  // Handle millis() rollover (unsigned subtraction handles it correctly)
-  if (currentMillis >= syncedTime.millisAtSync) {
-    elapsedMillis = currentMillis - syncedTime.millisAtSync;
+  int64_t start, end;
+  if (timeZone.dstRule == DST_RULE_EU) {
+    start = sundayOfMonth(year, 3, -1) * 86400LL + 3600;
+    end = sundayOfMonth(year, 10, -1) * 86400LL + 3600;
   } else {
-    elapsedMillis = (0xFFFFFFFF - syncedTime.millisAtSync) + currentMillis + 1;
+    // 02:00 local standard time to 02:00 local daylight time
+    start = sundayOfMonth(year, 3, 2) * 86400LL + 7200 - offset * 60LL;
+    end = sundayOfMonth(year, 11, 1) * 86400LL + 7200 - (offset + timeZone.dstOffsetMin) * 60LL;
+  }
+  
+  int64_t now = (int64_t)utcSeconds;
+  return (now >= start && now < end) ? offset + timeZone.dstOffsetMin : offset;
+}
+
+/**
+ * Days since 1970-01-01 for a proleptic Gregorian date.
+ */
+int32_t daysFromCivil(uint16_t year, uint8_t month, uint8_t day) {
+  int32_t y = (int32_t)year - (month <= 2);
+  int32_t era = y / 400;
+  uint32_t yearOfEra = (uint32_t)(y - era * 400);
+  uint32_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+  uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + (int32_t)dayOfEra - 719468;
+}
+
+/**
+ * Proleptic Gregorian date for a count of days since 1970-01-01.
+ */
+void civilFromDays(int32_t days, uint16_t &year, uint8_t &month, uint8_t &day) {
+  days += 719468;
+  int32_t era = days / 146097;
+  uint32_t dayOfEra = (uint32_t)(days - era * 146097);
+  uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  uint32_t mp = (5 * dayOfYear + 2) / 153;
+  day = (uint8_t)(dayOfYear - (153 * mp + 2) / 5 + 1);
+  month = (uint8_t)(mp < 10 ? mp + 3 : mp - 9);
+  year = (uint16_t)((int32_t)yearOfEra + era * 400 + (month <= 2));
+}
+
+/**
+ * Day number of the nth Sunday of a month (n = -1 for the last one).
+ */
+int32_t sundayOfMonth(uint16_t year, uint8_t month, int8_t n) {
+  if (n < 0) {
+    int32_t first = daysFromCivil(month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1, 1);
+    int32_t last = first - 1;
+    return last - (last + 4) % 7;
   }
+  int32_t first = daysFromCivil(year, month, 1);
+  return first + (7 - (first + 4) % 7) % 7 + (n - 1) * 7;
+}
+
+/**
+ * Load the time zone saved by command 0x0A.
+ */
+void loadTimeZone() {
+  timeZone.standardOffsetMin = (int16_t)preferences.getInt("tzOffset", 0);
+  timeZone.dstOffsetMin = preferences.getUChar("tzDst", 0);
+  timeZone.dstRule = preferences.getUChar("tzRule", DST_RULE_NONE);
+}
+
+/**
+ * Step the clock to a new reference and realign hour/day tracking so the
+ * step itself is not taken for an hour or day rollover.
+ * 
+ * @param uptimeUs uptimeMicros() the time belongs to
+ * @param epochUs UTC at that uptime
+ */
+void setSyncedTime(uint64_t uptimeUs, uint64_t epochUs) {
+  syncedTime.uptimeUsAtSync = uptimeUs;
+  syncedTime.epochUsAtSync = epochUs;
+  syncedTime.isValid = true;
   
-  unsigned long elapsedSeconds = elapsedMillis / 1000;
+  localTime.nextUpdateUs = 0;
+  localTime.utcHour = 0xFFFFFFFF;
+  updateClock();
+  currentHour = localTime.hour;
+  lastSyncedDay = localTime.dayNumber;
+}
+
+/**
+ * Apply the result of a precise time sync: learn drift against the previous
+ * measurement when they are far enough apart, then step the clock.
+ * 
+ * @param uptimeUs Uptime of the measurement (T4 of the best round)
+ * @param offsetUs UTC minus uptime at that moment
+ * @param roundTripMs Round trip of the best round
+ */
+void applyPreciseTime(uint64_t uptimeUs, int64_t offsetUs, uint16_t roundTripMs) {
+  uint64_t measured = uptimeUs + offsetUs;
   
-  unsigned long totalSeconds = syncedTime.second + elapsedSeconds;
-  second = totalSeconds % 60;
+  if (!syncedTime.driftBaseValid) {
+    syncedTime.driftBaseValid = true;
+    syncedTime.driftBaseUptime = uptimeUs;
+    syncedTime.driftBaseEpoch = measured;
+  } else {
+    int64_t span = (int64_t)(uptimeUs - syncedTime.driftBaseUptime);
+    if (span >= TIME_DRIFT_MIN_SPAN_MS * 1000LL) {
+      int64_t predicted = (int64_t)syncedTime.driftBaseEpoch + span +
+                          (span / 1000) * syncedTime.driftPpb / 1000000LL;
+      
+      // Round-trip jitter over the minimum span stays within a few ppm
+      int64_t residualPpb = ((int64_t)measured - predicted) * 1000LL / (span / 1000000LL);
+      int64_t drift = syncedTime.driftPpb + residualPpb;
+      drift = constrain(drift, (int64_t)-TIME_DRIFT_MAX_PPB, (int64_t)TIME_DRIFT_MAX_PPB);
+      syncedTime.driftPpb = (int32_t)drift;
+      preferences.putInt("driftPpb", syncedTime.driftPpb);
+      
+      syncedTime.driftBaseUptime = uptimeUs;
+      syncedTime.driftBaseEpoch = measured;
+    }
+  }
   
-  unsigned long totalMinutes = syncedTime.minute + (totalSeconds / 60);
-  minute = totalMinutes % 60;
+  syncedTime.roundTripMs = roundTripMs;
+  setSyncedTime(uptimeUs, measured);
   
-  unsigned long totalHours = syncedTime.hour + (totalMinutes / 60);
-  hour = totalHours % 24;
+  Serial.print("Round trip ");
+  Serial.print(roundTripMs);
+  Serial.print("ms, drift ");
+  Serial.print(syncedTime.driftPpb / 1000.0f, 1);
+  Serial.println("ppm");
+  logSyncedTime("Time synced (precise)");
+}
+
+/**
+ * Log the synced local date and time.
+ */
+void logSyncedTime(const char* label) {
+  Serial.print(label);
+  Serial.print(": ");
+  Serial.print(localTime.year);
+  Serial.print("-");
+  Serial.print(localTime.month);
+  Serial.print("-");
+  Serial.print(localTime.day);
+  Serial.print(" ");
+  Serial.print(localTime.hour);
+  Serial.print(":");
+  Serial.print(localTime.minute);
+  Serial.print(":");
+  Serial.print(localTime.second);
+  Serial.print(" UTC");
+  if (localTime.utcOffsetMin >= 0) Serial.print("+");
+  Serial.println(localTime.utcOffsetMin / 60.0f, 1);
 }
 
 // ===========================================
@@ -1659,8 +6062,9 @@ void getCurrentTime(uint8_t &hour, uint8_t &minute, uint8_t &second) {
 // ===========================================
 
 /**
- * Enter power-off mode - turns off all peripherals to save battery.
- * User can wake by holding button for 5 seconds again.
+ * Power off: save state, put the sensors and display into their lowest
+ * power modes, drop BLE and enter deep sleep. Does not return; the device
+ * boots again from setup() when the button is held for POWER_HOLD_MS.
  */
 void enterPowerOff() {
   // Visual feedback - show "POWERING OFF" message
@@ -1668,88 +6072,101 @@ void enterPowerOff() {
   display.setTextSize(1);
   display.setCursor(20, 25);
   display.print("POWERING OFF...");
-  display.display();
+  flushDisplay();
   delay(1000);
   
-  // Turn off MAX30102 (biggest power consumer)
+  // Save current hour data, and what flash doesn't hold to RTC memory
+  if (currentHour >= 0) {
+    saveHourlyData(currentHour);
+  }
+  powerOffState.clockValid = syncedTime.isValid;
+  powerOffState.epochUs = currentEpochMicros(uptimeMicros());
+  powerOffState.rtcUs = rtcMicros();
+  powerOffState.roundTripMs = syncedTime.roundTripMs;
+  powerOffState.currentHour = currentHour;
+  powerOffState.lastSyncedDay = lastSyncedDay;
+  powerOffState.hourAccum = hourAccum;
+  powerOffState.magic = POWER_OFF_MAGIC;
+  preferences.end();
+  
+  // MAX30102 shutdown mode (LEDs off, under 1uA)
   if (hrSensorActive) {
     particleSensor.shutDown();
   }
   
-  // Turn off display
+  // MPU6050 sleep mode; initMPU() clears it on the next boot
+  if (mpuReady) {
+    Wire.beginTransmission(mpuAddress);
+    Wire.write(MPU_REG_PWR_MGMT_1);
+    Wire.write(MPU_PWR_SLEEP);
+    Wire.endTransmission();
+  }
+  
+  // Turn off display (charge pump off, RAM kept)
   display.clearDisplay();
-  display.display();
-  display.ssd1306_command(SSD1306_DISPLAYOFF);
+  flushDisplay();
+  setDisplayPower(DISPLAY_BLANK);
   
   // Turn off vibration motor
   analogWrite(VIBRO_MOTOR_PIN, 0);
   
-  // Stop BLE advertising to save power
-  if (deviceConnected) {
-    pServer->disconnect(pServer->getConnId());
-  }
-  BLEDevice::stopAdvertising();
-  
-  // Save current hour data before shutting down
-  if (currentHour >= 0) {
-    saveHourlyData(currentHour);
+  // Drop all clients and stop BLE advertising
+  for (uint8_t i = 0; i < BLE_MAX_CLIENTS; i++) {
+    if (bleClients[i].connected) {
+      bleDisconnect(i);
+    }
   }
+  bleStopAdvertising();
+  advertisingActive = false;
   
-  devicePoweredOff = true;
-  
-  // Haptic feedback - 3 short pulses at 25% strength
+  // Haptic feedback - 3 short pulses at 25% strength (also lets the
+  // disconnects go out before the radio stops)
   for (int i = 0; i < 3; i++) {
     analogWrite(VIBRO_MOTOR_PIN, 64);  // 25% strength
     delay(100);
     analogWrite(VIBRO_MOTOR_PIN, 0);
     delay(100);
   }
+  
+  enterDeepSleep();
 }
 
 /**
- * Wake from power-off mode - restarts all peripherals.
+ * Enter deep sleep with the button as the only wake source. The wake is
+ * level-triggered, so a button still held from the power-off press would
+ * wake the chip at once; wait for the release first.
  */
-void wakeFromPowerOff() {
-  devicePoweredOff = false;
+void enterDeepSleep() {
+  while (digitalRead(BUTTON_PIN) == LOW) {
+    delay(20);
+  }
+  delay(50);  // Release bounce
   
-  // Turn on display
-  display.ssd1306_command(SSD1306_DISPLAYON);
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setCursor(25, 25);
-  display.print("WAKING UP...");
-  display.display();
+  // Keep the button input pulled up while the digital domain is off
+  gpio_pullup_en((gpio_num_t)BUTTON_PIN);
+  gpio_pulldown_dis((gpio_num_t)BUTTON_PIN);
+  esp_deep_sleep_enable_gpio_wakeup(1ULL << BUTTON_PIN, ESP_GPIO_WAKEUP_GPIO_LOW);
   
-  // Restart MAX30102
-  if (hrSensorActive) {
-    particleSensor.wakeUp();
-    delay(100);
-    
-    // Reset heart rate detection variables
-    memset(irBuffer, 0, sizeof(irBuffer));
-    irBufferIndex = 0;
-    maxValue = 0;
-    minValue = 100000;
-    
-    memset(peakTimes, 0, sizeof(peakTimes));
-    peakIndex = 0;
-    peakCount = 0;
-    currentBPM = 0;
-    lastPeakTime = 0;
-    lastValue = 0;
-    peakThreshold = 0;
-    peakDetected = false;
-    
-    runningAvg = 0;
-    sampleCount = 0;
-    
-    lastBeatTime = 0;
-    currentHR = 0;
+  Serial.println("Power off: deep sleep until the button is held");
+  Serial.flush();
+  esp_deep_sleep_start();
+}
+
+/**
+ * After a button wake, check that the press is a deliberate power-on.
+ * Runs before anything else is initialized, so a bump costs only a brief
+ * boot. On success, pulses the motor and waits for the release so the
+ * press is not also taken as a mode change.
+ * 
+ * @return true if the button was held for POWER_HOLD_MS since the wake
+ */
+bool confirmPowerOn() {
+  unsigned long start = millis();
+  while (millis() - start < POWER_HOLD_MS) {
+    if (digitalRead(BUTTON_PIN) == HIGH) return false;
+    delay(20);
   }
   
-  // Restart BLE advertising
-  BLEDevice::startAdvertising();
-  
   // Haptic feedback - 2 short pulses at 25% strength
   for (int i = 0; i < 2; i++) {
     analogWrite(VIBRO_MOTOR_PIN, 64);  // 25% strength
@@ -1758,5 +6175,47 @@ void wakeFromPowerOff() {
     delay(100);
   }
   
-  delay(500);
+  while (digitalRead(BUTTON_PIN) == LOW) {
+    delay(20);
+  }
+  return true;
+}
+
+/**
+ * Carry the clock, current hour and its accumulator over a power-off.
+ * The hour and day are restored as they were at sleep, so the first hour
+ * check after boot saves and rolls them over like any other change.
+ */
+void restorePowerOffState() {
+  if (powerOffState.magic != POWER_OFF_MAGIC) return;
+  powerOffState.magic = 0;
+  if (!powerOffState.clockValid) return;
+  
+  uint64_t sleptUs = rtcMicros() - powerOffState.rtcUs;
+  syncedTime.epochUsAtSync = powerOffState.epochUs + sleptUs;
+  syncedTime.uptimeUsAtSync = uptimeMicros();
+  syncedTime.roundTripMs = powerOffState.roundTripMs;
+  syncedTime.isValid = true;
+  syncedTime.driftBaseValid = false;  // Measured against the previous boot's uptime
+  
+  localTime.nextUpdateUs = 0;
+  localTime.utcHour = 0xFFFFFFFF;
+  updateClock();
+  currentHour = powerOffState.currentHour;
+  lastSyncedDay = powerOffState.lastSyncedDay;
+  hourAccum = powerOffState.hourAccum;
+  
+  Serial.print("Power on: clock restored after ");
+  Serial.print((unsigned long)(sleptUs / 1000000ULL));
+  Serial.println(" s off");
+}
+
+/**
+ * Microseconds on the system time, which the RTC timer keeps counting
+ * through deep sleep (esp_timer restarts from zero on every boot).
+ */
+uint64_t rtcMicros() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  return (uint64_t)tv.tv_sec * 1000000ULL + tv.tv_usec;
 }
\ No newline at end of file
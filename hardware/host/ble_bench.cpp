@@ -0,0 +1,618 @@
+// ===========================================
+// StressView BLE Protocol Benchmark (host)
+// ===========================================
+// Runs the real firmware (DeviceCode.cpp) on a PC against the loopback BLE
+// transport and measures how long the app-facing transfers take under
+// different link conditions:
+// - Today (240 bytes) and Week (70 bytes) characteristic reads
+// - Full delta sync over the Sync characteristic, raw and LZ-compressed
+// - Delta sync recovery after the stack loses notify-sent events
+// - Offline sample drain after 30 minutes disconnected, also interrupted
+//   by a disconnect and by the app turning Sync notifications off
+// - Back-to-back delta syncs to one client while a second streams live frames
+// - Precise time sync error against an app clock, before and after drift learning
+// - Local calendar across a daylight saving change and several days of uptime
+// - Live notifications sent while the wearer is resting
+// - Connectionless broadcast payloads seen by a passive scanner
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Ihardware/host/shim hardware/host/ble_bench.cpp -o ble_bench
+//   ./ble_bench
+
+#include <Arduino.h>
+
+#define BLE_BACKEND BLE_BACKEND_LOOPBACK
+#include "../DeviceCode.cpp"
+#include "loopback_transport.h"
+
+#include <set>
+#include <vector>
+
+using loopback::link;
+
+// One firmware loop() pass per simulated millisecond unless stated otherwise
+const uint64_t LOOP_STEP_US = 1000;
+
+/**
+ * Run the firmware and the links until done() is true or the timeout expires.
+ *
+ * @return true if done() became true
+ */
+bool runUntil(std::function<bool()> done, uint64_t timeoutMs, uint64_t stepUs = LOOP_STEP_US) {
+  uint64_t endUs = host::nowUs + timeoutMs * 1000;
+  while (host::nowUs < endUs) {
+    loop();
+    for (loopback::Link &l : loopback::links) l.step();
+    if (done()) return true;
+    host::nowUs += stepUs;
+  }
+  return false;
+}
+
+void runFor(uint64_t ms, uint64_t stepUs = LOOP_STEP_US) {
+  runUntil([] { return false; }, ms, stepUs);
+}
+
+/**
+ * Give every stored record a sequence number so a full delta sync has
+ * 24 hourly and 7 daily records to send.
+ */
+void seedHistory() {
+  for (int h = 0; h < HOURS_PER_DAY; h++) {
+    todayData[h].hour = h;
+    todayData[h].avgStress = 30 + h;
+    todayData[h].peakStress = 50 + h;
+    todayData[h].avgHR = 70;
+    todayData[h].avgHRV = 45;
+    todayData[h].avgGSR = 1800;
+    todayData[h].sampleCount = 3600;
+    markHourChanged(h);
+  }
+  for (int d = 0; d < DAYS_TO_STORE; d++) {
+    daySeq[d] = ++historySeq;
+  }
+  bleHistoryVersion++;
+}
+
+/**
+ * Connect, exchange MTU and enable the notifications the app uses.
+ * Waits long enough for the firmware's fast-interval request to be granted,
+ * so measurements start at the steady-state interval.
+ */
+void connectClient(const loopback::LinkConfig &config) {
+  link.config = config;
+  link.connect();
+  link.subscribe(BLE_CHANNEL_LIVE, true);
+  link.subscribe(BLE_CHANNEL_SYNC, true);
+  runUntil([] { return link.idle(); }, 10000);
+  runFor(500);
+}
+
+void disconnectClient() {
+  link.disconnect();
+  runFor(1000);
+}
+
+/**
+ * Time one characteristic read.
+ *
+ * @return Milliseconds from request to complete value (-1 on timeout)
+ */
+double timeRead(uint8_t channel, size_t expectedLength) {
+  uint64_t startUs = host::nowUs;
+  link.read(channel);
+  if (!runUntil([] { return link.idle(); }, 30000)) return -1;
+  if (link.readValue.size() != expectedLength) return -1;
+  return (link.lastCompletedUs - startUs) / 1000.0;
+}
+
+struct SyncResult {
+  double ms;
+  uint32_t records;
+  uint32_t bytes;
+  std::vector<uint8_t> recordBytes;  // Uncompressed record bytes, in arrival order
+};
+
+/**
+ * Expand an LZ stream from a 0xD4 delta packet (app-side decoder, see lzEncode).
+ *
+ * @return Decoded bytes, empty if the stream is malformed
+ */
+std::vector<uint8_t> lzDecode(const uint8_t* data, size_t length) {
+  std::vector<uint8_t> out;
+  size_t i = 0;
+  while (i < length) {
+    uint8_t control = data[i++];
+    if (control & 0x80) {
+      if (i >= length) return {};
+      size_t count = (control & 0x7F) + LZ_MIN_MATCH;
+      size_t offset = data[i++] + 1;
+      if (offset > out.size()) return {};
+      for (size_t k = 0; k < count; k++) out.push_back(out[out.size() - offset]);
+    } else {
+      size_t count = control + 1;
+      if (i + count > length) return {};
+      out.insert(out.end(), data + i, data + i + count);
+      i += count;
+    }
+  }
+  return out;
+}
+
+/**
+ * Request a full delta sync and wait for its end packet.
+ */
+SyncResult timeDeltaSync(uint8_t encoding, uint8_t compression = HISTORY_COMPRESS_NONE) {
+  SyncResult result = {-1, 0, 0, {}};
+  bool ended = false;
+  link.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel != BLE_CHANNEL_SYNC) return;
+    result.bytes += n.data.size();
+    if (n.data[0] == DELTA_PACKET_END) {
+      ended = true;
+      return;
+    }
+    result.records += n.data[1];
+    if (n.data[0] == DELTA_PACKET_LZ_RECORDS) {
+      std::vector<uint8_t> records = lzDecode(n.data.data() + DELTA_LZ_HEADER_SIZE,
+                                              n.data.size() - DELTA_LZ_HEADER_SIZE);
+      result.recordBytes.insert(result.recordBytes.end(), records.begin(), records.end());
+    } else {
+      result.recordBytes.insert(result.recordBytes.end(), n.data.begin() + DELTA_HEADER_SIZE, n.data.end());
+    }
+  };
+
+  uint64_t startUs = host::nowUs;
+  link.write(BLE_CHANNEL_COMMAND, {0x04, 0, 0, 0, 0, encoding, compression});
+  if (runUntil([&] { return ended; }, 30000)) {
+    result.ms = (host::nowUs - startUs) / 1000.0;
+  }
+  link.onNotify = nullptr;
+  return result;
+}
+
+/**
+ * Leave the device disconnected long enough to buffer offline samples,
+ * then reconnect and time the drain.
+ */
+SyncResult timeOfflineDrain(const loopback::LinkConfig &config, uint32_t offlineMinutes) {
+  SyncResult result = {-1, 0, 0, {}};
+  bool ended = false;
+
+  runFor(offlineMinutes * 60000UL, 5000);
+
+  link.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel != BLE_CHANNEL_SYNC) return;
+    result.bytes += n.data.size();
+    if (n.data[0] == OFFLINE_PACKET_END) ended = true;
+    else if (n.data[0] == OFFLINE_PACKET_DATA) result.records += n.data[1];
+  };
+  uint64_t startUs = host::nowUs;
+  connectClient(config);
+  if (runUntil([&] { return ended; }, 60000)) {
+    result.ms = (host::nowUs - startUs) / 1000.0;
+  }
+  link.onNotify = nullptr;
+  disconnectClient();
+  return result;
+}
+
+struct InterruptedDrainResult {
+  uint32_t received;        // Samples delivered over all attempts
+  uint32_t unique;          // Distinct sample uptimes among them
+  bool stoppedOnUnsubscribe;
+  bool ended;
+};
+
+/**
+ * Buffer 30 minutes offline at the default MTU (one sample per packet),
+ * then interrupt the drain twice: a disconnect after 40 samples, then Sync
+ * notifications turned off after 40 more. Re-enabling them must finish the
+ * drain without sending any sample twice.
+ */
+InterruptedDrainResult timeInterruptedDrain() {
+  InterruptedDrainResult result = {0, 0, false, false};
+  std::set<uint32_t> uptimes;
+  uint32_t received = 0;
+
+  runFor(30 * 60000UL, 5000);
+
+  link.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel != BLE_CHANNEL_SYNC) return;
+    if (n.data[0] == OFFLINE_PACKET_END) result.ended = true;
+    if (n.data[0] != OFFLINE_PACKET_DATA) return;
+    for (uint8_t i = 0; i < n.data[1]; i++) {
+      const uint8_t* sample = &n.data[OFFLINE_HEADER_SIZE + i * OFFLINE_SAMPLE_SIZE];
+      uptimes.insert(sample[0] | (sample[1] << 8) | (sample[2] << 16) | ((uint32_t)sample[3] << 24));
+      received++;
+    }
+  };
+
+  loopback::LinkConfig config;
+  config.mtu = BLE_DEFAULT_MTU;
+  link.config = config;
+  link.connect();
+  link.subscribe(BLE_CHANNEL_SYNC, true);
+  runUntil([&] { return received >= 40; }, 60000);
+  link.disconnect();
+  runFor(1000);
+
+  link.connect();
+  link.subscribe(BLE_CHANNEL_SYNC, true);
+  runUntil([&] { return received >= 80; }, 60000);
+  link.subscribe(BLE_CHANNEL_SYNC, false);
+  runFor(2000);
+  result.stoppedOnUnsubscribe = !offlineDrainActive;
+
+  link.subscribe(BLE_CHANNEL_SYNC, true);
+  runUntil([&] { return result.ended; }, 60000);
+  link.onNotify = nullptr;
+  disconnectClient();
+
+  result.received = received;
+  result.unique = uptimes.size();
+  return result;
+}
+
+struct SharedResult {
+  uint32_t syncs;           // Complete phone delta syncs
+  double syncMs;            // Average phone delta sync time
+  uint32_t desktopFrames;   // Desktop live frames delivered meanwhile
+  double desktopMaxGapMs;   // Longest gap between desktop live frames
+  bool advertising;         // Still advertising for the free slot
+};
+
+/**
+ * Two centrals at once: a phone (link 0) runs back-to-back full delta syncs
+ * for a while desktop (link 1) streams 10Hz TLV live frames on its own
+ * connection.
+ */
+SharedResult timeSharedClients(const loopback::LinkConfig &config, uint32_t ms) {
+  loopback::Link &desktop = loopback::links[1];
+  SharedResult result = {};
+
+  connectClient(config);
+  desktop.config = config;
+  desktop.connect();
+  desktop.subscribe(BLE_CHANNEL_LIVE, true);
+  desktop.write(BLE_CHANNEL_COMMAND, {0x03, LIVE_MODE_TLV, 10});
+  runUntil([&] { return desktop.idle(); }, 10000);
+  runFor(1000);
+  result.advertising = loopback::advertising;
+
+  uint64_t lastFrameUs = 0;
+  desktop.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel != BLE_CHANNEL_LIVE) return;
+    if (lastFrameUs > 0) {
+      result.desktopMaxGapMs = max(result.desktopMaxGapMs, (n.deliveredUs - lastFrameUs) / 1000.0);
+    }
+    lastFrameUs = n.deliveredUs;
+    result.desktopFrames++;
+  };
+  uint64_t endUs = host::nowUs + ms * 1000ULL;
+  double totalMs = 0;
+  while (host::nowUs < endUs) {
+    SyncResult sync = timeDeltaSync(HISTORY_ENCODING_FIXED);
+    if (sync.records != 31) continue;
+    result.syncs++;
+    totalMs += sync.ms;
+  }
+  result.syncMs = result.syncs > 0 ? totalMs / result.syncs : 0;
+  desktop.onNotify = nullptr;
+
+  desktop.disconnect();
+  disconnectClient();
+  return result;
+}
+
+// App UTC clock for the time sync test: starts at a fixed time and runs
+// appClockPpm faster than the device crystal
+const uint64_t APP_EPOCH_MS = (uint64_t)daysFromCivil(2026, 10, 17) * 86400000ULL + 9 * 3600000ULL + 123;
+double appClockPpm = 0;
+
+uint64_t appNowMs(uint64_t us) {
+  return APP_EPOCH_MS + (uint64_t)(us / 1000.0 * (1 + appClockPpm * 1e-6));
+}
+
+double clockErrorMs() {
+  return (double)(int64_t)(currentEpochMicros(uptimeMicros()) / 1000 - appNowMs(host::nowUs));
+}
+
+/**
+ * Run one precise time sync (command 0x08), answering each request the way
+ * the app does: T2 when the notification arrives, reply written at once.
+ *
+ * @return true if all rounds were answered
+ */
+bool runTimeSync() {
+  uint8_t replies = 0;
+  link.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel != BLE_CHANNEL_SYNC || n.data[0] != TIME_PACKET_REQUEST) return;
+    uint64_t t2 = appNowMs(n.deliveredUs);
+    std::vector<uint8_t> reply(15, 0);
+    reply[0] = 0x09;
+    memcpy(&reply[1], &n.data[1], 4);
+    memcpy(&reply[5], &t2, 8);
+    link.write(BLE_CHANNEL_COMMAND, reply);
+    replies++;
+  };
+  link.write(BLE_CHANNEL_COMMAND, {0x08});
+  bool done = runUntil([&] { return replies == TIME_SYNC_ROUNDS && bleClients[0].timeSyncRoundsLeft == 0; }, 10000);
+  link.onNotify = nullptr;
+  return done;
+}
+
+struct TimeSyncResult {
+  double coarseErrorMs;     // After command 0x01 (whole seconds)
+  double syncErrorMs;       // Right after the first precise sync
+  uint16_t roundTripMs;
+  double hourErrorMs;       // One hour later, drift not yet known
+  double driftPpm;          // Learned at the second precise sync
+  double learnedErrorMs;    // One hour after the second sync
+};
+
+/**
+ * Sync the clock of a device whose crystal runs ppm slower than the app's.
+ */
+TimeSyncResult timeClockSync(const loopback::LinkConfig &config, double ppm) {
+  TimeSyncResult result = {};
+  appClockPpm = ppm;
+  connectClient(config);
+  
+  uint64_t wall = appNowMs(host::nowUs);
+  uint16_t year;
+  uint8_t month, day;
+  civilFromDays((int32_t)(wall / 86400000ULL), year, month, day);
+  uint32_t second = (uint32_t)(wall % 86400000ULL / 1000);
+  link.write(BLE_CHANNEL_COMMAND, {0x01, (uint8_t)(year & 0xFF), (uint8_t)(year >> 8), month, day,
+                                   (uint8_t)(second / 3600), (uint8_t)(second / 60 % 60), (uint8_t)(second % 60)});
+  runUntil([] { return link.idle(); }, 5000);
+  runFor(10);
+  result.coarseErrorMs = clockErrorMs();
+  
+  runTimeSync();
+  result.syncErrorMs = clockErrorMs();
+  result.roundTripMs = syncedTime.roundTripMs;
+  
+  runFor(3600000UL, 20000);
+  result.hourErrorMs = clockErrorMs();
+  runTimeSync();
+  result.driftPpm = syncedTime.driftPpb / 1000.0;
+  
+  runFor(3600000UL, 20000);
+  result.learnedErrorMs = clockErrorMs();
+  disconnectClient();
+  return result;
+}
+
+/**
+ * Format the device's cached local time.
+ */
+std::string localTimeString() {
+  updateClock();
+  char text[40];
+  snprintf(text, sizeof(text), "%04u-%02u-%02u %02u:%02u:%02u UTC%+d", localTime.year, localTime.month,
+           localTime.day, localTime.hour, localTime.minute, localTime.second, localTime.utcOffsetMin / 60);
+  return text;
+}
+
+struct CalendarResult {
+  std::string beforeDst;
+  std::string afterDst;
+  std::string afterDays;
+};
+
+/**
+ * Set Central European Time with EU daylight saving, sync two seconds before
+ * the spring change and let the clock run across it and then for days.
+ */
+CalendarResult runCalendar(uint32_t days) {
+  CalendarResult result;
+  syncedTime.driftPpb = 0;  // Ideal crystal: drift learned by the sync test would show up here
+  connectClient(loopback::LinkConfig());
+  link.write(BLE_CHANNEL_COMMAND, {0x0A, 60, 0, 60, DST_RULE_EU});
+  link.write(BLE_CHANNEL_COMMAND, {0x01, 2026 & 0xFF, 2026 >> 8, 3, 29, 1, 59, 58});
+  runUntil([] { return link.idle(); }, 5000);
+  runFor(10);
+  result.beforeDst = localTimeString();
+  runFor(3000);
+  result.afterDst = localTimeString();
+  runFor(days * 86400000ULL, 100000);
+  result.afterDays = localTimeString();
+  link.write(BLE_CHANNEL_COMMAND, {0x0A, 0, 0, 0, DST_RULE_NONE});
+  runUntil([] { return link.idle(); }, 5000);
+  disconnectClient();
+  return result;
+}
+
+/**
+ * Count legacy live notifications over a resting period (steady heart rate,
+ * no motion, constant GSR).
+ */
+uint32_t countLiveNotifications(uint32_t minutes) {
+  uint32_t count = 0;
+  link.onNotify = [&](const loopback::Notification &n) {
+    if (n.channel == BLE_CHANNEL_LIVE) count++;
+  };
+  runFor(minutes * 60000UL, 5000);
+  link.onNotify = nullptr;
+  return count;
+}
+
+/**
+ * Read one u32 counter from the Stats characteristic.
+ */
+uint32_t readStat(uint8_t tag) {
+  link.read(BLE_CHANNEL_STATS);
+  runUntil([] { return link.idle(); }, 5000);
+  const std::vector<uint8_t> &value = link.readValue;
+  for (size_t i = 1; i + 2 <= value.size(); i += 2 + value[i + 1]) {
+    if (value[i] != tag) continue;
+    uint32_t result = 0;
+    for (uint8_t k = 0; k < value[i + 1] && i + 2 + k < value.size(); k++) {
+      result |= (uint32_t)value[i + 2 + k] << (8 * k);
+    }
+    return result;
+  }
+  return 0;
+}
+
+struct Broadcast {
+  bool valid;
+  uint8_t sequence;
+  uint8_t stress;
+  uint8_t hr;
+  uint8_t status;
+};
+
+/**
+ * Decode the manufacturer data a scanner sees (gateway-side decoder,
+ * see updateBroadcast).
+ */
+Broadcast decodeBroadcast(const std::vector<uint8_t> &data) {
+  Broadcast b = {};
+  if (data.size() < BROADCAST_SIZE) return b;
+  if ((data[0] | (data[1] << 8)) != BROADCAST_COMPANY_ID || data[2] != BROADCAST_FORMAT) return b;
+  b.valid = true;
+  b.sequence = data[3];
+  b.stress = data[4];
+  b.hr = data[5];
+  b.status = data[10];
+  return b;
+}
+
+int main() {
+  host::resetPins();
+  setup();
+  runFor(6000);  // GSR calibration
+  seedHistory();
+
+  struct Scenario {
+    const char* name;
+    uint16_t mtu;
+    float minIntervalMs;
+    uint8_t llPayload;
+    float lossRate;
+  };
+  const Scenario scenarios[] = {
+    {"default MTU, 30ms",    23,  30,  27,  0},
+    {"default MTU, 7.5ms",   23,  7.5, 27,  0},
+    {"MTU 247, 50ms",        247, 50,  27,  0},
+    {"MTU 247, 30ms",        247, 30,  27,  0},
+    {"MTU 247, 15ms",        247, 15,  27,  0},
+    {"MTU 247, 7.5ms",       247, 7.5, 27,  0},
+    {"MTU 247, 7.5ms, DLE",  247, 7.5, 251, 0},
+    {"MTU 247, 15ms, 5%",    247, 15,  27,  0.05},
+    {"MTU 247, 15ms, 20%",   247, 15,  27,  0.20},
+  };
+
+  printf("%-22s %8s %9s %8s %9s %7s %9s %9s %7s %6s %8s %8s\n",
+         "scenario", "CI(ms)", "today", "week", "delta", "recs", "delta B/s",
+         "lz delta", "lz recs", "ratio", "dropped", "retx");
+  for (const Scenario &s : scenarios) {
+    loopback::LinkConfig config;
+    config.mtu = s.mtu;
+    config.minIntervalMs = s.minIntervalMs;
+    config.initialIntervalMs = max(s.minIntervalMs, 30.0f);
+    config.llPayload = s.llPayload;
+    config.lossRate = s.lossRate;
+
+    connectClient(config);
+    double todayMs = timeRead(BLE_CHANNEL_TODAY, 240);
+    double weekMs = timeRead(BLE_CHANNEL_WEEK, 70);
+    SyncResult delta = timeDeltaSync(HISTORY_ENCODING_FIXED);
+    SyncResult lzDelta = timeDeltaSync(HISTORY_ENCODING_FIXED, HISTORY_COMPRESS_LZ);
+    float interval = link.intervalMs();
+    loopback::LinkStats stats = link.stats;
+    disconnectClient();
+
+    // Every LZ packet must expand to its records; complete syncs must match byte for byte
+    bool complete = delta.records == 31 && lzDelta.records == 31;
+    if (lzDelta.recordBytes.size() != lzDelta.records * DELTA_RECORD_SIZE ||
+        (complete && lzDelta.recordBytes != delta.recordBytes)) {
+      printf("%s: LZ records do not match uncompressed records\n", s.name);
+      return 1;
+    }
+
+    printf("%-22s %8.2f %7.1fms %6.1fms %7.1fms %4u/31 %9.0f %7.1fms %4u/31 %6.2f %8u %8u\n",
+           s.name, interval, todayMs, weekMs, delta.ms, delta.records,
+           delta.ms > 0 ? delta.bytes * 1000.0 / delta.ms : 0.0,
+           lzDelta.ms, lzDelta.records,
+           lzDelta.bytes > 0 ? (double)delta.bytes / lzDelta.bytes : 0.0,
+           stats.notifyRejected, stats.retransmissions);
+  }
+
+  // Lost notify-sent events stall the in-flight window once; later syncs on
+  // the same connection must run at full speed again
+  loopback::LinkConfig lostConfig;
+  lostConfig.mtu = BLE_DEFAULT_MTU;
+  lostConfig.minIntervalMs = 7.5;
+  connectClient(lostConfig);
+  SyncResult clean = timeDeltaSync(HISTORY_ENCODING_FIXED);
+  link.dropCompletions = BLE_MAX_IN_FLIGHT;
+  SyncResult stalled = timeDeltaSync(HISTORY_ENCODING_FIXED);
+  SyncResult recovered = timeDeltaSync(HISTORY_ENCODING_FIXED);
+  disconnectClient();
+  printf("\nlost completions (default MTU, 7.5ms, %u lost): delta %.1fms, with loss %.1fms (%u/31), after %.1fms (%s)\n",
+         BLE_MAX_IN_FLIGHT, clean.ms, stalled.ms, stalled.records, recovered.ms,
+         recovered.ms > 0 && recovered.ms < clean.ms * 2 ? "recovered" : "stalled");
+
+  loopback::LinkConfig drainConfig;
+  drainConfig.minIntervalMs = 15;
+  SyncResult drain = timeOfflineDrain(drainConfig, 30);
+  InterruptedDrainResult interrupted = timeInterruptedDrain();
+  printf("offline drain interrupted (30 min, default MTU): %u samples received, %u unique, "
+         "drain %s on unsubscribe, %s\n",
+         interrupted.received, interrupted.unique,
+         interrupted.stoppedOnUnsubscribe ? "stopped" : "kept running",
+         interrupted.ended ? "completed" : "did not complete");
+  printf("offline drain (30 min, MTU 247, 15ms): %u samples, %u bytes in %.1fms (%.0f B/s)\n",
+         drain.records, drain.bytes, drain.ms, drain.ms > 0 ? drain.bytes * 1000.0 / drain.ms : 0.0);
+
+  loopback::LinkConfig sharedConfig;
+  sharedConfig.minIntervalMs = 15;
+  SharedResult shared = timeSharedClients(sharedConfig, 2000);
+  printf("two clients (MTU 247, 15ms, 2s): phone %u full delta syncs (avg %.1fms), desktop %u 10Hz live frames (max gap %.0fms), advertising %s\n",
+         shared.syncs, shared.syncMs, shared.desktopFrames, shared.desktopMaxGapMs,
+         shared.advertising ? "on" : "off");
+
+  // Resting wearer: default deadbands/keepalive vs. a 1s keepalive (every sample sent)
+  connectClient(loopback::LinkConfig());
+  uint32_t changeDriven = countLiveNotifications(10);
+  uint32_t suppressed = readStat(TLV_STAT_LIVE_SUPPRESSED);
+  link.write(BLE_CHANNEL_COMMAND, {0x06, TUNE_LIVE_KEEPALIVE, 1, 0, 0, 0});
+  uint32_t everySample = countLiveNotifications(10);
+  link.write(BLE_CHANNEL_COMMAND, {0x07});
+  disconnectClient();
+  printf("resting live notifications (10 min): %u change-driven (%u suppressed), %u with 1s keepalive\n",
+         changeDriven, suppressed, everySample);
+
+  // Broadcast at 1s, enabled by an app once, then watched with no connection
+  connectClient(loopback::LinkConfig());
+  link.write(BLE_CHANNEL_COMMAND, {0x06, TUNE_BROADCAST_PERIOD, 0xE8, 0x03, 0, 0});
+  runUntil([] { return link.idle(); }, 5000);
+  disconnectClient();
+  uint32_t updates = 0;
+  Broadcast last = decodeBroadcast(loopback::broadcastData);
+  runUntil([&] {
+    Broadcast b = decodeBroadcast(loopback::broadcastData);
+    if (b.valid && b.sequence != last.sequence) updates++;
+    last = b;
+    return false;
+  }, 60000);
+  printf("broadcast (1s period, 60s, no connection): %u payload updates, last seq %u stress %u HR %u status 0x%02X, advertising %s\n",
+         updates, last.sequence, last.stress, last.hr, last.status, loopback::advertising ? "on" : "off");
+  loopback::LinkConfig clockConfig;
+  clockConfig.minIntervalMs = 15;
+  TimeSyncResult clock = timeClockSync(clockConfig, 40);
+  printf("time sync (15ms, crystal 40ppm slow): coarse %.0fms, precise %.0fms (round trip %ums), "
+         "+1h %.0fms, learned drift %.1fppm, +1h after %.0fms\n",
+         clock.coarseErrorMs, clock.syncErrorMs, clock.roundTripMs, clock.hourErrorMs,
+         clock.driftPpm, clock.learnedErrorMs);
+  CalendarResult calendar = runCalendar(3);
+  printf("local clock (CET, EU DST): synced %s, +3s %s, +3 days %s\n",
+         calendar.beforeDst.c_str(), calendar.afterDst.c_str(), calendar.afterDays.c_str());
+  printf("send queues (all runs): high water %u/%u, %u coalesced, %u retried, %u dropped\n",
+         bleSendHighWater, BLE_SEND_QUEUE_SIZE, bleSendCoalesced, bleSendRetries, bleSendDropped);
+  return 0;
+}
@@ -0,0 +1,215 @@
+// ===========================================
+// StressView Display Benchmark (host)
+// ===========================================
+// Runs the real firmware (DeviceCode.cpp) on a PC with a model of the
+// SSD1306 on the I2C bus (shim/Wire.h) and reports for each screen:
+// - Frames per second drawn by the render scheduler over 10 s of loop()
+// - Host time to draw, compose and send a full frame, and the scene it needs
+// - I2C bytes per frame and per second, and bus time per second at 1 MHz
+// After every flush the panel's display RAM is compared with the scene
+// composed from scratch, so partial updates that leave stale tiles are
+// reported as mismatches. With a directory argument each screen is also
+// written there as a PBM snapshot (lit pixels black).
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Ihardware/host/shim hardware/host/display_bench.cpp -o display_bench
+//   ./display_bench [snapshot-dir]
+
+#include <Arduino.h>
+
+#define BLE_BACKEND BLE_BACKEND_LOOPBACK
+#include "../DeviceCode.cpp"
+#include "loopback_transport.h"
+
+#include <chrono>
+#include <string>
+
+const uint32_t SCHEDULED_RUN_MS = 10000;  // loop() time per screen
+const int COST_FRAMES = 500;               // Frames timed per screen
+const uint32_t COST_FRAME_STEP_MS = 40;    // Simulated time between timed frames
+const uint32_t I2C_CLOCK_HZ = 1000000;     // Wire.setClock() in setup()
+
+struct ScreenResult {
+  const char* name;
+  uint32_t frames;
+  double usPerFrame;
+  uint8_t sceneItems;
+  uint8_t sceneData;
+  uint32_t busBytes;
+  uint32_t transactions;
+  uint32_t mismatches;
+};
+
+/**
+ * Check that the panel shows exactly what the current scene composes to.
+ */
+bool panelMatchesScene() {
+  uint8_t row[SCREEN_WIDTH];
+  for (uint8_t page = 0; page < DISPLAY_PAGES; page++) {
+    composeDisplayPage(page, row);
+    if (memcmp(row, host::panel.ram[page], SCREEN_WIDTH) != 0) return false;
+  }
+  return true;
+}
+
+/**
+ * Write the panel's display RAM as a binary PBM (P4) image.
+ */
+void writeSnapshot(const std::string& dir, const char* name) {
+  std::string path = dir + "/" + name + ".pbm";
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) {
+    printf("cannot write %s\n", path.c_str());
+    return;
+  }
+  fprintf(f, "P4\n%d %d\n", SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (int y = 0; y < SCREEN_HEIGHT; y++) {
+    for (int x = 0; x < SCREEN_WIDTH; x += 8) {
+      uint8_t bits = 0;
+      for (int i = 0; i < 8; i++) {
+        if (host::panel.pixel(x + i, y)) bits |= 0x80 >> i;
+      }
+      fputc(bits, f);
+    }
+  }
+  fclose(f);
+}
+
+/**
+ * Run loop() on the current screen and count what the scheduler draws and
+ * what reaches the bus, checking the panel after every flush.
+ */
+void runScheduled(ScreenResult& result) {
+  lastDisplayActivity = millis();
+  renderRequested = true;
+  uint32_t flushes = displayFlushes;
+  uint32_t bytes = Wire.bytesWritten;
+  uint32_t transactions = Wire.transactions;
+
+  uint64_t endUs = host::nowUs + (uint64_t)SCHEDULED_RUN_MS * 1000;
+  while (host::nowUs < endUs) {
+    uint32_t before = displayFlushes;
+    loop();
+    if (displayFlushes != before && !panelMatchesScene()) result.mismatches++;
+    host::nowUs += 1000;
+  }
+
+  result.frames = displayFlushes - flushes;
+  result.busBytes = Wire.bytesWritten - bytes;
+  result.transactions = Wire.transactions - transactions;
+  result.sceneItems = sceneItemCount;
+  result.sceneData = sceneDataUsed;
+}
+
+/**
+ * Time drawFrame() (clear, draw, compose, flush) on the host. The tile
+ * checksums are invalidated first so every frame composes and sends all
+ * pages: the cost of a frame whose content changed everywhere.
+ */
+void timeFrames(ScreenResult& result) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < COST_FRAMES; i++) {
+    host::nowUs += COST_FRAME_STEP_MS * 1000;
+    displayTilesValid = false;
+    drawFrame(millis());
+  }
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  result.usPerFrame = std::chrono::duration<double, std::micro>(elapsed).count() / COST_FRAMES;
+}
+
+void printResult(const ScreenResult& r) {
+  double seconds = SCHEDULED_RUN_MS / 1000.0;
+  // Each transaction also carries the address byte; 9 clocks per byte with ACK
+  double busMsPerSecond = (r.busBytes + r.transactions) * 9.0 * 1000.0 / I2C_CLOCK_HZ / seconds;
+  printf("%-12s %6.1f %7.1f %6u %5u %10.0f %9.0f %9.2f %10u\n",
+         r.name, r.frames / seconds, r.usPerFrame, r.sceneItems, r.sceneData,
+         r.frames ? (double)r.busBytes / r.frames : 0.0, r.busBytes / seconds,
+         busMsPerSecond, r.mismatches);
+}
+
+/**
+ * Give today a recorded morning so the trend screen has something to show.
+ */
+void seedToday() {
+  for (int h = 6; h < 12; h++) {
+    todayData[h].hour = h;
+    todayData[h].avgStress = 20 + (h - 6) * 12;
+    todayData[h].peakStress = todayData[h].avgStress + 10;
+    todayData[h].highStressMins = (h - 6) * 9;
+    todayData[h].sampleCount = 3600;
+    markHourChanged(h);
+  }
+}
+
+int main(int argc, char** argv) {
+  std::string snapshotDir = (argc > 1) ? argv[1] : "";
+
+  host::resetPins();
+  setup();
+
+  printf("%-12s %6s %7s %6s %5s %10s %9s %9s %10s\n",
+         "screen", "fps", "us/full", "items", "data", "bytes/frm", "bytes/s", "bus ms/s", "mismatches");
+
+  // Calibration runs for the first 5 s of loop() after setup()
+  ScreenResult calibration = {"calibration"};
+  uint32_t flushes = displayFlushes;
+  uint32_t bytes = Wire.bytesWritten;
+  uint32_t transactions = Wire.transactions;
+  unsigned long calibrationStart = millis();
+  bool calibrationSnapshot = snapshotDir.empty();
+  while (!calibrationComplete) {
+    uint32_t before = displayFlushes;
+    loop();
+    if (displayFlushes != before && !panelMatchesScene()) calibration.mismatches++;
+    if (!calibrationSnapshot && millis() - calibrationStart >= 2500) {
+      writeSnapshot(snapshotDir, "calibration");
+      calibrationSnapshot = true;
+    }
+    host::nowUs += 1000;
+  }
+  double calibrationSeconds = (millis() - calibrationStart) / 1000.0;
+  calibration.frames = displayFlushes - flushes;
+  calibration.busBytes = Wire.bytesWritten - bytes;
+  calibration.transactions = Wire.transactions - transactions;
+  calibration.sceneItems = sceneItemCount;
+  calibration.sceneData = sceneDataUsed;
+
+  // Time the calibration screen by replaying it with the flag cleared
+  calibrationComplete = false;
+  calibrationStartTime = millis();
+  timeFrames(calibration);
+  calibrationComplete = true;
+
+  // Normalize to the 10 s window the other screens use
+  double scale = SCHEDULED_RUN_MS / 1000.0 / calibrationSeconds;
+  calibration.frames = calibration.frames * scale;
+  calibration.busBytes = calibration.busBytes * scale;
+  calibration.transactions = calibration.transactions * scale;
+  printResult(calibration);
+
+  seedToday();
+
+  struct Screen {
+    const char* name;
+    State state;
+  };
+  const Screen screens[] = {
+    {"dashboard", DASHBOARD},
+    {"breathe",   BREATHE},
+    {"info",      INFO},
+    {"trend",     TREND},
+  };
+
+  for (const Screen& screen : screens) {
+    ScreenResult result = {screen.name};
+    currentState = screen.state;
+    runScheduled(result);
+    if (!snapshotDir.empty()) writeSnapshot(snapshotDir, screen.name);
+    timeFrames(result);
+    printResult(result);
+  }
+
+  printf("\nfull frame: %d data bytes; scene limits %d items, %d data bytes; %u scene overflows\n",
+         SCREEN_WIDTH * DISPLAY_PAGES, SCENE_MAX_ITEMS, SCENE_DATA_SIZE, sceneOverflows);
+  return 0;
+}
@@ -0,0 +1,364 @@
+// ===========================================
+// Loopback BLE Transport (host builds)
+// ===========================================
+// Implements the firmware's BLE transport functions (bleNotify, bleSetValue,
+// ...) against an in-process GATT client, so the protocol code in
+// DeviceCode.cpp can be exercised and timed on a PC without radios.
+//
+// The link model works in connection events on the simulated clock:
+// - Every connection interval the peripheral may send up to packetsPerEvent
+//   link-layer PDUs. An ATT packet of L bytes needs ceil((L + 4) / llPayload)
+//   PDUs (4-byte L2CAP header; llPayload = 27 without data length extension).
+// - A lost PDU is retransmitted by the link layer in the next event, so loss
+//   adds latency rather than losing data (as on a real connection).
+// - The client has one ATT request in flight at a time. Long reads continue
+//   with Read Blob requests while a response fills the MTU.
+// - With slave latency the peripheral only listens every (latency + 1)
+//   events while it has nothing queued, delaying client requests.
+// - Connection parameter requests are granted after a few events, clamped
+//   to the fastest interval the central allows.
+// - Each of the BLE_MAX_CLIENTS links is an independent central with its own
+//   clock phase, MTU and subscriptions; links[i] is the firmware's client slot i.
+//
+// Include exactly once, after DeviceCode.cpp (which must be built with
+// BLE_BACKEND set to BLE_BACKEND_LOOPBACK).
+
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <random>
+
+namespace loopback {
+
+// Device-wide GAP and GATT server state
+inline bool advertising = false;
+inline std::vector<uint8_t> broadcastData;           // Manufacturer data in the advertising payload
+inline std::vector<uint8_t> values[BLE_CHANNEL_COUNT];  // Characteristic values set by the firmware
+
+struct LinkConfig {
+  uint16_t mtu = BLE_PREFERRED_MTU;  // ATT MTU agreed in the MTU exchange
+  float initialIntervalMs = 30;      // Interval the central picks when connecting
+  float minIntervalMs = 7.5;         // Fastest interval the central will grant
+  bool honorRequests = true;         // Central accepts peripheral parameter requests
+  uint8_t packetsPerEvent = 4;       // Downlink PDUs per connection event
+  uint8_t llPayload = 27;            // Link-layer payload (251 with data length extension)
+  float lossRate = 0;                // Probability that a PDU has to be retransmitted
+  uint8_t stackQueueDepth = 10;      // Notifications the device stack can buffer
+  uint32_t seed = 1;
+};
+
+struct LinkStats {
+  uint32_t events = 0;
+  uint32_t pdus = 0;
+  uint32_t retransmissions = 0;
+  uint32_t notifications = 0;        // Delivered to the client
+  uint32_t notifyRejected = 0;       // Stack queue full or not subscribed
+  uint32_t truncated = 0;            // Notifications longer than MTU - 3
+  uint32_t connParamUpdates = 0;
+  uint64_t notifyLatencyUs = 0;      // Sum of queue-to-delivery time
+};
+
+struct Notification {
+  uint8_t channel;
+  std::vector<uint8_t> data;
+  uint64_t queuedUs;
+  uint64_t deliveredUs;
+};
+
+class Link {
+ public:
+  LinkConfig config;
+  LinkStats stats;
+  std::function<void(const Notification&)> onNotify;
+
+  std::vector<uint8_t> readValue;    // Result of the last completed read
+  uint64_t lastCompletedUs = 0;      // When the last ATT request completed
+  uint32_t dropCompletions = 0;      // Notify-sent events to lose (stack error)
+
+  bool connected() const { return connected_; }
+  bool idle() const { return ops_.empty(); }
+  float intervalMs() const { return intervalUnits_ * 1.25f; }
+  uint8_t client() const;
+
+  /**
+   * Connect as a central and start the MTU exchange.
+   */
+  void connect() {
+    connected_ = true;
+    advertising = false;
+    stats = LinkStats();
+    rng_.seed(config.seed);
+    ops_.clear();
+    downlink_.clear();
+    for (bool &s : subscribed_) s = false;
+    eventCounter_ = 0;
+    latency_ = 0;
+    pendingUpdate_ = false;
+    intervalUnits_ = (uint16_t)(config.initialIntervalMs / 1.25f + 0.5f);
+    nextEventUs_ = host::nowUs + intervalUnits_ * 1250;
+
+    uint8_t address[6] = {0x02, 0x00, 0x00, 0x00, 0x00, (uint8_t)(client() + 1)};
+    pushBleEvent(client(), BLE_EVENT_CONNECTED, address, sizeof(address));
+    handleConnParamsUpdated(client(), intervalUnits_, 0, 400);
+    queueOp(OP_MTU, 0, {});
+  }
+
+  /**
+   * Drop the connection (client side or supervision timeout).
+   */
+  void disconnect() {
+    if (!connected_) return;
+    connected_ = false;
+    ops_.clear();
+    downlink_.clear();
+    handleConnParamsUpdated(client(), 0, 0, 0);
+    pushBleEvent(client(), BLE_EVENT_DISCONNECTED, nullptr, 0);
+  }
+
+  void read(uint8_t channel) { queueOp(OP_READ, channel, {}); }
+  void write(uint8_t channel, const std::vector<uint8_t> &data) { queueOp(OP_WRITE, channel, data); }
+  void subscribe(uint8_t channel, bool enable) { queueOp(OP_SUBSCRIBE, channel, {(uint8_t)enable}); }
+
+  /**
+   * Run every connection event that is due on the simulated clock.
+   * Call after each firmware loop() pass.
+   */
+  void step() {
+    while (connected_ && host::nowUs >= nextEventUs_) {
+      connectionEvent();
+      nextEventUs_ += intervalUnits_ * 1250;
+    }
+  }
+
+  // ----- Device side (called through the transport functions) -----
+
+  bool deviceNotify(uint8_t channel, const uint8_t* data, size_t length) {
+    if (!connected_ || !subscribed_[channel] || queuedNotifications() >= config.stackQueueDepth) {
+      stats.notifyRejected++;
+      return false;
+    }
+    if (length > config.mtu - 3u) {
+      length = config.mtu - 3;
+      stats.truncated++;
+    }
+    downlink_.push_back({channel, std::vector<uint8_t>(data, data + length), host::nowUs,
+                         pdusFor(3 + length), false});
+    return true;
+  }
+
+  void deviceUpdateConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    if (!connected_ || !config.honorRequests) return;
+    uint16_t floorUnits = (uint16_t)(config.minIntervalMs / 1.25f + 0.5f);
+    requestedInterval_ = max(minInterval, floorUnits);
+    requestedLatency_ = latency;
+    requestedTimeout_ = timeout;
+    pendingUpdate_ = true;
+    updateAtEvent_ = eventCounter_ + 6;  // Instant is a few events in the future
+  }
+
+ private:
+  enum OpType { OP_MTU, OP_READ, OP_WRITE, OP_SUBSCRIBE };
+
+  struct Op {
+    OpType type;
+    uint8_t channel;
+    std::vector<uint8_t> data;
+    uint16_t offset;
+    bool sent;
+  };
+
+  struct Packet {
+    uint8_t channel;
+    std::vector<uint8_t> data;
+    uint64_t queuedUs;
+    uint16_t pdusLeft;
+    bool isResponse;
+  };
+
+  void queueOp(OpType type, uint8_t channel, std::vector<uint8_t> data) {
+    ops_.push_back({type, channel, std::move(data), 0, false});
+  }
+
+  uint16_t pdusFor(size_t attLength) const {
+    return (uint16_t)((attLength + 4 + config.llPayload - 1) / config.llPayload);
+  }
+
+  size_t queuedNotifications() const {
+    size_t n = 0;
+    for (const Packet &p : downlink_) n += p.isResponse ? 0 : 1;
+    return n;
+  }
+
+  bool lost() {
+    return config.lossRate > 0 && std::uniform_real_distribution<float>(0, 1)(rng_) < config.lossRate;
+  }
+
+  void connectionEvent() {
+    eventCounter_++;
+    stats.events++;
+
+    if (pendingUpdate_ && eventCounter_ >= updateAtEvent_) {
+      pendingUpdate_ = false;
+      intervalUnits_ = requestedInterval_;
+      latency_ = requestedLatency_;
+      stats.connParamUpdates++;
+      handleConnParamsUpdated(client(), requestedInterval_, requestedLatency_, requestedTimeout_);
+    }
+
+    // Peripheral with nothing to send may sleep through latency events
+    if (downlink_.empty() && latency_ > 0 && eventCounter_ % (latency_ + 1) != 0) return;
+
+    // Uplink: at most one outstanding ATT request
+    if (!ops_.empty() && !ops_.front().sent) {
+      stats.pdus++;
+      if (lost()) {
+        stats.retransmissions++;
+        return;
+      }
+      ops_.front().sent = true;
+      deliverRequest(ops_.front());
+    }
+
+    // Downlink: notifications and responses in stack order
+    for (uint8_t budget = config.packetsPerEvent; budget > 0 && !downlink_.empty(); budget--) {
+      stats.pdus++;
+      if (lost()) {
+        stats.retransmissions++;
+        break;  // A missed acknowledgement closes the event
+      }
+      Packet &packet = downlink_.front();
+      if (--packet.pdusLeft > 0) continue;
+
+      Packet done = std::move(packet);
+      downlink_.pop_front();
+      if (done.isResponse) {
+        completeRequest(done);
+      } else {
+        Notification n = {done.channel, std::move(done.data), done.queuedUs, host::nowUs};
+        stats.notifications++;
+        stats.notifyLatencyUs += n.deliveredUs - n.queuedUs;
+        if (dropCompletions > 0) dropCompletions--;
+        else handleNotifyComplete(client());  // As the stack's notify-sent event
+        if (onNotify) onNotify(n);
+      }
+    }
+  }
+
+  /**
+   * Request reached the device: run the GATT server side and queue the response.
+   */
+  void deliverRequest(Op &op) {
+    std::vector<uint8_t> response;
+    switch (op.type) {
+      case OP_MTU: {
+        uint8_t mtu[2] = {(uint8_t)(config.mtu & 0xFF), (uint8_t)(config.mtu >> 8)};
+        pushBleEvent(client(), BLE_EVENT_MTU, mtu, 2);
+        break;
+      }
+      case OP_READ: {
+        // The value is captured when the read starts so Read Blobs stay consistent
+        if (op.offset == 0) {
+          if (op.channel == BLE_CHANNEL_TODAY || op.channel == BLE_CHANNEL_WEEK ||
+              op.channel == BLE_CHANNEL_STATS) {
+            const uint8_t* data;
+            size_t length = handleBleRead(client(), op.channel, &data);
+            if (length > 0) readSnapshot_.assign(data, data + length);
+            else readSnapshot_ = values[op.channel];
+          } else {
+            readSnapshot_ = values[op.channel];
+          }
+        }
+        const std::vector<uint8_t> &value = readSnapshot_;
+        size_t start = min((size_t)op.offset, value.size());
+        size_t length = min(value.size() - start, (size_t)config.mtu - 1);
+        response.assign(value.begin() + start, value.begin() + start + length);
+        break;
+      }
+      case OP_WRITE:
+        pushBleEvent(client(), BLE_EVENT_COMMAND, op.data.data(), min(op.data.size(), (size_t)config.mtu - 3));
+        break;
+      case OP_SUBSCRIBE: {
+        subscribed_[op.channel] = op.data[0] != 0;
+        uint8_t value[2] = {op.channel, op.data[0]};
+        pushBleEvent(client(), BLE_EVENT_SUBSCRIBE, value, 2);
+        break;
+      }
+    }
+    downlink_.push_back({op.channel, response, host::nowUs, pdusFor(1 + response.size()), true});
+  }
+
+  /**
+   * Response reached the client: finish the request or continue a long read.
+   */
+  void completeRequest(const Packet &response) {
+    Op &op = ops_.front();
+    if (op.type == OP_READ) {
+      if (op.offset == 0) readValue.clear();
+      readValue.insert(readValue.end(), response.data.begin(), response.data.end());
+      if (response.data.size() == config.mtu - 1u) {
+        op.offset += response.data.size();
+        op.sent = false;  // Read Blob for the next chunk
+        return;
+      }
+    }
+    lastCompletedUs = host::nowUs;
+    ops_.pop_front();
+  }
+
+  bool connected_ = false;
+  std::deque<Op> ops_;
+  std::deque<Packet> downlink_;
+  std::vector<uint8_t> readSnapshot_;
+  bool subscribed_[BLE_CHANNEL_COUNT] = {};
+  std::mt19937 rng_;
+  uint64_t nextEventUs_ = 0;
+  uint32_t eventCounter_ = 0;
+  uint16_t intervalUnits_ = 24;
+  uint16_t latency_ = 0;
+  bool pendingUpdate_ = false;
+  uint32_t updateAtEvent_ = 0;
+  uint16_t requestedInterval_ = 0, requestedLatency_ = 0, requestedTimeout_ = 0;
+};
+
+inline Link links[BLE_MAX_CLIENTS];
+inline Link &link = links[0];  // Single-client benchmarks
+
+inline uint8_t Link::client() const { return (uint8_t)(this - links); }
+
+}  // namespace loopback
+
+// ===========================================
+// BLE TRANSPORT (loopback backend)
+// ===========================================
+
+void bleTransportInit() {}
+
+bool bleNotify(uint8_t client, uint8_t channel, const uint8_t* data, size_t length) {
+  return loopback::links[client].deviceNotify(channel, data, length);
+}
+
+void bleSetValue(uint8_t channel, const uint8_t* data, size_t length) {
+  loopback::values[channel].assign(data, data + length);
+}
+
+void bleStartAdvertising() {
+  loopback::advertising = true;
+}
+
+void bleStopAdvertising() {
+  loopback::advertising = false;
+}
+
+void bleSetBroadcastData(const uint8_t* data, size_t length) {
+  loopback::broadcastData.assign(data, data + length);
+}
+
+void bleDisconnect(uint8_t client) {
+  loopback::links[client].disconnect();
+}
+
+void bleUpdateConnParams(uint8_t client, uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+  loopback::links[client].deviceUpdateConnParams(minInterval, maxInterval, latency, timeout);
+}
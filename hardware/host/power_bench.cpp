@@ -0,0 +1,183 @@
+// ===========================================
+// StressView Power Benchmark (host)
+// ===========================================
+// Runs the real firmware (DeviceCode.cpp) on a PC and models the loop
+// task's duty cycle: each loop() pass is charged a fixed CPU cost plus the
+// I2C time of the sensor reads and display bytes it issued, and each wait
+// the firmware requests from the idle manager is slept on the simulated
+// clock until its deadline or an earlier wake (BLE event, notify complete).
+// For each scenario it reports:
+// - Wakes per second (sleeps ended) and loop() passes per second
+// - Awake time per second and duty cycle
+// - Estimated average CPU current from the constants below
+// - The firmware's own awake figure and worst late IR sample (Stats TLVs)
+// Power-off ends in deep sleep, so its row is the deep sleep current and
+// only checks that enterPowerOff() got there.
+//
+// The current estimate covers the ESP32-C3 core only: the radio, OLED and
+// sensors draw on top of it and are the same with or without idle sleep.
+//
+// Build and run from the repository root:
+//   g++ -std=gnu++17 -O2 -Ihardware/host/shim hardware/host/power_bench.cpp -o power_bench
+//   ./power_bench
+
+#include <Arduino.h>
+
+#define BLE_BACKEND BLE_BACKEND_LOOPBACK
+#include "../DeviceCode.cpp"
+#include "loopback_transport.h"
+
+using loopback::link;
+
+const uint32_t RUN_MS = 10000;           // Simulated time per scenario
+const uint32_t PASS_US = 120;            // CPU time of a loop() pass at 160 MHz
+const uint32_t WAKE_US = 250;            // Light sleep exit and clock restore
+const uint32_t IR_READ_US = 180;         // MAX30102 FIFO read at 400 kHz
+const uint32_t MOTION_READ_US = 350;     // MPU6050 14-byte burst at 400 kHz
+const uint32_t I2C_CLOCK_HZ = 1000000;   // Display bus clock (Wire.setClock)
+const double ACTIVE_MA = 20.0;           // Core running at 160 MHz
+const double SLEEP_MA = 0.13;            // Automatic light sleep
+const double DEEP_SLEEP_MA = 0.005;      // Deep sleep, GPIO wake armed
+
+struct PowerResult {
+  const char* name;
+  uint32_t passes;
+  uint32_t wakes;
+  uint64_t awakeUs;
+  uint64_t sleptUs;
+};
+
+PowerResult* current = nullptr;
+uint32_t lastIrReads, lastMotionReads, lastBusBytes, lastTransactions;
+
+void stepLinks() {
+  for (loopback::Link &l : loopback::links) l.step();
+}
+
+/**
+ * Charge the pass that just ran: fixed CPU cost plus the bus time of what
+ * it read and wrote, then run any connection events that fell inside it.
+ */
+void chargePass() {
+  uint32_t busBytes = (Wire.bytesWritten - lastBusBytes) + (Wire.transactions - lastTransactions);
+  uint64_t cost = PASS_US
+                + (uint64_t)(host::irReads - lastIrReads) * IR_READ_US
+                + (uint64_t)(host::motionReads - lastMotionReads) * MOTION_READ_US
+                + (uint64_t)busBytes * 9 * 1000000 / I2C_CLOCK_HZ;
+  lastIrReads = host::irReads;
+  lastMotionReads = host::motionReads;
+  lastBusBytes = Wire.bytesWritten;
+  lastTransactions = Wire.transactions;
+
+  host::nowUs += cost;
+  if (current) current->awakeUs += cost;
+  stepLinks();
+}
+
+/**
+ * Idle hook for ulTaskNotifyTake(): sleep until the requested deadline or
+ * until a connection event wakes the loop task.
+ */
+void sleepUntilWoken(uint32_t ms) {
+  uint64_t start = host::nowUs;
+  uint64_t end = start + (uint64_t)ms * 1000;
+  while (host::nowUs < end && !host::loopNotified) {
+    host::nowUs += std::min<uint64_t>(1000, end - host::nowUs);
+    stepLinks();
+  }
+  host::nowUs += WAKE_US;
+  if (current) {
+    current->sleptUs += host::nowUs - start - WAKE_US;
+    current->awakeUs += WAKE_US;
+    current->wakes++;
+  }
+}
+
+void run(uint32_t ms) {
+  uint64_t endUs = host::nowUs + (uint64_t)ms * 1000;
+  while (host::nowUs < endUs) {
+    loop();
+    chargePass();
+    if (current) current->passes++;
+  }
+}
+
+void measure(PowerResult& result) {
+  irSampleLateMaxMs = 0;
+  current = &result;
+  run(RUN_MS);
+  current = nullptr;
+
+  double seconds = RUN_MS / 1000.0;
+  double total = (double)(result.awakeUs + result.sleptUs);
+  double duty = total > 0 ? result.awakeUs / total : 1.0;
+  printf("%-22s %7.1f %8.1f %9.1f %6.1f %7.2f %9.1f %8u\n",
+         result.name, result.wakes / seconds, result.passes / seconds,
+         result.awakeUs / 1000.0 / seconds, duty * 100,
+         duty * ACTIVE_MA + (1 - duty) * SLEEP_MA,
+         awakePermille / 10.0, irSampleLateMaxMs);
+}
+
+/**
+ * Put the display on a screen and treat it as just touched, so the
+ * scenario runs before the dim timeout.
+ */
+void showScreen(State state) {
+  currentState = state;
+  setDisplayPower(DISPLAY_ON);
+  lastDisplayActivity = millis();
+  renderRequested = true;
+}
+
+int main() {
+  host::resetPins();
+  setup();
+  host::idleHook = sleepUntilWoken;
+  run(6000);  // Past calibration
+
+  printf("%-22s %7s %8s %9s %6s %7s %9s %8s\n",
+         "scenario", "wakes/s", "passes/s", "awake ms", "duty%", "est mA", "fw awake%", "IR late");
+
+  PowerResult displayOff = {"display off"};
+  setDisplayPower(DISPLAY_BLANK);
+  run(1000);
+  measure(displayOff);
+
+  PowerResult dashboard = {"dashboard"};
+  showScreen(DASHBOARD);
+  run(1000);
+  measure(dashboard);
+
+  PowerResult breathe = {"breathe"};
+  showScreen(BREATHE);
+  run(1000);
+  measure(breathe);
+
+  PowerResult live = {"connected, TLV 10 Hz"};
+  currentState = DASHBOARD;
+  setDisplayPower(DISPLAY_BLANK);
+  link.config = loopback::LinkConfig();
+  link.connect();
+  link.subscribe(BLE_CHANNEL_LIVE, true);
+  link.write(BLE_CHANNEL_COMMAND, {0x03, LIVE_MODE_TLV, 10});
+  run(3000);
+  measure(live);
+  link.disconnect();
+  run(1000);
+
+  // enterPowerOff() returns on the host after starting deep sleep; the
+  // firmware never runs loop() again, so nothing further is measured
+  currentState = INFO;
+  enterPowerOff();
+  if (host::deepSleepStarts > 0) {
+    printf("%-22s %7.1f %8.1f %9.1f %6.1f %7.3f %9s %8s\n",
+           "off, deep sleep", 0.0, 0.0, 0.0, 0.0, DEEP_SLEEP_MA, "-", "-");
+  } else {
+    printf("power-off did not enter deep sleep\n");
+  }
+
+  printf("\nmodel: pass %u us, wake %u us, IR read %u us, motion read %u us, display bus %u Hz; "
+         "%.1f mA awake, %.2f mA asleep, %.3f mA deep sleep (a loop that never blocks: %.1f mA)\n",
+         PASS_US, WAKE_US, IR_READ_US, MOTION_READ_US, I2C_CLOCK_HZ, ACTIVE_MA, SLEEP_MA, DEEP_SLEEP_MA, ACTIVE_MA);
+  return 0;
+}
@@ -0,0 +1,200 @@
+// ===========================================
+// Host Arduino Shim
+// ===========================================
+// Just enough of the ESP32 Arduino core to compile DeviceCode.cpp on a PC.
+// Time is simulated: millis()/micros() read host::nowUs, which the host
+// program advances explicitly (delay() advances it too). Sensor inputs are
+// synthetic and can be overridden through the host:: hooks.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define ADC_11db 3
+#define DEC 10
+#define HEX 16
+#define ONLOW 4
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+
+namespace host {
+  inline uint64_t nowUs = 0;              // Simulated time since boot
+  inline bool serialEcho = false;         // Print Serial output to stdout
+  inline int pinLevel[32];                // digitalRead() results (0 = LOW)
+  inline int analogValue[32];             // analogRead() results
+  inline int pwmValue[32];                // Last analogWrite() duty per pin
+
+  // Pins read HIGH (buttons released, pull-ups) until a test says otherwise
+  inline void resetPins() {
+    for (int i = 0; i < 32; i++) {
+      pinLevel[i] = HIGH;
+      analogValue[i] = 1800;
+      pwmValue[i] = 0;
+    }
+  }
+
+  inline void advanceMs(unsigned long ms) { nowUs += (uint64_t)ms * 1000; }
+
+  // The loop task's notification. Without an idleHook, ulTaskNotifyTake()
+  // returns at once and the host program advances time itself; a hook
+  // receives the requested wait in ms and models the sleep.
+  inline bool loopNotified = false;
+  inline void (*idleHook)(uint32_t ms) = nullptr;
+}
+
+inline unsigned long millis() { return (unsigned long)(host::nowUs / 1000); }
+inline unsigned long micros() { return (unsigned long)host::nowUs; }
+inline void delay(unsigned long ms) { host::advanceMs(ms); }
+inline void delayMicroseconds(unsigned int us) { host::nowUs += us; }
+
+inline int analogRead(int pin) { return host::analogValue[pin & 31]; }
+inline void analogWrite(int pin, int value) { host::pwmValue[pin & 31] = value; }
+inline int digitalRead(int pin) { return host::pinLevel[pin & 31]; }
+inline void digitalWrite(int pin, int value) { host::pinLevel[pin & 31] = value; }
+inline void pinMode(int, int) {}
+inline void analogSetAttenuation(int) {}
+
+inline int digitalPinToInterrupt(int pin) { return pin; }
+inline void attachInterrupt(int, void (*)(), int) {}
+
+// FreeRTOS task notifications for the single loop task
+typedef void* TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define portYIELD_FROM_ISR(...) ((void)0)
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle() { return &host::loopNotified; }
+inline void xTaskNotifyGive(TaskHandle_t) { host::loopNotified = true; }
+inline void vTaskNotifyGiveFromISR(TaskHandle_t, BaseType_t* woken) {
+  host::loopNotified = true;
+  if (woken) *woken = pdTRUE;
+}
+inline uint32_t ulTaskNotifyTake(BaseType_t, TickType_t ticks) {
+  if (!host::loopNotified && host::idleHook) host::idleHook(ticks);
+  uint32_t value = host::loopNotified ? 1 : 0;
+  host::loopNotified = false;
+  return value;
+}
+
+inline long random(long maxValue) { return maxValue > 0 ? rand() % maxValue : 0; }
+inline long random(long minValue, long maxValue) { return minValue + random(maxValue - minValue); }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+template<class T, class L, class H>
+auto constrain(T x, L low, H high) -> decltype(x + low + high) {
+  return x < low ? low : (x > high ? high : x);
+}
+template<class A, class B>
+auto min(A a, B b) -> decltype(a + b) { return a < b ? a : b; }
+template<class A, class B>
+auto max(A a, B b) -> decltype(a + b) { return a > b ? a : b; }
+
+class String {
+ public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string &s) : s_(s) {}
+  String(int v) : s_(std::to_string(v)) {}
+  String(unsigned v) : s_(std::to_string(v)) {}
+  String(long v) : s_(std::to_string(v)) {}
+  String(unsigned long v) : s_(std::to_string(v)) {}
+  size_t length() const { return s_.size(); }
+  char operator[](size_t i) const { return s_[i]; }
+  const char* c_str() const { return s_.c_str(); }
+  String operator+(const String &o) const { return String(s_ + o.s_); }
+  friend String operator+(const char* a, const String &b) { return String(std::string(a) + b.s_); }
+ private:
+  std::string s_;
+};
+
+/**
+ * Arduino Print: formats like the real core and forwards bytes to write().
+ */
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length; i++) write(data[i]);
+    return length;
+  }
+
+  size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+  size_t print(const String &s) { return print(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC) { return printFormat(base == HEX ? "%lX" : "%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return printFormat(base == HEX ? "%lX" : "%lu", v); }
+  size_t print(double v, int digits = 2) { return printFormat("%.*f", digits, v); }
+
+  size_t println() { return print("\r\n"); }
+  template<class T> size_t println(T v) { size_t n = print(v); return n + println(); }
+  template<class T> size_t println(T v, int arg) { size_t n = print(v, arg); return n + println(); }
+
+  size_t printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    return print(buffer);
+  }
+
+ private:
+  template<class... Args>
+  size_t printFormat(const char* format, Args... args) {
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), format, args...);
+    return print(buffer);
+  }
+};
+
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  void flush() { fflush(stdout); }
+  operator bool() { return true; }
+  using Print::write;
+  size_t write(uint8_t c) override {
+    if (host::serialEcho) fputc(c, stdout);
+    return 1;
+  }
+};
+
+inline HardwareSerial Serial;
+
+// Heap and flash figures are meaningless on the host; report a fixed heap
+// so footprint deltas print as zero
+class EspClass {
+ public:
+  uint32_t getFreeHeap() { return 320 * 1024; }
+  uint32_t getMinFreeHeap() { return 320 * 1024; }
+  uint32_t getHeapSize() { return 320 * 1024; }
+  uint32_t getSketchSize() { return 0; }
+  uint32_t getFreeSketchSpace() { return 0; }
+};
+
+inline EspClass ESP;
@@ -0,0 +1,37 @@
+// Host shim: MAX30102 pulse sensor. getIR() returns a synthetic PPG trace
+// (sharp systolic rise, slow decay) at host::heartRateBpm.
+
+#pragma once
+
+#include "Wire.h"
+
+#define I2C_SPEED_STANDARD 100000
+#define I2C_SPEED_FAST 400000
+
+namespace host {
+  inline float heartRateBpm = 72.0;
+  inline bool fingerPresent = true;
+  inline uint32_t irReads = 0;          // getIR() calls (I2C FIFO reads)
+}
+
+class MAX30105 {
+ public:
+  bool begin(TwoWire &wire, uint32_t speed = I2C_SPEED_STANDARD, uint8_t address = 0x57) { return true; }
+  void setup(byte powerLevel = 0x1F, byte sampleAverage = 4, byte ledMode = 3,
+             int sampleRate = 400, int pulseWidth = 411, int adcRange = 4096) {}
+  void setPulseAmplitudeRed(uint8_t) {}
+  void setPulseAmplitudeGreen(uint8_t) {}
+  void shutDown() { awake_ = false; }
+  void wakeUp() { awake_ = true; }
+
+  uint32_t getIR() {
+    host::irReads++;
+    if (!awake_ || !host::fingerPresent) return 1000;
+    double phase = fmod(host::nowUs / 1e6 * host::heartRateBpm / 60.0, 1.0);
+    double pulse = phase < 0.15 ? phase / 0.15 : exp(-(phase - 0.15) * 4.0);
+    return (uint32_t)(50000 + 3000 * pulse);
+  }
+
+ private:
+  bool awake_ = true;
+};
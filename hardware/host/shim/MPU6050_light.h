@@ -0,0 +1,34 @@
+// Host shim: MPU6050 accelerometer. Reports gravity plus optional
+// sinusoidal arm movement so activity classification can be exercised.
+
+#pragma once
+
+#include "Wire.h"
+
+namespace host {
+  inline float motionAmplitude = 0.0;  // Peak acceleration swing in g
+  inline float motionHz = 1.5;         // Swing frequency
+  inline uint32_t motionReads = 0;     // update() calls (I2C register reads)
+}
+
+class MPU6050 {
+ public:
+  MPU6050(TwoWire &wire) {}
+  void setAddress(uint8_t) {}
+  byte begin(int gyroConfig = 1, int accConfig = 0) { return 0; }
+  void calcOffsets(bool gyro = true, bool acc = true) {}
+  void update() {
+    host::motionReads++;
+    float t = host::nowUs / 1e6;
+    swing_ = host::motionAmplitude * sin(2 * M_PI * host::motionHz * t);
+  }
+  float getAccX() { return swing_; }
+  float getAccY() { return 0.0; }
+  float getAccZ() { return 1.0; }
+  float getGyroX() { return 0.0; }
+  float getGyroY() { return 0.0; }
+  float getGyroZ() { return 0.0; }
+
+ private:
+  float swing_ = 0.0;
+};
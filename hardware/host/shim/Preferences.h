@@ -0,0 +1,71 @@
+// Host shim: NVS key/value store kept in memory for the life of the process.
+// host::nvs survives Preferences::end(), so a test can "reboot" by calling
+// setup() again and see what the firmware persisted.
+
+#pragma once
+
+#include "Arduino.h"
+#include <map>
+#include <vector>
+
+namespace host {
+  inline std::map<std::string, std::vector<uint8_t>> nvs;
+}
+
+class Preferences {
+ public:
+  bool begin(const char* name, bool readOnly = false) { prefix_ = std::string(name) + "/"; return true; }
+  void end() {}
+  bool clear() {
+    for (auto it = host::nvs.begin(); it != host::nvs.end();) {
+      it = (it->first.compare(0, prefix_.size(), prefix_) == 0) ? host::nvs.erase(it) : std::next(it);
+    }
+    return true;
+  }
+  bool remove(const char* key) { return host::nvs.erase(prefix_ + key) > 0; }
+  bool isKey(const char* key) { return host::nvs.count(prefix_ + key) > 0; }
+
+  size_t putUChar(const char* key, uint8_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint8_t getUChar(const char* key, uint8_t d = 0) { return get(key, d); }
+  size_t putUShort(const char* key, uint16_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint16_t getUShort(const char* key, uint16_t d = 0) { return get(key, d); }
+  size_t putUInt(const char* key, uint32_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint32_t getUInt(const char* key, uint32_t d = 0) { return get(key, d); }
+  size_t putInt(const char* key, int32_t v) { return putBytes(key, &v, sizeof(v)); }
+  int32_t getInt(const char* key, int32_t d = 0) { return get(key, d); }
+  size_t putULong64(const char* key, uint64_t v) { return putBytes(key, &v, sizeof(v)); }
+  uint64_t getULong64(const char* key, uint64_t d = 0) { return get(key, d); }
+  size_t putLong64(const char* key, int64_t v) { return putBytes(key, &v, sizeof(v)); }
+  int64_t getLong64(const char* key, int64_t d = 0) { return get(key, d); }
+  size_t putFloat(const char* key, float v) { return putBytes(key, &v, sizeof(v)); }
+  float getFloat(const char* key, float d = 0) { return get(key, d); }
+  size_t putBool(const char* key, bool v) { return putBytes(key, &v, sizeof(v)); }
+  bool getBool(const char* key, bool d = false) { return get(key, d); }
+
+  size_t putBytes(const char* key, const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    host::nvs[prefix_ + key].assign(bytes, bytes + length);
+    writes++;
+    return length;
+  }
+  size_t getBytes(const char* key, void* data, size_t maxLength) {
+    auto it = host::nvs.find(prefix_ + key);
+    if (it == host::nvs.end()) return 0;
+    size_t length = std::min(maxLength, it->second.size());
+    memcpy(data, it->second.data(), length);
+    return length;
+  }
+  size_t getBytesLength(const char* key) {
+    auto it = host::nvs.find(prefix_ + key);
+    return it == host::nvs.end() ? 0 : it->second.size();
+  }
+
+  uint32_t writes = 0;  // Flash write count, for wear comparisons
+
+ private:
+  template<class T> T get(const char* key, T fallback) {
+    T value;
+    return getBytes(key, &value, sizeof(value)) == sizeof(value) ? value : fallback;
+  }
+  std::string prefix_;
+};
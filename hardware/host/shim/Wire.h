@@ -0,0 +1,132 @@
+// Host shim: I2C bus. Sensor shims are self-contained; the only device on
+// the bus is a model of the SSD1306 OLED at 0x3C, which executes the
+// command and data streams the firmware sends into its own display RAM.
+// Writes are counted so display flush cost can be measured.
+
+#pragma once
+
+#include "Arduino.h"
+
+namespace host {
+
+/**
+ * SSD1306 128x64 panel model: display RAM, horizontal addressing with
+ * column/page windows, on/off and contrast. Unknown commands are skipped
+ * with the right number of argument bytes so the stream stays in sync.
+ */
+class Ssd1306Panel {
+ public:
+  static const uint8_t ADDRESS = 0x3C;
+  static const uint8_t WIDTH = 128;
+  static const uint8_t PAGES = 8;
+
+  uint8_t ram[PAGES][WIDTH] = {};
+  bool on = false;
+  uint8_t contrast = 0x7F;
+
+  uint32_t commandBytes = 0;
+  uint32_t dataBytes = 0;
+
+  bool pixel(int x, int y) const { return (ram[y / 8][x] >> (y % 8)) & 1; }
+
+  /**
+   * Execute one I2C write addressed to the panel.
+   */
+  void receive(const uint8_t* bytes, size_t length) {
+    if (length == 0) return;
+    if (bytes[0] == 0x40) {
+      for (size_t i = 1; i < length; i++) writeData(bytes[i]);
+      dataBytes += length - 1;
+    } else if (bytes[0] == 0x00) {
+      for (size_t i = 1; i < length; i++) writeCommand(bytes[i]);
+      commandBytes += length - 1;
+    }
+  }
+
+ private:
+  uint8_t command_ = 0;
+  uint8_t argsLeft_ = 0;
+  uint8_t args_[2] = {};
+  uint8_t argCount_ = 0;
+  uint8_t columnStart_ = 0, columnEnd_ = WIDTH - 1, column_ = 0;
+  uint8_t pageStart_ = 0, pageEnd_ = PAGES - 1, page_ = 0;
+
+  void writeData(uint8_t b) {
+    ram[page_][column_] = b;
+    if (column_ < columnEnd_) {
+      column_++;
+      return;
+    }
+    column_ = columnStart_;
+    page_ = (page_ < pageEnd_) ? page_ + 1 : pageStart_;
+  }
+
+  void writeCommand(uint8_t b) {
+    if (argsLeft_ > 0) {
+      args_[argCount_++] = b;
+      if (--argsLeft_ == 0) finishCommand();
+      return;
+    }
+    command_ = b;
+    argCount_ = 0;
+    switch (b) {
+      case 0x21: case 0x22: argsLeft_ = 2; break;           // Column / page address
+      case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+      case 0xD5: case 0xD9: case 0xDA: case 0xDB: argsLeft_ = 1; break;
+      case 0xAE: on = false; break;
+      case 0xAF: on = true; break;
+      default: break;
+    }
+  }
+
+  void finishCommand() {
+    switch (command_) {
+      case 0x21:
+        columnStart_ = column_ = args_[0] & 0x7F;
+        columnEnd_ = args_[1] & 0x7F;
+        break;
+      case 0x22:
+        pageStart_ = page_ = args_[0] & 0x07;
+        pageEnd_ = args_[1] & 0x07;
+        break;
+      case 0x81:
+        contrast = args_[0];
+        break;
+    }
+  }
+};
+
+inline Ssd1306Panel panel;
+
+}  // namespace host
+
+class TwoWire {
+ public:
+  bool begin(int sda = -1, int scl = -1) { return true; }
+  void setClock(uint32_t) {}
+  void beginTransmission(uint8_t address) {
+    address_ = address;
+    length_ = 0;
+    transactions++;
+  }
+  size_t write(uint8_t b) { return write(&b, 1); }
+  size_t write(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && length_ < sizeof(buffer_); i++) buffer_[length_++] = data[i];
+    bytesWritten += length;
+    return length;
+  }
+  uint8_t endTransmission(bool = true) {
+    if (address_ == host::Ssd1306Panel::ADDRESS) host::panel.receive(buffer_, length_);
+    return 0;
+  }
+
+  uint32_t transactions = 0;
+  uint32_t bytesWritten = 0;
+
+ private:
+  uint8_t address_ = 0;
+  uint8_t buffer_[128];     // Arduino-ESP32 Wire buffer size
+  size_t length_ = 0;
+};
+
+inline TwoWire Wire;
@@ -0,0 +1,13 @@
+// Host shim: GPIO wakeup configuration.
+
+#pragma once
+
+#include "../esp_pm.h"
+
+typedef int gpio_num_t;
+#define GPIO_INTR_LOW_LEVEL 4
+#define GPIO_INTR_HIGH_LEVEL 5
+
+inline esp_err_t gpio_wakeup_enable(gpio_num_t, int) { return ESP_OK; }
+inline esp_err_t gpio_pullup_en(gpio_num_t) { return ESP_OK; }
+inline esp_err_t gpio_pulldown_dis(gpio_num_t) { return ESP_OK; }
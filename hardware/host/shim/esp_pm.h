@@ -0,0 +1,19 @@
+// Host shim: power management. Accepts the configuration and reports
+// success; sleep itself is modeled by host::idleHook (Arduino.h).
+
+#pragma once
+
+#include "Arduino.h"
+
+#define ESP_IDF_VERSION_MAJOR 5
+
+typedef int esp_err_t;
+#define ESP_OK 0
+
+typedef struct {
+  int max_freq_mhz;
+  int min_freq_mhz;
+  bool light_sleep_enable;
+} esp_pm_config_t;
+
+inline esp_err_t esp_pm_configure(const void*) { return ESP_OK; }
@@ -0,0 +1,30 @@
+// Host shim: sleep wakeup sources. esp_deep_sleep_start() returns on the
+// host; it records that the firmware powered off so a bench can stop there.
+
+#pragma once
+
+#include "esp_pm.h"
+
+typedef enum {
+  ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+  ESP_SLEEP_WAKEUP_GPIO = 7,
+} esp_sleep_wakeup_cause_t;
+
+typedef enum {
+  ESP_GPIO_WAKEUP_GPIO_LOW = 0,
+  ESP_GPIO_WAKEUP_GPIO_HIGH = 1,
+} esp_deepsleep_gpio_wake_up_mode_t;
+
+namespace host {
+  inline esp_sleep_wakeup_cause_t wakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+  inline uint64_t deepSleepWakeMask = 0;   // Pins armed for deep sleep wake
+  inline uint32_t deepSleepStarts = 0;
+}
+
+inline esp_err_t esp_sleep_enable_gpio_wakeup() { return ESP_OK; }
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() { return host::wakeupCause; }
+inline esp_err_t esp_deep_sleep_enable_gpio_wakeup(uint64_t mask, esp_deepsleep_gpio_wake_up_mode_t) {
+  host::deepSleepWakeMask = mask;
+  return ESP_OK;
+}
+inline void esp_deep_sleep_start() { host::deepSleepStarts++; }
@@ -0,0 +1,7 @@
+// Host shim: esp_timer reads the simulated clock.
+
+#pragma once
+
+#include "Arduino.h"
+
+inline int64_t esp_timer_get_time() { return (int64_t)host::nowUs; }